@@ -0,0 +1,35 @@
+#ifndef DS_ONNX_INFER_AUDIOBUFFER_H
+#define DS_ONNX_INFER_AUDIOBUFFER_H
+
+#include <cstddef>
+#include <memory>
+
+#include <dsonnxinfer/dsonnxinfer_global.h>
+
+DSONNXINFER_BEGIN_NAMESPACE
+
+/**
+ * @brief Mono float audio in memory.
+ *
+ * The samples are owned by `storage`, which is the output buffer of the inference
+ * itself, so no copy is made. The buffer is immutable and can be shared by copying.
+ */
+struct AudioBuffer {
+    const float *samples = nullptr;
+    size_t sampleCount = 0;
+    int sampleRate = 0;
+    // Start time in seconds, i.e. the offset of the segment.
+    double offset = 0.0;
+
+    std::shared_ptr<const void> storage;
+
+    inline bool empty() const;
+};
+
+bool AudioBuffer::empty() const {
+    return sampleCount == 0;
+}
+
+DSONNXINFER_END_NAMESPACE
+
+#endif // DS_ONNX_INFER_AUDIOBUFFER_H
@@ -0,0 +1,330 @@
+#include "AudioSink.h"
+
+#include <algorithm>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <utility>
+
+#ifdef DSONNXINFER_ENABLE_AUDIO_EXPORT
+#include <sndfile.hh>
+#endif
+
+DSONNXINFER_BEGIN_NAMESPACE
+
+AudioSink::AudioSink() = default;
+
+AudioSink::~AudioSink() = default;
+
+bool AudioSink::write(std::vector<float> &&samples, Status *status) {
+    return write(samples.data(), samples.size(), status);
+}
+
+class AudioFileSink::Impl {
+public:
+    ~Impl() {
+        close(nullptr);
+    }
+
+    bool open(const std::filesystem::path &path, int sampleRate_, const AudioSinkOptions &options, Status *status) {
+        close(nullptr);
+        if (sampleRate_ <= 0) {
+            putStatus(status, Status_GenericError, "Invalid sample rate");
+            return false;
+        }
+        // Written to a temporary file, which replaces the target only when complete
+        partialPath = path;
+        partialPath += ".partial" + std::to_string(std::random_device{}());
+        if (options.fileFormat == AF_Raw) {
+            rawFile.open(partialPath, std::ios::binary | std::ios::trunc);
+            if (!rawFile.is_open()) {
+                putStatus(status, Status_GenericError, "Failed to open audio file: " + path.string());
+                return false;
+            }
+        } else {
+#ifdef DSONNXINFER_ENABLE_AUDIO_EXPORT
+            int format = options.fileFormat == AF_Flac ? SF_FORMAT_FLAC : SF_FORMAT_WAV;
+            switch (options.sampleFormat) {
+                case AS_Int16:
+                    format |= SF_FORMAT_PCM_16;
+                    break;
+                case AS_Int24:
+                    format |= SF_FORMAT_PCM_24;
+                    break;
+                case AS_Float:
+                    if (options.fileFormat == AF_Flac) {
+                        putStatus(status, Status_GenericError, "FLAC does not support float samples");
+                        return false;
+                    }
+                    format |= SF_FORMAT_FLOAT;
+                    break;
+            }
+            const auto filePath =
+#ifdef _WIN32
+                partialPath.wstring();
+#else
+                partialPath.string();
+#endif
+            sndfile = SndfileHandle(filePath.c_str(), SFM_WRITE, format, 1, sampleRate_);
+            if (!sndfile || sndfile.error() != 0) {
+                putStatus(status, Status_GenericError,
+                          "Failed to open audio file: " + path.string() + " (" + sndfile.strError() + ")");
+                sndfile = {};
+                removePartial();
+                return false;
+            }
+            // Clip instead of wrapping around when converting out-of-range floats to integers.
+            sndfile.command(SFC_SET_CLIPPING, nullptr, SF_TRUE);
+#else
+            putStatus(status, Status_GenericError, "DS Onnx Infer is not built with audio export support.");
+            return false;
+#endif
+        }
+
+        targetPath = path;
+        sampleRate = sampleRate_;
+        fileFormat = options.fileFormat;
+        sampleFormat = options.sampleFormat;
+        opened = true;
+        failed = false;
+        errorMessage.clear();
+
+        if (options.backgroundWriter) {
+            queueCapacity = (std::max)(options.queueCapacity, size_t{1});
+            stopping = false;
+            worker = std::thread([this] { run(); });
+        }
+        putStatusOk(status);
+        return true;
+    }
+
+    bool write(std::vector<float> &&samples, const float *data, size_t count, Status *status) {
+        if (!opened) {
+            putStatus(status, Status_GenericError, "Audio sink is not open");
+            return false;
+        }
+        if (!worker.joinable()) {
+            if (!writeDirect(data, count)) {
+                failed = true;
+                putStatus(status, Status_GenericError, errorMessage);
+                return false;
+            }
+            putStatusOk(status);
+            return true;
+        }
+
+        std::unique_lock<std::mutex> lock(mutex);
+        notFull.wait(lock, [this] { return queue.size() < queueCapacity || failed; });
+        if (failed) {
+            putStatus(status, Status_GenericError, errorMessage);
+            return false;
+        }
+        if (samples.empty() && count > 0) {
+            samples.assign(data, data + count);
+        }
+        queue.push_back(std::move(samples));
+        lock.unlock();
+        notEmpty.notify_one();
+        putStatusOk(status);
+        return true;
+    }
+
+    // Replaces the target with the written file if `commit` is set and all writes
+    // succeeded, and removes the written file otherwise.
+    bool close(Status *status, bool commit = true) {
+        if (!opened) {
+            putStatusOk(status);
+            return true;
+        }
+        if (worker.joinable()) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stopping = true;
+            }
+            notEmpty.notify_one();
+            worker.join();
+            queue.clear();
+        }
+        if (rawFile.is_open()) {
+            rawFile.close();
+            if (!rawFile && !failed) {
+                failed = true;
+                errorMessage = "Failed to write audio file";
+            }
+        }
+#ifdef DSONNXINFER_ENABLE_AUDIO_EXPORT
+        // Releasing the handle finalizes the header.
+        sndfile = {};
+#endif
+        opened = false;
+        if (failed || !commit) {
+            removePartial();
+            if (failed) {
+                putStatus(status, Status_GenericError, errorMessage);
+                return false;
+            }
+            putStatusOk(status);
+            return true;
+        }
+        std::error_code ec;
+        std::filesystem::rename(partialPath, targetPath, ec);
+        if (ec) {
+            removePartial();
+            putStatus(status, Status_GenericError,
+                      "Failed to replace audio file: " + targetPath.string() + " (" + ec.message() + ")");
+            return false;
+        }
+        putStatusOk(status);
+        return true;
+    }
+
+    void removePartial() {
+        std::error_code ec;
+        std::filesystem::remove(partialPath, ec);
+    }
+
+    void run() {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            notEmpty.wait(lock, [this] { return !queue.empty() || stopping; });
+            if (queue.empty()) {
+                break;
+            }
+            auto chunk = std::move(queue.front());
+            queue.pop_front();
+            const bool skip = failed;
+            lock.unlock();
+            notFull.notify_one();
+
+            const bool ok = skip || writeDirect(chunk.data(), chunk.size());
+
+            lock.lock();
+            if (!ok) {
+                // Writes after a failure are dropped; the error is reported by write() and close().
+                failed = true;
+                notFull.notify_all();
+            }
+        }
+    }
+
+    // Called on the writer thread, or on the calling thread without the background writer.
+    bool writeDirect(const float *data, size_t count) {
+        if (count == 0) {
+            return true;
+        }
+        if (fileFormat == AF_Raw) {
+            encodeRaw(data, count);
+            rawFile.write(convertBuffer.data(), static_cast<std::streamsize>(convertBuffer.size()));
+            if (!rawFile) {
+                errorMessage = "Failed to write audio file";
+                return false;
+            }
+            return true;
+        }
+#ifdef DSONNXINFER_ENABLE_AUDIO_EXPORT
+        auto numFrames = static_cast<sf_count_t>(count);
+        auto numWritten = sndfile.write(data, numFrames);
+        if (numWritten < numFrames) {
+            errorMessage = "Failed to write audio file";
+            return false;
+        }
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    void encodeRaw(const float *data, size_t count) {
+        const size_t sampleSize = sampleFormat == AS_Int16 ? 2 : sampleFormat == AS_Int24 ? 3 : 4;
+        convertBuffer.resize(count * sampleSize);
+        auto *out = reinterpret_cast<unsigned char *>(convertBuffer.data());
+        for (size_t i = 0; i < count; ++i) {
+            uint32_t value;
+            if (sampleFormat == AS_Float) {
+                std::memcpy(&value, &data[i], sizeof(value));
+            } else {
+                const float maxValue = sampleFormat == AS_Int16 ? 32767.0f : 8388607.0f;
+                const float clamped = (std::max)(-1.0f, (std::min)(1.0f, data[i]));
+                value = static_cast<uint32_t>(static_cast<int32_t>(std::lround(clamped * maxValue)));
+            }
+            for (size_t b = 0; b < sampleSize; ++b) {
+                *out++ = static_cast<unsigned char>(value >> (8 * b));
+            }
+        }
+    }
+
+    bool opened = false;
+    std::filesystem::path targetPath;
+    std::filesystem::path partialPath;
+    int sampleRate = 0;
+    AudioFileFormat fileFormat = AF_Wav;
+    AudioSampleFormat sampleFormat = AS_Float;
+
+#ifdef DSONNXINFER_ENABLE_AUDIO_EXPORT
+    SndfileHandle sndfile;
+#endif
+    std::ofstream rawFile;
+    std::vector<char> convertBuffer;
+
+    std::thread worker;
+    std::mutex mutex;
+    std::condition_variable notEmpty;
+    std::condition_variable notFull;
+    std::deque<std::vector<float>> queue;
+    size_t queueCapacity = 0;
+    bool stopping = false;
+    bool failed = false;
+    std::string errorMessage;
+};
+
+AudioFileSink::AudioFileSink() : _impl(std::make_unique<Impl>()) {
+}
+
+AudioFileSink::~AudioFileSink() = default;
+
+bool AudioFileSink::open(const std::filesystem::path &path, int sampleRate,
+                         const AudioSinkOptions &options, Status *status) {
+    auto &impl = *_impl;
+    return impl.open(path, sampleRate, options, status);
+}
+
+bool AudioFileSink::isOpen() const {
+    auto &impl = *_impl;
+    return impl.opened;
+}
+
+int AudioFileSink::sampleRate() const {
+    auto &impl = *_impl;
+    return impl.sampleRate;
+}
+
+bool AudioFileSink::write(const float *samples, size_t count, Status *status) {
+    auto &impl = *_impl;
+    return impl.write({}, samples, count, status);
+}
+
+bool AudioFileSink::write(std::vector<float> &&samples, Status *status) {
+    auto &impl = *_impl;
+    const float *data = samples.data();
+    const size_t count = samples.size();
+    return impl.write(std::move(samples), data, count, status);
+}
+
+bool AudioFileSink::close(Status *status) {
+    auto &impl = *_impl;
+    return impl.close(status);
+}
+
+void AudioFileSink::discard() {
+    auto &impl = *_impl;
+    impl.close(nullptr, false);
+}
+
+DSONNXINFER_END_NAMESPACE
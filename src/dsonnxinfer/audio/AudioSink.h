@@ -0,0 +1,102 @@
+#ifndef DS_ONNX_INFER_AUDIOSINK_H
+#define DS_ONNX_INFER_AUDIOSINK_H
+
+#include <cstddef>
+#include <filesystem>
+#include <memory>
+#include <vector>
+
+#include <dsonnxinfer/dsonnxinfer_global.h>
+#include <dsonnxinfer/Status.h>
+
+DSONNXINFER_BEGIN_NAMESPACE
+
+enum AudioFileFormat {
+    AF_Wav = 0,
+    AF_Flac,
+    AF_Raw,     // Headerless little-endian PCM
+};
+
+enum AudioSampleFormat {
+    AS_Int16 = 0,
+    AS_Int24,
+    AS_Float,
+};
+
+struct AudioSinkOptions {
+    AudioFileFormat fileFormat = AF_Wav;
+    AudioSampleFormat sampleFormat = AS_Float;
+
+    // Write on a background thread, so that inference does not wait for disk I/O.
+    bool backgroundWriter = false;
+    // Maximum number of chunks waiting to be written. write() blocks when the queue is full.
+    size_t queueCapacity = 16;
+};
+
+/**
+ * @brief Destination of mono float audio, written in one or more chunks.
+ */
+class DSONNXINFER_EXPORT AudioSink {
+public:
+    AudioSink();
+    virtual ~AudioSink();
+
+    DSONNXINFER_DISABLE_COPY_MOVE(AudioSink)
+
+public:
+    virtual int sampleRate() const = 0;
+
+    virtual bool write(const float *samples, size_t count, Status *status) = 0;
+
+    /**
+     * @brief Writes a chunk that the sink may keep without copying.
+     */
+    virtual bool write(std::vector<float> &&samples, Status *status);
+
+    /**
+     * @brief Writes all pending chunks and releases the destination.
+     */
+    virtual bool close(Status *status) = 0;
+};
+
+/**
+ * @brief Writes audio to a WAV, FLAC or raw PCM file.
+ *
+ * WAV and FLAC require the library to be built with audio export support. Raw PCM
+ * is always available. FLAC does not support float samples.
+ *
+ * When the background writer is enabled, errors are reported by the next write() or
+ * by close().
+ *
+ * Audio is written to a temporary file next to the target, which replaces the target
+ * when close() succeeds. After a failed write or discard(), the target is left as it was.
+ */
+class DSONNXINFER_EXPORT AudioFileSink : public AudioSink {
+public:
+    AudioFileSink();
+    ~AudioFileSink() override;
+
+public:
+    bool open(const std::filesystem::path &path, int sampleRate,
+              const AudioSinkOptions &options, Status *status);
+    bool isOpen() const;
+
+    int sampleRate() const override;
+
+    bool write(const float *samples, size_t count, Status *status) override;
+    bool write(std::vector<float> &&samples, Status *status) override;
+    bool close(Status *status) override;
+
+    /**
+     * @brief Stops writing and removes what was written, leaving the target untouched.
+     */
+    void discard();
+
+protected:
+    class Impl;
+    std::unique_ptr<Impl> _impl;
+};
+
+DSONNXINFER_END_NAMESPACE
+
+#endif // DS_ONNX_INFER_AUDIOSINK_H
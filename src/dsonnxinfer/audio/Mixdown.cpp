@@ -0,0 +1,261 @@
+#include "Mixdown.h"
+
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <dsonnxinfer/TaskPool.h>
+
+DSONNXINFER_BEGIN_NAMESPACE
+
+// Number of samples mixed by one task.
+constexpr int64_t kRegionSize = 65536;
+
+namespace {
+    // Attenuation of a segment by one segment it overlaps: the gain ramps down linearly
+    // over [downBegin, downEnd), is 0 until upBegin, and ramps back up over [upBegin, upEnd).
+    struct Dip {
+        int64_t downBegin;
+        int64_t downEnd;
+        int64_t upBegin;
+        int64_t upEnd;
+
+        double gain(int64_t t) const {
+            if (t < downBegin || t >= upEnd) {
+                return 1.0;
+            }
+            if (t < downEnd) {
+                return 1.0 - (static_cast<double>(t - downBegin) + 0.5) / static_cast<double>(downEnd - downBegin);
+            }
+            if (t < upBegin) {
+                return 0.0;
+            }
+            return (static_cast<double>(t - upBegin) + 0.5) / static_cast<double>(upEnd - upBegin);
+        }
+    };
+
+    struct PlacedSegment {
+        AudioBuffer waveform;
+        int64_t start;
+        int64_t end;
+        // Sorted by downBegin
+        std::vector<Dip> dips;
+
+        void addDip(const Dip &dip) {
+            auto it = std::upper_bound(dips.begin(), dips.end(), dip.downBegin,
+                                       [](int64_t value, const Dip &item) { return value < item.downBegin; });
+            dips.insert(it, dip);
+        }
+
+        float gain(int64_t t) const {
+            double g = 1.0;
+            for (const auto &dip : dips) {
+                if (dip.downBegin > t) {
+                    break;
+                }
+                g *= dip.gain(t);
+            }
+            return static_cast<float>(g);
+        }
+
+        void mixInto(int64_t begin, int64_t end_, float *out) const {
+            const int64_t from = (std::max)(begin, start);
+            const int64_t to = (std::min)(end_, end);
+            if (from >= to) {
+                return;
+            }
+            const float *src = waveform.samples - start;
+            float *dst = out - begin;
+            // Samples outside all dips are added as they are.
+            int64_t t = from;
+            for (const auto &dip : dips) {
+                if (dip.downBegin >= to) {
+                    break;
+                }
+                if (dip.upEnd <= t) {
+                    continue;
+                }
+                for (const int64_t flatEnd = (std::max)(t, dip.downBegin); t < flatEnd; ++t) {
+                    dst[t] += src[t];
+                }
+                for (const int64_t dipEnd = (std::min)(to, dip.upEnd); t < dipEnd; ++t) {
+                    dst[t] += gain(t) * src[t];
+                }
+            }
+            for (; t < to; ++t) {
+                dst[t] += src[t];
+            }
+        }
+    };
+}
+
+class Mixdown::Impl {
+public:
+    // Sets up the crossfade between two overlapping segments, where `prev` was placed
+    // first. Both keep their full gain outside the overlap.
+    void link(PlacedSegment &prev, PlacedSegment &next) const {
+        const int64_t overlapBegin = (std::max)(prev.start, next.start);
+        const int64_t overlapEnd = (std::min)(prev.end, next.end);
+        if (overlapEnd <= overlapBegin) {
+            return;
+        }
+        const int64_t overlap = overlapEnd - overlapBegin;
+        if (prev.end > next.end) {
+            // `next` lies within `prev`: fade to `next` at its start, and back to `prev` at its end.
+            const int64_t length = (std::min)(overlap / 2, crossfadeSamples);
+            prev.addDip({overlapBegin, overlapBegin + length, overlapEnd - length, overlapEnd});
+            next.addDip({next.start, next.start, overlapBegin, overlapBegin + length});
+            next.addDip({overlapEnd - length, overlapEnd, next.end, next.end});
+            return;
+        }
+        // `next` takes over in the middle of the overlap.
+        const int64_t length = (std::min)(overlap, crossfadeSamples);
+        const int64_t fadeBegin = overlapBegin + (overlap - length) / 2;
+        prev.addDip({fadeBegin, fadeBegin + length, prev.end, prev.end});
+        next.addDip({next.start, next.start, fadeBegin, fadeBegin + length});
+    }
+
+    void render(int64_t begin, size_t count, float *out) const {
+        std::fill(out, out + count, 0.0f);
+        const int64_t end = begin + static_cast<int64_t>(count);
+        for (const auto &segment : segments) {
+            if (segment.start >= end) {
+                break;
+            }
+            segment.mixInto(begin, end, out);
+        }
+    }
+
+    void renderParallel(int64_t begin, size_t count, float *out) const {
+        const size_t regionCount = (count + kRegionSize - 1) / kRegionSize;
+        TaskPool::global().parallelFor(regionCount, [&](size_t i) {
+            const size_t regionBegin = i * kRegionSize;
+            const size_t regionSize = (std::min)(static_cast<size_t>(kRegionSize), count - regionBegin);
+            render(begin + static_cast<int64_t>(regionBegin), regionSize, out + regionBegin);
+        });
+    }
+
+    int sampleRate;
+    int64_t crossfadeSamples;
+    int64_t length = 0;
+    int64_t flushed = 0;
+    // Sorted by start
+    std::deque<PlacedSegment> segments;
+};
+
+Mixdown::Mixdown(int sampleRate, double crossfade) : _impl(std::make_unique<Impl>()) {
+    auto &impl = *_impl;
+    impl.sampleRate = sampleRate;
+    impl.crossfadeSamples = (std::max)(int64_t{0}, static_cast<int64_t>(std::llround(crossfade * sampleRate)));
+}
+
+Mixdown::~Mixdown() = default;
+
+int Mixdown::sampleRate() const {
+    auto &impl = *_impl;
+    return impl.sampleRate;
+}
+
+bool Mixdown::addSegment(AudioBuffer waveform, Status *status) {
+    auto &impl = *_impl;
+    if (waveform.sampleRate != 0 && waveform.sampleRate != impl.sampleRate) {
+        putStatus(status, Status_GenericError,
+                  "Sample rate mismatch: expected " + std::to_string(impl.sampleRate) +
+                  ", got " + std::to_string(waveform.sampleRate));
+        return false;
+    }
+    const int64_t start = std::llround(waveform.offset * impl.sampleRate);
+    if (start < impl.flushed && impl.flushed > 0) {
+        putStatus(status, Status_GenericError, "Segment starts before the flushed part of the song");
+        return false;
+    }
+    if (waveform.empty()) {
+        putStatusOk(status);
+        return true;
+    }
+    const int64_t end = start + static_cast<int64_t>(waveform.sampleCount);
+
+    PlacedSegment segment{std::move(waveform), start, end, {}};
+    auto it = std::upper_bound(impl.segments.begin(), impl.segments.end(), start,
+                               [](int64_t value, const PlacedSegment &item) { return value < item.start; });
+    it = impl.segments.insert(it, std::move(segment));
+    // Crossfade with every segment it overlaps, not only the neighbors, since a long
+    // segment may overlap several others.
+    for (auto other = impl.segments.begin(); other != impl.segments.end() && other->start < end; ++other) {
+        if (other == it || other->end <= start) {
+            continue;
+        }
+        if (other < it) {
+            impl.link(*other, *it);
+        } else {
+            impl.link(*it, *other);
+        }
+    }
+    impl.length = (std::max)(impl.length, end);
+    putStatusOk(status);
+    return true;
+}
+
+int64_t Mixdown::sampleCount() const {
+    auto &impl = *_impl;
+    return impl.length;
+}
+
+void Mixdown::render(int64_t begin, size_t count, float *out) const {
+    auto &impl = *_impl;
+    impl.render(begin, count, out);
+}
+
+bool Mixdown::renderTo(float *buffer, size_t capacity, Status *status) const {
+    auto &impl = *_impl;
+    const auto count = static_cast<size_t>(impl.length);
+    if (capacity < count) {
+        putStatus(status, Status_GenericError,
+                  "Buffer too small: " + std::to_string(count) + " samples required");
+        return false;
+    }
+    impl.renderParallel(0, count, buffer);
+    putStatusOk(status);
+    return true;
+}
+
+bool Mixdown::flush(AudioSink &sink, bool final, Status *status) {
+    auto &impl = *_impl;
+    int64_t flushEnd = impl.flushed;
+    if (final) {
+        flushEnd = impl.length;
+    } else if (!impl.segments.empty()) {
+        // Segments added later start at or after the last one, so everything before it is final.
+        flushEnd = (std::max)(flushEnd, impl.segments.back().start);
+    }
+
+    // Mix one region per thread at a time, so that memory stays bounded.
+    const int64_t batchSize = kRegionSize * (TaskPool::global().threadCount() + 1);
+    while (impl.flushed < flushEnd) {
+        const auto count = static_cast<size_t>((std::min)(batchSize, flushEnd - impl.flushed));
+        std::vector<float> buffer(count);
+        impl.renderParallel(impl.flushed, count, buffer.data());
+        if (!sink.write(std::move(buffer), status)) {
+            return false;
+        }
+        impl.flushed += static_cast<int64_t>(count);
+    }
+
+    // Release the segments that are completely written.
+    const int64_t flushed = impl.flushed;
+    impl.segments.erase(std::remove_if(impl.segments.begin(), impl.segments.end(),
+                                       [flushed](const PlacedSegment &item) { return item.end <= flushed; }),
+                        impl.segments.end());
+    putStatusOk(status);
+    return true;
+}
+
+int64_t Mixdown::flushedCount() const {
+    auto &impl = *_impl;
+    return impl.flushed;
+}
+
+DSONNXINFER_END_NAMESPACE
@@ -0,0 +1,86 @@
+#ifndef DS_ONNX_INFER_MIXDOWN_H
+#define DS_ONNX_INFER_MIXDOWN_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include <dsonnxinfer/dsonnxinfer_global.h>
+#include <dsonnxinfer/Status.h>
+#include <dsonnxinfer/AudioBuffer.h>
+#include <dsonnxinfer/AudioSink.h>
+
+DSONNXINFER_BEGIN_NAMESPACE
+
+/**
+ * @brief Assembles segment waveforms into a song.
+ *
+ * Each waveform is placed at `offset * sampleRate`. Where two segments overlap, the
+ * one that starts later takes over with a linear crossfade in the middle of the
+ * overlapping region; if it ends before the other one, the other one fades back in
+ * at its end instead. Segments keep their full level outside their overlaps.
+ *
+ * The song can be rendered into a preallocated buffer, or streamed into a sink while
+ * segments are still being added: when segments are added in the order of their
+ * offsets, flush() writes everything before the start of the last added segment and
+ * releases the segments that are completely written, so memory stays bounded by the
+ * segments that are still audible.
+ *
+ * Rendering is split into regions that are mixed in parallel. The object itself is
+ * not thread-safe.
+ */
+class DSONNXINFER_EXPORT Mixdown {
+public:
+    /**
+     * @param sampleRate    The sample rate of the song. All waveforms must have this sample rate.
+     * @param crossfade     The maximum crossfade length in seconds.
+     */
+    explicit Mixdown(int sampleRate, double crossfade = 0.01);
+    ~Mixdown();
+
+    DSONNXINFER_DISABLE_COPY_MOVE(Mixdown)
+
+public:
+    int sampleRate() const;
+
+    /**
+     * @brief Adds a segment waveform. Fails if the waveform starts before the part of the
+     *        song that is already flushed.
+     */
+    bool addSegment(AudioBuffer waveform, Status *status);
+
+    /**
+     * @brief The length of the song in samples, i.e. the end of the last segment.
+     */
+    int64_t sampleCount() const;
+
+    /**
+     * @brief Mixes the samples `[begin, begin + count)` of the song into `out`.
+     *        Only segments that are not released yet contribute.
+     */
+    void render(int64_t begin, size_t count, float *out) const;
+
+    /**
+     * @brief Mixes the whole song into a buffer of at least sampleCount() samples.
+     */
+    bool renderTo(float *buffer, size_t capacity, Status *status) const;
+
+    /**
+     * @brief Writes the finished part of the song to the sink.
+     * @param final     Whether no more segments will be added. Writes the rest of the song.
+     */
+    bool flush(AudioSink &sink, bool final, Status *status);
+
+    /**
+     * @brief Number of samples already written by flush().
+     */
+    int64_t flushedCount() const;
+
+protected:
+    class Impl;
+    std::unique_ptr<Impl> _impl;
+};
+
+DSONNXINFER_END_NAMESPACE
+
+#endif // DS_ONNX_INFER_MIXDOWN_H
@@ -0,0 +1,572 @@
+#include "CurveKernels_p.h"
+
+#include <cmath>
+#include <initializer_list>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#  define DS_CURVE_X86
+#  include <immintrin.h>
+#  ifdef _MSC_VER
+#    include <intrin.h>
+#  endif
+#  if defined(_MSC_VER) && !defined(__clang__)
+#    define DS_CURVE_TARGET(features)
+#  else
+#    define DS_CURVE_TARGET(features) __attribute__((target(features)))
+#  endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#  define DS_CURVE_NEON
+#  include <arm_neon.h>
+#endif
+
+// Products are rounded before they are added in every variant, so that the results of
+// addScaled and accumulateScaled do not depend on the instruction set. Without this, the
+// compiler may fuse the scalar reference or the vector intrinsics into FMA instructions.
+#if defined(__clang__)
+#  pragma clang fp contract(off)
+#elif defined(__GNUC__)
+#  pragma GCC optimize("fp-contract=off")
+#endif
+
+DSONNXINFER_BEGIN_NAMESPACE
+
+namespace CurveKernels {
+
+    namespace {
+        // exp2 is evaluated as 2^n * p(f), with n the nearest integer and f in [-0.5, 0.5].
+        // p is the Taylor series of 2^f up to degree 9, with a relative error below 1e-11, so
+        // the result is within one float ulp of std::exp2 after rounding to float.
+        constexpr double kExp2Min = -1022.0;
+        constexpr double kExp2Max = 1023.0;
+        // Adding this rounds to an integer, which ends up in the low bits of the mantissa.
+        constexpr double kRoundShifter = 6755399441055744.0; // 1.5 * 2^52
+        constexpr double kExp2C0 = 1.0;
+        constexpr double kExp2C1 = 0.6931471805599453;
+        constexpr double kExp2C2 = 0.2402265069591007;
+        constexpr double kExp2C3 = 0.055504108664821576;
+        constexpr double kExp2C4 = 0.009618129107628477;
+        constexpr double kExp2C5 = 0.0013333558146428441;
+        constexpr double kExp2C6 = 0.00015403530393381606;
+        constexpr double kExp2C7 = 1.5252733804059838e-05;
+        constexpr double kExp2C8 = 1.3215486790144305e-06;
+        constexpr double kExp2C9 = 1.0178086009239696e-07;
+
+        // Scalar reference, also used for the tails of the vector variants
+
+        void exp2AffineScalar(const double *x, size_t n, double scale, double bias, float *out) {
+            for (size_t i = 0; i < n; ++i) {
+                out[i] = static_cast<float>(std::exp2(x[i] * scale + bias));
+            }
+        }
+
+        void addScaledScalar(const double *x, size_t n, double scale, double *inout) {
+            for (size_t i = 0; i < n; ++i) {
+                inout[i] += x[i] * scale;
+            }
+        }
+
+        void accumulateScaledScalar(const float *x, size_t n, double scale, float *inout) {
+            for (size_t i = 0; i < n; ++i) {
+                inout[i] += static_cast<float>(x[i] * scale);
+            }
+        }
+
+        void toFloatScalar(const double *x, size_t n, float *out) {
+            for (size_t i = 0; i < n; ++i) {
+                out[i] = static_cast<float>(x[i]);
+            }
+        }
+
+        void toDoubleScalar(const float *x, size_t n, double *out) {
+            for (size_t i = 0; i < n; ++i) {
+                out[i] = x[i];
+            }
+        }
+
+        // The comparisons of the vector max and min, which keep the second operand if
+        // either is NaN, so that NaN is passed through.
+        void clampScalar(const double *x, size_t n, double lo, double hi, double *out) {
+            for (size_t i = 0; i < n; ++i) {
+                const double v = lo > x[i] ? lo : x[i];
+                out[i] = hi < v ? hi : v;
+            }
+        }
+
+        constexpr Table kScalarTable = {
+            Scalar, exp2AffineScalar, addScaledScalar, accumulateScaledScalar, toFloatScalar, toDoubleScalar,
+            clampScalar,
+        };
+
+#ifdef DS_CURVE_X86
+        // SSE2
+
+        DS_CURVE_TARGET("sse2")
+        void exp2AffineSse2(const double *x, size_t n, double scale, double bias, float *out) {
+            const __m128d vScale = _mm_set1_pd(scale);
+            const __m128d vBias = _mm_set1_pd(bias);
+            const __m128d vMin = _mm_set1_pd(kExp2Min);
+            const __m128d vMax = _mm_set1_pd(kExp2Max);
+            const __m128d vShifter = _mm_set1_pd(kRoundShifter);
+            const __m128i vExpBias = _mm_set1_epi64x(1023);
+            size_t i = 0;
+            for (; i + 2 <= n; i += 2) {
+                __m128d t = _mm_add_pd(_mm_mul_pd(_mm_loadu_pd(x + i), vScale), vBias);
+                // NaN is passed through as the second operand.
+                t = _mm_min_pd(vMax, _mm_max_pd(vMin, t));
+                const __m128d k = _mm_add_pd(t, vShifter);
+                const __m128d f = _mm_sub_pd(t, _mm_sub_pd(k, vShifter));
+                __m128d p = _mm_set1_pd(kExp2C9);
+                p = _mm_add_pd(_mm_mul_pd(p, f), _mm_set1_pd(kExp2C8));
+                p = _mm_add_pd(_mm_mul_pd(p, f), _mm_set1_pd(kExp2C7));
+                p = _mm_add_pd(_mm_mul_pd(p, f), _mm_set1_pd(kExp2C6));
+                p = _mm_add_pd(_mm_mul_pd(p, f), _mm_set1_pd(kExp2C5));
+                p = _mm_add_pd(_mm_mul_pd(p, f), _mm_set1_pd(kExp2C4));
+                p = _mm_add_pd(_mm_mul_pd(p, f), _mm_set1_pd(kExp2C3));
+                p = _mm_add_pd(_mm_mul_pd(p, f), _mm_set1_pd(kExp2C2));
+                p = _mm_add_pd(_mm_mul_pd(p, f), _mm_set1_pd(kExp2C1));
+                p = _mm_add_pd(_mm_mul_pd(p, f), _mm_set1_pd(kExp2C0));
+                const __m128i e = _mm_slli_epi64(_mm_add_epi64(_mm_castpd_si128(k), vExpBias), 52);
+                p = _mm_mul_pd(p, _mm_castsi128_pd(e));
+                _mm_storel_epi64(reinterpret_cast<__m128i *>(out + i), _mm_castps_si128(_mm_cvtpd_ps(p)));
+            }
+            exp2AffineScalar(x + i, n - i, scale, bias, out + i);
+        }
+
+        DS_CURVE_TARGET("sse2")
+        void addScaledSse2(const double *x, size_t n, double scale, double *inout) {
+            const __m128d vScale = _mm_set1_pd(scale);
+            size_t i = 0;
+            for (; i + 2 <= n; i += 2) {
+                const __m128d product = _mm_mul_pd(_mm_loadu_pd(x + i), vScale);
+                _mm_storeu_pd(inout + i, _mm_add_pd(_mm_loadu_pd(inout + i), product));
+            }
+            addScaledScalar(x + i, n - i, scale, inout + i);
+        }
+
+        DS_CURVE_TARGET("sse2")
+        void accumulateScaledSse2(const float *x, size_t n, double scale, float *inout) {
+            const __m128d vScale = _mm_set1_pd(scale);
+            size_t i = 0;
+            for (; i + 4 <= n; i += 4) {
+                const __m128 v = _mm_loadu_ps(x + i);
+                const __m128 lo = _mm_cvtpd_ps(_mm_mul_pd(_mm_cvtps_pd(v), vScale));
+                const __m128 hi = _mm_cvtpd_ps(_mm_mul_pd(_mm_cvtps_pd(_mm_movehl_ps(v, v)), vScale));
+                _mm_storeu_ps(inout + i, _mm_add_ps(_mm_loadu_ps(inout + i), _mm_movelh_ps(lo, hi)));
+            }
+            accumulateScaledScalar(x + i, n - i, scale, inout + i);
+        }
+
+        DS_CURVE_TARGET("sse2")
+        void toFloatSse2(const double *x, size_t n, float *out) {
+            size_t i = 0;
+            for (; i + 4 <= n; i += 4) {
+                const __m128 lo = _mm_cvtpd_ps(_mm_loadu_pd(x + i));
+                const __m128 hi = _mm_cvtpd_ps(_mm_loadu_pd(x + i + 2));
+                _mm_storeu_ps(out + i, _mm_movelh_ps(lo, hi));
+            }
+            toFloatScalar(x + i, n - i, out + i);
+        }
+
+        DS_CURVE_TARGET("sse2")
+        void toDoubleSse2(const float *x, size_t n, double *out) {
+            size_t i = 0;
+            for (; i + 4 <= n; i += 4) {
+                const __m128 v = _mm_loadu_ps(x + i);
+                _mm_storeu_pd(out + i, _mm_cvtps_pd(v));
+                _mm_storeu_pd(out + i + 2, _mm_cvtps_pd(_mm_movehl_ps(v, v)));
+            }
+            toDoubleScalar(x + i, n - i, out + i);
+        }
+
+        DS_CURVE_TARGET("sse2")
+        void clampSse2(const double *x, size_t n, double lo, double hi, double *out) {
+            const __m128d vLo = _mm_set1_pd(lo);
+            const __m128d vHi = _mm_set1_pd(hi);
+            size_t i = 0;
+            for (; i + 2 <= n; i += 2) {
+                _mm_storeu_pd(out + i, _mm_min_pd(vHi, _mm_max_pd(vLo, _mm_loadu_pd(x + i))));
+            }
+            clampScalar(x + i, n - i, lo, hi, out + i);
+        }
+
+        constexpr Table kSse2Table = {
+            SSE2, exp2AffineSse2, addScaledSse2, accumulateScaledSse2, toFloatSse2, toDoubleSse2, clampSse2,
+        };
+
+        // AVX2
+
+        DS_CURVE_TARGET("avx2,fma")
+        void exp2AffineAvx2(const double *x, size_t n, double scale, double bias, float *out) {
+            const __m256d vScale = _mm256_set1_pd(scale);
+            const __m256d vBias = _mm256_set1_pd(bias);
+            const __m256d vMin = _mm256_set1_pd(kExp2Min);
+            const __m256d vMax = _mm256_set1_pd(kExp2Max);
+            const __m256d vShifter = _mm256_set1_pd(kRoundShifter);
+            const __m256i vExpBias = _mm256_set1_epi64x(1023);
+            size_t i = 0;
+            for (; i + 4 <= n; i += 4) {
+                __m256d t = _mm256_add_pd(_mm256_mul_pd(_mm256_loadu_pd(x + i), vScale), vBias);
+                t = _mm256_min_pd(vMax, _mm256_max_pd(vMin, t));
+                const __m256d k = _mm256_add_pd(t, vShifter);
+                const __m256d f = _mm256_sub_pd(t, _mm256_sub_pd(k, vShifter));
+                __m256d p = _mm256_set1_pd(kExp2C9);
+                p = _mm256_fmadd_pd(p, f, _mm256_set1_pd(kExp2C8));
+                p = _mm256_fmadd_pd(p, f, _mm256_set1_pd(kExp2C7));
+                p = _mm256_fmadd_pd(p, f, _mm256_set1_pd(kExp2C6));
+                p = _mm256_fmadd_pd(p, f, _mm256_set1_pd(kExp2C5));
+                p = _mm256_fmadd_pd(p, f, _mm256_set1_pd(kExp2C4));
+                p = _mm256_fmadd_pd(p, f, _mm256_set1_pd(kExp2C3));
+                p = _mm256_fmadd_pd(p, f, _mm256_set1_pd(kExp2C2));
+                p = _mm256_fmadd_pd(p, f, _mm256_set1_pd(kExp2C1));
+                p = _mm256_fmadd_pd(p, f, _mm256_set1_pd(kExp2C0));
+                const __m256i e = _mm256_slli_epi64(_mm256_add_epi64(_mm256_castpd_si256(k), vExpBias), 52);
+                p = _mm256_mul_pd(p, _mm256_castsi256_pd(e));
+                _mm_storeu_ps(out + i, _mm256_cvtpd_ps(p));
+            }
+            exp2AffineScalar(x + i, n - i, scale, bias, out + i);
+        }
+
+        DS_CURVE_TARGET("avx2,fma")
+        void addScaledAvx2(const double *x, size_t n, double scale, double *inout) {
+            const __m256d vScale = _mm256_set1_pd(scale);
+            size_t i = 0;
+            for (; i + 4 <= n; i += 4) {
+                const __m256d product = _mm256_mul_pd(_mm256_loadu_pd(x + i), vScale);
+                _mm256_storeu_pd(inout + i, _mm256_add_pd(_mm256_loadu_pd(inout + i), product));
+            }
+            addScaledScalar(x + i, n - i, scale, inout + i);
+        }
+
+        DS_CURVE_TARGET("avx2,fma")
+        void accumulateScaledAvx2(const float *x, size_t n, double scale, float *inout) {
+            const __m256d vScale = _mm256_set1_pd(scale);
+            size_t i = 0;
+            for (; i + 8 <= n; i += 8) {
+                const __m128 lo = _mm256_cvtpd_ps(_mm256_mul_pd(_mm256_cvtps_pd(_mm_loadu_ps(x + i)), vScale));
+                const __m128 hi = _mm256_cvtpd_ps(_mm256_mul_pd(_mm256_cvtps_pd(_mm_loadu_ps(x + i + 4)), vScale));
+                const __m256 product = _mm256_insertf128_ps(_mm256_castps128_ps256(lo), hi, 1);
+                _mm256_storeu_ps(inout + i, _mm256_add_ps(_mm256_loadu_ps(inout + i), product));
+            }
+            accumulateScaledScalar(x + i, n - i, scale, inout + i);
+        }
+
+        DS_CURVE_TARGET("avx2,fma")
+        void toFloatAvx2(const double *x, size_t n, float *out) {
+            size_t i = 0;
+            for (; i + 8 <= n; i += 8) {
+                const __m128 lo = _mm256_cvtpd_ps(_mm256_loadu_pd(x + i));
+                const __m128 hi = _mm256_cvtpd_ps(_mm256_loadu_pd(x + i + 4));
+                _mm256_storeu_ps(out + i, _mm256_insertf128_ps(_mm256_castps128_ps256(lo), hi, 1));
+            }
+            toFloatScalar(x + i, n - i, out + i);
+        }
+
+        DS_CURVE_TARGET("avx2,fma")
+        void toDoubleAvx2(const float *x, size_t n, double *out) {
+            size_t i = 0;
+            for (; i + 8 <= n; i += 8) {
+                _mm256_storeu_pd(out + i, _mm256_cvtps_pd(_mm_loadu_ps(x + i)));
+                _mm256_storeu_pd(out + i + 4, _mm256_cvtps_pd(_mm_loadu_ps(x + i + 4)));
+            }
+            toDoubleScalar(x + i, n - i, out + i);
+        }
+
+        DS_CURVE_TARGET("avx2,fma")
+        void clampAvx2(const double *x, size_t n, double lo, double hi, double *out) {
+            const __m256d vLo = _mm256_set1_pd(lo);
+            const __m256d vHi = _mm256_set1_pd(hi);
+            size_t i = 0;
+            for (; i + 4 <= n; i += 4) {
+                _mm256_storeu_pd(out + i, _mm256_min_pd(vHi, _mm256_max_pd(vLo, _mm256_loadu_pd(x + i))));
+            }
+            clampScalar(x + i, n - i, lo, hi, out + i);
+        }
+
+        constexpr Table kAvx2Table = {
+            AVX2, exp2AffineAvx2, addScaledAvx2, accumulateScaledAvx2, toFloatAvx2, toDoubleAvx2, clampAvx2,
+        };
+
+        // AVX-512
+
+        // The unmasked forms of some AVX-512 intrinsics start from an undefined register in
+        // the GCC headers, which GCC 12 reports as maybe uninitialized under -Wall -O2. The
+        // masked forms with all lanes set and a zero source give the same results.
+        constexpr __mmask8 kAllLanes = 0xFF;
+
+        DS_CURVE_TARGET("avx512f")
+        void exp2AffineAvx512(const double *x, size_t n, double scale, double bias, float *out) {
+            const __m512d vScale = _mm512_set1_pd(scale);
+            const __m512d vBias = _mm512_set1_pd(bias);
+            const __m512d vMin = _mm512_set1_pd(kExp2Min);
+            const __m512d vMax = _mm512_set1_pd(kExp2Max);
+            const __m512d vShifter = _mm512_set1_pd(kRoundShifter);
+            const __m512i vExpBias = _mm512_set1_epi64(1023);
+            size_t i = 0;
+            for (; i + 8 <= n; i += 8) {
+                __m512d t = _mm512_add_pd(_mm512_mul_pd(_mm512_loadu_pd(x + i), vScale), vBias);
+                const __m512d vZero = _mm512_setzero_pd();
+                t = _mm512_mask_min_pd(vZero, kAllLanes, vMax, _mm512_mask_max_pd(vZero, kAllLanes, vMin, t));
+                const __m512d k = _mm512_add_pd(t, vShifter);
+                const __m512d f = _mm512_sub_pd(t, _mm512_sub_pd(k, vShifter));
+                __m512d p = _mm512_set1_pd(kExp2C9);
+                p = _mm512_fmadd_pd(p, f, _mm512_set1_pd(kExp2C8));
+                p = _mm512_fmadd_pd(p, f, _mm512_set1_pd(kExp2C7));
+                p = _mm512_fmadd_pd(p, f, _mm512_set1_pd(kExp2C6));
+                p = _mm512_fmadd_pd(p, f, _mm512_set1_pd(kExp2C5));
+                p = _mm512_fmadd_pd(p, f, _mm512_set1_pd(kExp2C4));
+                p = _mm512_fmadd_pd(p, f, _mm512_set1_pd(kExp2C3));
+                p = _mm512_fmadd_pd(p, f, _mm512_set1_pd(kExp2C2));
+                p = _mm512_fmadd_pd(p, f, _mm512_set1_pd(kExp2C1));
+                p = _mm512_fmadd_pd(p, f, _mm512_set1_pd(kExp2C0));
+                const __m512i e =
+                    _mm512_maskz_slli_epi64(kAllLanes, _mm512_add_epi64(_mm512_castpd_si512(k), vExpBias), 52);
+                p = _mm512_mul_pd(p, _mm512_castsi512_pd(e));
+                _mm256_storeu_ps(out + i, _mm512_mask_cvtpd_ps(_mm256_setzero_ps(), kAllLanes, p));
+            }
+            exp2AffineScalar(x + i, n - i, scale, bias, out + i);
+        }
+
+        DS_CURVE_TARGET("avx512f")
+        void addScaledAvx512(const double *x, size_t n, double scale, double *inout) {
+            const __m512d vScale = _mm512_set1_pd(scale);
+            size_t i = 0;
+            for (; i + 8 <= n; i += 8) {
+                const __m512d product = _mm512_mul_pd(_mm512_loadu_pd(x + i), vScale);
+                _mm512_storeu_pd(inout + i, _mm512_add_pd(_mm512_loadu_pd(inout + i), product));
+            }
+            addScaledScalar(x + i, n - i, scale, inout + i);
+        }
+
+        DS_CURVE_TARGET("avx512f")
+        void accumulateScaledAvx512(const float *x, size_t n, double scale, float *inout) {
+            const __m512d vScale = _mm512_set1_pd(scale);
+            size_t i = 0;
+            for (; i + 8 <= n; i += 8) {
+                const __m512d v = _mm512_maskz_cvtps_pd(kAllLanes, _mm256_loadu_ps(x + i));
+                const __m256 product = _mm512_mask_cvtpd_ps(_mm256_setzero_ps(), kAllLanes, _mm512_mul_pd(v, vScale));
+                _mm256_storeu_ps(inout + i, _mm256_add_ps(_mm256_loadu_ps(inout + i), product));
+            }
+            accumulateScaledScalar(x + i, n - i, scale, inout + i);
+        }
+
+        DS_CURVE_TARGET("avx512f")
+        void toFloatAvx512(const double *x, size_t n, float *out) {
+            size_t i = 0;
+            for (; i + 8 <= n; i += 8) {
+                _mm256_storeu_ps(out + i, _mm512_mask_cvtpd_ps(_mm256_setzero_ps(), kAllLanes, _mm512_loadu_pd(x + i)));
+            }
+            toFloatScalar(x + i, n - i, out + i);
+        }
+
+        DS_CURVE_TARGET("avx512f")
+        void toDoubleAvx512(const float *x, size_t n, double *out) {
+            size_t i = 0;
+            for (; i + 8 <= n; i += 8) {
+                _mm512_storeu_pd(out + i, _mm512_maskz_cvtps_pd(kAllLanes, _mm256_loadu_ps(x + i)));
+            }
+            toDoubleScalar(x + i, n - i, out + i);
+        }
+
+        DS_CURVE_TARGET("avx512f")
+        void clampAvx512(const double *x, size_t n, double lo, double hi, double *out) {
+            const __m512d vLo = _mm512_set1_pd(lo);
+            const __m512d vHi = _mm512_set1_pd(hi);
+            const __m512d vZero = _mm512_setzero_pd();
+            size_t i = 0;
+            for (; i + 8 <= n; i += 8) {
+                const __m512d v = _mm512_mask_max_pd(vZero, kAllLanes, vLo, _mm512_loadu_pd(x + i));
+                _mm512_storeu_pd(out + i, _mm512_mask_min_pd(vZero, kAllLanes, vHi, v));
+            }
+            clampScalar(x + i, n - i, lo, hi, out + i);
+        }
+
+        constexpr Table kAvx512Table = {
+            AVX512, exp2AffineAvx512, addScaledAvx512, accumulateScaledAvx512, toFloatAvx512, toDoubleAvx512,
+            clampAvx512,
+        };
+
+        struct CpuFeatures {
+            bool sse2 = false;
+            bool avx2 = false;
+            bool avx512 = false;
+
+            CpuFeatures() {
+#  ifdef _MSC_VER
+                int info[4];
+                __cpuid(info, 0);
+                const int maxLeaf = info[0];
+                __cpuid(info, 1);
+                sse2 = (info[3] & (1 << 26)) != 0;
+                const bool fma = (info[2] & (1 << 12)) != 0;
+                const bool osxsave = (info[2] & (1 << 27)) != 0;
+                // The OS must save the YMM (and ZMM) registers.
+                const unsigned long long xcr0 = osxsave ? _xgetbv(0) : 0;
+                const bool ymm = (xcr0 & 0x6) == 0x6;
+                const bool zmm = (xcr0 & 0xe6) == 0xe6;
+                if (maxLeaf >= 7) {
+                    __cpuidex(info, 7, 0);
+                    avx2 = ymm && fma && (info[1] & (1 << 5)) != 0;
+                    avx512 = zmm && (info[1] & (1 << 16)) != 0;
+                }
+#  else
+                __builtin_cpu_init();
+                sse2 = __builtin_cpu_supports("sse2");
+                avx2 = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+                avx512 = __builtin_cpu_supports("avx512f");
+#  endif
+            }
+        };
+
+        const CpuFeatures &cpuFeatures() {
+            static const CpuFeatures features;
+            return features;
+        }
+#endif
+
+#ifdef DS_CURVE_NEON
+        // NEON, always available on AArch64
+
+        void exp2AffineNeon(const double *x, size_t n, double scale, double bias, float *out) {
+            const float64x2_t vScale = vdupq_n_f64(scale);
+            const float64x2_t vBias = vdupq_n_f64(bias);
+            const float64x2_t vMin = vdupq_n_f64(kExp2Min);
+            const float64x2_t vMax = vdupq_n_f64(kExp2Max);
+            const float64x2_t vShifter = vdupq_n_f64(kRoundShifter);
+            const int64x2_t vExpBias = vdupq_n_s64(1023);
+            size_t i = 0;
+            for (; i + 2 <= n; i += 2) {
+                float64x2_t t = vaddq_f64(vmulq_f64(vld1q_f64(x + i), vScale), vBias);
+                // NaN propagates through both.
+                t = vminq_f64(vMax, vmaxq_f64(vMin, t));
+                const float64x2_t k = vaddq_f64(t, vShifter);
+                const float64x2_t f = vsubq_f64(t, vsubq_f64(k, vShifter));
+                float64x2_t p = vdupq_n_f64(kExp2C9);
+                p = vfmaq_f64(vdupq_n_f64(kExp2C8), p, f);
+                p = vfmaq_f64(vdupq_n_f64(kExp2C7), p, f);
+                p = vfmaq_f64(vdupq_n_f64(kExp2C6), p, f);
+                p = vfmaq_f64(vdupq_n_f64(kExp2C5), p, f);
+                p = vfmaq_f64(vdupq_n_f64(kExp2C4), p, f);
+                p = vfmaq_f64(vdupq_n_f64(kExp2C3), p, f);
+                p = vfmaq_f64(vdupq_n_f64(kExp2C2), p, f);
+                p = vfmaq_f64(vdupq_n_f64(kExp2C1), p, f);
+                p = vfmaq_f64(vdupq_n_f64(kExp2C0), p, f);
+                const int64x2_t e = vshlq_n_s64(vaddq_s64(vreinterpretq_s64_f64(k), vExpBias), 52);
+                p = vmulq_f64(p, vreinterpretq_f64_s64(e));
+                vst1_f32(out + i, vcvt_f32_f64(p));
+            }
+            exp2AffineScalar(x + i, n - i, scale, bias, out + i);
+        }
+
+        void addScaledNeon(const double *x, size_t n, double scale, double *inout) {
+            const float64x2_t vScale = vdupq_n_f64(scale);
+            size_t i = 0;
+            for (; i + 2 <= n; i += 2) {
+                const float64x2_t product = vmulq_f64(vld1q_f64(x + i), vScale);
+                vst1q_f64(inout + i, vaddq_f64(vld1q_f64(inout + i), product));
+            }
+            addScaledScalar(x + i, n - i, scale, inout + i);
+        }
+
+        void accumulateScaledNeon(const float *x, size_t n, double scale, float *inout) {
+            const float64x2_t vScale = vdupq_n_f64(scale);
+            size_t i = 0;
+            for (; i + 4 <= n; i += 4) {
+                const float32x4_t v = vld1q_f32(x + i);
+                const float32x2_t lo = vcvt_f32_f64(vmulq_f64(vcvt_f64_f32(vget_low_f32(v)), vScale));
+                const float32x2_t hi = vcvt_f32_f64(vmulq_f64(vcvt_high_f64_f32(v), vScale));
+                vst1q_f32(inout + i, vaddq_f32(vld1q_f32(inout + i), vcombine_f32(lo, hi)));
+            }
+            accumulateScaledScalar(x + i, n - i, scale, inout + i);
+        }
+
+        void toFloatNeon(const double *x, size_t n, float *out) {
+            size_t i = 0;
+            for (; i + 4 <= n; i += 4) {
+                const float32x2_t lo = vcvt_f32_f64(vld1q_f64(x + i));
+                vst1q_f32(out + i, vcvt_high_f32_f64(lo, vld1q_f64(x + i + 2)));
+            }
+            toFloatScalar(x + i, n - i, out + i);
+        }
+
+        void toDoubleNeon(const float *x, size_t n, double *out) {
+            size_t i = 0;
+            for (; i + 4 <= n; i += 4) {
+                const float32x4_t v = vld1q_f32(x + i);
+                vst1q_f64(out + i, vcvt_f64_f32(vget_low_f32(v)));
+                vst1q_f64(out + i + 2, vcvt_high_f64_f32(v));
+            }
+            toDoubleScalar(x + i, n - i, out + i);
+        }
+
+        void clampNeon(const double *x, size_t n, double lo, double hi, double *out) {
+            const float64x2_t vLo = vdupq_n_f64(lo);
+            const float64x2_t vHi = vdupq_n_f64(hi);
+            size_t i = 0;
+            for (; i + 2 <= n; i += 2) {
+                // NaN propagates through both.
+                vst1q_f64(out + i, vminq_f64(vHi, vmaxq_f64(vLo, vld1q_f64(x + i))));
+            }
+            clampScalar(x + i, n - i, lo, hi, out + i);
+        }
+
+        constexpr Table kNeonTable = {
+            NEON, exp2AffineNeon, addScaledNeon, accumulateScaledNeon, toFloatNeon, toDoubleNeon, clampNeon,
+        };
+#endif
+
+        const Table &selectTable() {
+            for (auto isa : {AVX512, AVX2, SSE2, NEON}) {
+                if (auto result = tableFor(isa)) {
+                    return *result;
+                }
+            }
+            return kScalarTable;
+        }
+    }
+
+    const Table &table() {
+        static const Table &selected = selectTable();
+        return selected;
+    }
+
+    const Table *tableFor(Isa isa) {
+        switch (isa) {
+            case Scalar:
+                return &kScalarTable;
+#ifdef DS_CURVE_X86
+            case SSE2:
+                return cpuFeatures().sse2 ? &kSse2Table : nullptr;
+            case AVX2:
+                return cpuFeatures().avx2 ? &kAvx2Table : nullptr;
+            case AVX512:
+                return cpuFeatures().avx512 ? &kAvx512Table : nullptr;
+#endif
+#ifdef DS_CURVE_NEON
+            case NEON:
+                return &kNeonTable;
+#endif
+            default:
+                break;
+        }
+        return nullptr;
+    }
+
+    const char *isaName(Isa isa) {
+        switch (isa) {
+            case SSE2:
+                return "sse2";
+            case AVX2:
+                return "avx2";
+            case AVX512:
+                return "avx512";
+            case NEON:
+                return "neon";
+            default:
+                break;
+        }
+        return "scalar";
+    }
+
+}
+
+DSONNXINFER_END_NAMESPACE
@@ -0,0 +1,78 @@
+#ifndef DS_ONNX_INFER_CURVEKERNELS_P_H
+#define DS_ONNX_INFER_CURVEKERNELS_P_H
+
+#include <cstddef>
+
+#include <dsonnxinfer/dsonnxinfer_global.h>
+
+DSONNXINFER_BEGIN_NAMESPACE
+
+/**
+ * @brief Vectorized element-wise math on curves.
+ *
+ * Each kernel has a scalar reference and SSE2, AVX2, AVX-512 and NEON variants. The
+ * variant is chosen once at runtime from the instruction sets the CPU and the build
+ * support. Relative to the scalar reference, exp2Affine is within one float ulp, with
+ * NaN passed through and infinite or out-of-range exponents saturating to infinity or
+ * zero; the other kernels give identical results, since no variant fuses a multiply
+ * with an add.
+ */
+namespace CurveKernels {
+    enum Isa {
+        Scalar,
+        SSE2,
+        AVX2,
+        AVX512,
+        NEON,
+    };
+
+    struct Table {
+        Isa isa;
+        // out[i] = 2^(x[i] * scale + bias)
+        void (*exp2Affine)(const double *x, size_t n, double scale, double bias, float *out);
+        // inout[i] += x[i] * scale
+        void (*addScaled)(const double *x, size_t n, double scale, double *inout);
+        // inout[i] += float(x[i] * scale), with the product in double
+        void (*accumulateScaled)(const float *x, size_t n, double scale, float *inout);
+        void (*toFloat)(const double *x, size_t n, float *out);
+        void (*toDouble)(const float *x, size_t n, double *out);
+        // out[i] = min(hi, max(lo, x[i])), with NaN passed through; out may be x
+        void (*clamp)(const double *x, size_t n, double lo, double hi, double *out);
+    };
+
+    // Kernels of the best supported instruction set
+    const Table &table();
+
+    // Kernels of an instruction set, or nullptr if the CPU or the build lacks it.
+    const Table *tableFor(Isa isa);
+
+    const char *isaName(Isa isa);
+
+    inline void exp2Affine(const double *x, size_t n, double scale, double bias, float *out) {
+        table().exp2Affine(x, n, scale, bias, out);
+    }
+
+    inline void addScaled(const double *x, size_t n, double scale, double *inout) {
+        table().addScaled(x, n, scale, inout);
+    }
+
+    inline void accumulateScaled(const float *x, size_t n, double scale, float *inout) {
+        table().accumulateScaled(x, n, scale, inout);
+    }
+
+    inline void toFloat(const double *x, size_t n, float *out) {
+        table().toFloat(x, n, out);
+    }
+
+    inline void toDouble(const float *x, size_t n, double *out) {
+        table().toDouble(x, n, out);
+    }
+
+    inline void clamp(const double *x, size_t n, double lo, double hi, double *out) {
+        table().clamp(x, n, lo, hi, out);
+    }
+}
+
+DSONNXINFER_END_NAMESPACE
+
+#endif // DS_ONNX_INFER_CURVEKERNELS_P_H
@@ -3,6 +3,11 @@
 #include <flowonnx/environment.h>
 #include <flowonnx/logger.h>
 
+#include <dsonnxinfer/TaskPool.h>
+#include "../inference/RunLimiter_p.h"
+#include "Placement_p.h"
+#include "CurveKernels_p.h"
+
 namespace fs = std::filesystem;
 
 DSONNXINFER_BEGIN_NAMESPACE
@@ -48,6 +53,7 @@ public:
     flowonnx::Environment _env;
     int defaultSteps = 20;
     float defaultDepth = 1.0;
+    fs::path cacheDirectory = Environment::defaultCacheDirectory();
 };
 
 Environment::Environment() : _impl(std::make_unique<Impl>()) {
@@ -107,6 +113,50 @@ void Environment::setDefaultDepth(float defaultDepth) {
     impl.defaultDepth = defaultDepth;
 }
 
+unsigned Environment::workerThreadCount() const {
+    return TaskPool::globalThreadCount();
+}
+
+void Environment::setWorkerThreadCount(unsigned count) {
+    TaskPool::setGlobalThreadCount(count);
+}
+
+int Environment::maxConcurrentRuns() const {
+    return RunLimiter::global().maxConcurrentRuns();
+}
+
+void Environment::setMaxConcurrentRuns(int count) {
+    RunLimiter::global().setMaxConcurrentRuns(count);
+}
+
+int Environment::numaNodeCount() const {
+    return Placement::nodeCount();
+}
+
+int Environment::currentNumaNode() const {
+    return Placement::currentNode();
+}
+
+fs::path Environment::cacheDirectory() const {
+    auto &impl = *_impl;
+    return impl.cacheDirectory;
+}
+
+void Environment::setCacheDirectory(const fs::path &path) {
+    auto &impl = *_impl;
+    impl.cacheDirectory = path;
+}
+
+fs::path Environment::defaultCacheDirectory() {
+    std::error_code ec;
+    const auto temp = fs::temp_directory_path(ec);
+    return ec ? fs::path() : temp / "dsonnxinfer";
+}
+
+const char *Environment::curveKernelIsa() const {
+    return CurveKernels::isaName(CurveKernels::table().isa);
+}
+
 void Environment::setLoggerCallback(DsLoggingCallback callback) {
     Logger::setCallback(callback);
 }
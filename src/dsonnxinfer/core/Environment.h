@@ -34,6 +34,67 @@ public:
     float defaultDepth() const;
     void setDefaultDepth(float defaultDepth);
 
+    /**
+     * @brief Number of worker threads of the library for preprocessing and mixing; 0 uses
+     *        one less than the hardware threads. Only takes effect if set before the first
+     *        inference; afterwards, workerThreadCount() reports the size of the running pool.
+     *
+     * These are threads of this library, not of ONNX Runtime. The session options of the
+     * runtime (intra-op and inter-op threads, the global thread pool, spinning, the arena
+     * allocator, the graph optimization level) cannot be set here: flowonnx creates the
+     * sessions and load() and Inference::open() take no such options, so the sessions keep
+     * the defaults of flowonnx.
+     */
+    unsigned workerThreadCount() const;
+    void setWorkerThreadCount(unsigned count);
+
+    /**
+     * @brief Maximum number of model runs in flight across all inference objects; 0 means
+     *        unlimited. Objects opened with InferenceOptions::limitConcurrentRuns disabled
+     *        are not counted. The limit is enforced by this library around the runs; it
+     *        does not change the threads of the runtime.
+     */
+    int maxConcurrentRuns() const;
+    void setMaxConcurrentRuns(int count);
+
+    /**
+     * @brief NUMA topology, for InferenceOptions::numaNode. Only available on Linux;
+     *        elsewhere there is one node and the current node is unknown (-1).
+     */
+    int numaNodeCount() const;
+    int currentNumaNode() const;
+
+    /**
+     * @brief Among inference objects, the one placed on the NUMA node of the calling
+     *        thread, or the first one if there is none.
+     */
+    template <class T>
+    T *localInstance(const std::vector<T *> &instances) const {
+        const int node = currentNumaNode();
+        for (auto instance : instances) {
+            if (instance->options().numaNode == node) {
+                return instance;
+            }
+        }
+        return instances.empty() ? nullptr : instances.front();
+    }
+
+    /**
+     * @brief Directory for files the library derives from voicebanks, such as compiled
+     *        phoneme dictionaries. An empty path disables these files.
+     */
+    std::filesystem::path cacheDirectory() const;
+    void setCacheDirectory(const std::filesystem::path &path);
+
+    // `dsonnxinfer` in the temporary directory of the system
+    static std::filesystem::path defaultCacheDirectory();
+
+    /**
+     * @brief Instruction set of the vectorized curve math in preprocessing: "avx512",
+     *        "avx2", "sse2", "neon" or "scalar".
+     */
+    const char *curveKernelIsa() const;
+
     void setLoggerCallback(DsLoggingCallback callback);
 
     ExecutionProvider executionProvider() const;
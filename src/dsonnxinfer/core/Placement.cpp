@@ -0,0 +1,151 @@
+#include "Placement_p.h"
+
+#include <string>
+
+#ifdef __linux__
+#  include <fstream>
+#  include <sstream>
+#  include <sched.h>
+#endif
+
+DSONNXINFER_BEGIN_NAMESPACE
+
+namespace Placement {
+
+    static thread_local int t_scopeNode = -1;
+
+    int scopeNode() {
+        return t_scopeNode;
+    }
+
+#ifdef __linux__
+    namespace {
+        // Parses a sysfs CPU list such as "0-7,16-23".
+        std::vector<int> parseCpuList(const std::string &list) {
+            std::vector<int> cpus;
+            std::stringstream stream(list);
+            std::string range;
+            while (std::getline(stream, range, ',')) {
+                if (range.empty()) {
+                    continue;
+                }
+                const auto dash = range.find('-');
+                try {
+                    const int first = std::stoi(range.substr(0, dash));
+                    const int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+                    for (int cpu = first; cpu <= last; ++cpu) {
+                        cpus.push_back(cpu);
+                    }
+                } catch (...) {
+                    return {};
+                }
+            }
+            return cpus;
+        }
+
+        struct Topology {
+            std::vector<std::vector<int>> nodeCpus;
+            std::vector<int> cpuNodes;
+
+            Topology() {
+                for (int node = 0;; ++node) {
+                    std::ifstream file("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+                    if (!file.is_open()) {
+                        break;
+                    }
+                    std::string list;
+                    std::getline(file, list);
+                    auto cpus = parseCpuList(list);
+                    for (int cpu : cpus) {
+                        if (cpu >= static_cast<int>(cpuNodes.size())) {
+                            cpuNodes.resize(cpu + 1, -1);
+                        }
+                        cpuNodes[cpu] = node;
+                    }
+                    nodeCpus.push_back(std::move(cpus));
+                }
+            }
+        };
+
+        const Topology &topology() {
+            static const Topology instance;
+            return instance;
+        }
+    }
+
+    int nodeCount() {
+        const auto count = static_cast<int>(topology().nodeCpus.size());
+        return count > 0 ? count : 1;
+    }
+
+    std::vector<int> nodeCpus(int node) {
+        const auto &nodes = topology().nodeCpus;
+        if (node < 0 || node >= static_cast<int>(nodes.size())) {
+            return {};
+        }
+        return nodes[node];
+    }
+
+    int currentNode() {
+        const int cpu = sched_getcpu();
+        const auto &cpuNodes = topology().cpuNodes;
+        if (cpu < 0 || cpu >= static_cast<int>(cpuNodes.size())) {
+            return -1;
+        }
+        return cpuNodes[cpu];
+    }
+
+    Scope::Scope(int node) {
+        const auto cpus = nodeCpus(node);
+        if (cpus.empty()) {
+            return;
+        }
+        cpu_set_t previous;
+        if (sched_getaffinity(0, sizeof(previous), &previous) != 0) {
+            return;
+        }
+        cpu_set_t mask;
+        CPU_ZERO(&mask);
+        for (int cpu : cpus) {
+            if (cpu < CPU_SETSIZE) {
+                CPU_SET(cpu, &mask);
+            }
+        }
+        if (sched_setaffinity(0, sizeof(mask), &mask) != 0) {
+            return;
+        }
+        const auto bytes = reinterpret_cast<const unsigned char *>(&previous);
+        m_previousMask.assign(bytes, bytes + sizeof(previous));
+        m_pinned = true;
+        m_previousNode = t_scopeNode;
+        t_scopeNode = node;
+    }
+
+    Scope::~Scope() {
+        if (m_pinned) {
+            sched_setaffinity(0, m_previousMask.size(), reinterpret_cast<const cpu_set_t *>(m_previousMask.data()));
+            t_scopeNode = m_previousNode;
+        }
+    }
+#else
+    int nodeCount() {
+        return 1;
+    }
+
+    std::vector<int> nodeCpus([[maybe_unused]] int node) {
+        return {};
+    }
+
+    int currentNode() {
+        return -1;
+    }
+
+    Scope::Scope([[maybe_unused]] int node) {
+    }
+
+    Scope::~Scope() = default;
+#endif
+
+}
+
+DSONNXINFER_END_NAMESPACE
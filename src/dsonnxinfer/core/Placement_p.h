@@ -0,0 +1,52 @@
+#ifndef DS_ONNX_INFER_PLACEMENT_P_H
+#define DS_ONNX_INFER_PLACEMENT_P_H
+
+#include <vector>
+
+#include <dsonnxinfer/dsonnxinfer_global.h>
+
+DSONNXINFER_BEGIN_NAMESPACE
+
+/**
+ * @brief NUMA topology and thread placement.
+ *
+ * Only implemented on Linux, where the topology is read from sysfs. Elsewhere the
+ * machine is reported as a single node and placement does nothing.
+ */
+namespace Placement {
+    int nodeCount();
+
+    // CPUs of a NUMA node, empty if the node does not exist.
+    std::vector<int> nodeCpus(int node);
+
+    // NUMA node of the CPU the calling thread runs on, or -1 if unknown.
+    int currentNode();
+
+    // Node of the innermost Scope pinning the calling thread, or -1 if there is none.
+    int scopeNode();
+
+    /**
+     * @brief Restricts the calling thread to the CPUs of a NUMA node for its lifetime.
+     *
+     * Threads created meanwhile inherit the restriction, and memory first touched by
+     * the thread is allocated on the node. The workers of the TaskPool take on the node
+     * while they help the thread in parallelFor(). A negative or unknown node does
+     * nothing.
+     */
+    class Scope {
+    public:
+        explicit Scope(int node);
+        ~Scope();
+
+        DSONNXINFER_DISABLE_COPY_MOVE(Scope)
+
+    private:
+        bool m_pinned = false;
+        int m_previousNode = -1;
+        std::vector<unsigned char> m_previousMask;
+    };
+}
+
+DSONNXINFER_END_NAMESPACE
+
+#endif // DS_ONNX_INFER_PLACEMENT_P_H
@@ -1,27 +1,78 @@
 
 #include "AcousticInference.h"
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
 #include <fstream>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <string>
 #include <utility>
 #include <nlohmann/json.hpp>
 
 #include <flowonnx/inference.h>
 #include "InferenceCommon_p.h"
+#include "CompactSegment_p.h"
+#include "PhonemeDict_p.h"
+#include "TensorPool_p.h"
+#include "RunLimiter_p.h"
+#include "ModelVariant_p.h"
+#include "MelCache_p.h"
+#include "VocoderCommon_p.h"
+#include "InputPlan_p.h"
+#include "DiffusionScheduler_p.h"
+#include "../core/Placement_p.h"
+#include "SegmentSplitter_p.h"
+#include <dsonnxinfer/Mixdown.h>
 #include <dsonnxinfer/Environment.h>
-
-#ifdef DSONNXINFER_ENABLE_AUDIO_EXPORT
-#include <sndfile.hh>
-#endif
+#include <dsonnxinfer/TaskPool.h>
 
 DSONNXINFER_BEGIN_NAMESPACE
 
+// Overlap on each side of a cut when a long segment is split, in seconds.
+constexpr double kChunkPadding = 0.05;
+
+// Sessions and run state of one chunk in flight. The chunks of a split segment run on
+// workers of their own, so that they do not share anything but the mel cache.
+struct AcousticWorker {
+    AcousticWorker() : inferenceHandle("ds_acoustic") {
+        setVocoderSessionCount(1);
+    }
+
+    void setVocoderSessionCount(int count) {
+        vocoderHandles.resize((std::min)(vocoderHandles.size(), static_cast<size_t>(count)));
+        while (vocoderHandles.size() < static_cast<size_t>(count)) {
+            vocoderHandles.push_back(std::make_unique<flowonnx::Inference>("ds_vocoder"));
+        }
+    }
+
+    std::vector<flowonnx::Inference *> vocoders() const {
+        std::vector<flowonnx::Inference *> result;
+        for (const auto &handle : vocoderHandles) {
+            result.push_back(handle.get());
+        }
+        return result;
+    }
+
+    flowonnx::Inference inferenceHandle;
+    // The chunks of a long mel spectrogram are vocoded on all of them at the same time.
+    std::vector<std::unique_ptr<flowonnx::Inference>> vocoderHandles;
+    TensorPool tensorPool;
+    DiffusionScheduler scheduler;
+    // Steps, depth and runtimes of the chunks run by this worker in the current run
+    DiffusionRunInfo runInfo;
+};
+
 class AcousticInference::Impl {
 public:
     explicit Impl(bool vocoderPreferCpu_ = false) :
-            inferenceHandle("ds_acoustic"),
             vocoderPreferCpu(vocoderPreferCpu_),
             depth(Environment::instance()->defaultDepth()),
-            steps(Environment::instance()->defaultSteps()) {}
+            steps(Environment::instance()->defaultSteps()) {
+        workers.push_back(std::make_unique<AcousticWorker>());
+    }
 
     Status open() {
         /*bool loadDsConfigOk, loadDsVocoderConfigOk;
@@ -36,104 +87,428 @@ public:
             return {Status_ModelLoadError, "Failed to load voice database and vocoder config!"};
         }*/
 
-        if (dsConfig.features & kfMultiLanguage) {
-            readLangIdFile(dsConfig.languages, languages);
+        std::string errorMessage;
+        phonemeDict = PhonemeDict::load(dsConfig.phonemes, dsConfig.languages,
+                                        dsConfig.features & kfMultiLanguage, &errorMessage);
+        if (!phonemeDict) {
+            return {Status_ModelLoadError, errorMessage};
         }
-        if (isFileExtJson(dsConfig.phonemes)) {
-            readMultiLangPhonemesFile(dsConfig.phonemes, name2token);
-        } else {
-            readPhonemesFile(dsConfig.phonemes, name2token);
+        const auto acoustic = selectModelVariant(dsConfig.acoustic, dsConfig.acousticVariants, options);
+        inputPlan = InputPlan::forAcoustic(dsConfig);
+        if (auto s = inputPlan.validate(dsConfig.acoustic, acoustic, "acoustic"); !s.isOk()) {
+            return s;
         }
 
-        std::string errorMessage;
-        if (!inferenceHandle.open({{dsConfig.acoustic, false}, {dsVocoderConfig.model, vocoderPreferCpu}}, &errorMessage)) {
-            return {Status_ModelLoadError, errorMessage};
+        // One worker per chunk that may run at the same time, all with the same models
+        workers.resize(1);
+        while (workers.size() < static_cast<size_t>(maxParallelChunks)) {
+            workers.push_back(std::make_unique<AcousticWorker>());
+        }
+        for (const auto &worker : workers) {
+            worker->setVocoderSessionCount(vocoderSessionCount);
+        }
+        const ModelList vocoderReference = {{dsVocoderConfig.model, vocoderPreferCpu}};
+        const ModelList vocoderSelected = {
+            {selectModelVariant(dsVocoderConfig.model, dsVocoderConfig.modelVariants, options), vocoderPreferCpu}};
+        std::vector<SessionModels> sessions;
+        for (const auto &worker : workers) {
+            sessions.push_back({&worker->inferenceHandle, {{dsConfig.acoustic, false}}, {{acoustic, false}}});
+            for (const auto &handle : worker->vocoderHandles) {
+                sessions.push_back({handle.get(), vocoderReference, vocoderSelected});
+            }
         }
 
-        return {Status_Ok, ""};
+        // The session threads inherit the placement of this thread.
+        Placement::Scope placement(options.numaNode);
+        const auto result = openModelVariants(
+            sessions, options, [this](Status *status) {
+                // Every probe run has to go through the models.
+                melCache.clear();
+                return infer(*workers.front(), *options.precisionProbe, std::numeric_limits<double>::infinity(),
+                             status);
+            });
+        melCache.clear();
+        // The probe runs are not representative of the runtime.
+        for (const auto &worker : workers) {
+            worker->scheduler.reset();
+        }
+        return result;
     }
 
     void close() {
-        inferenceHandle.close();
+        for (const auto &worker : workers) {
+            worker->inferenceHandle.close();
+            for (const auto &handle : worker->vocoderHandles) {
+                handle->close();
+            }
+        }
+        workers.resize(1);
+        workers.front()->tensorPool.clear();
+        workers.front()->scheduler.reset();
+        melCache.clear();
+        inputPlan = {};
         dsConfig = {};
         dsVocoderConfig = {};
-        name2token.clear();
-        languages.clear();
+        phonemeDict.reset();
     }
 
-    InferMap infer(const Segment &dsSegment, Status *status) {
+    // Runs the segment on `worker` within `budget` seconds from the call, or infinite for
+    // no deadline.
+    InferMap infer(AcousticWorker &worker, const Segment &dsSegment, double budget, Status *status) {
+        const auto start = std::chrono::steady_clock::now();
+        auto &tensorPool = worker.tensorPool;
+        auto &scheduler = worker.scheduler;
+        TensorPool::Scope poolScope(&tensorPool);
+        Placement::Scope placement(options.numaNode);
+
         int sampleRate = dsConfig.sampleRate;
         int hopSize = dsConfig.hopSize;
         double frameLength = 1.0 * hopSize / sampleRate;
 
+        // With a pitch controllable vocoder, the tone shift moves the formants: the acoustic
+        // model gets the shifted f0 and the vocoder the original one.
         bool applyToneShift = dsVocoderConfig.features & kfPitchControllable;
         flowonnx::Tensor originalF0;
+        const CompactSegment segment(dsSegment, phonemeDict.get());
         auto inputData = acousticPreprocess(
-            name2token, languages, dsSegment, dsConfig, frameLength, 0, applyToneShift, &originalF0, status);
+            segment, inputPlan, frameLength, 0, applyToneShift, &originalF0, status);
         if (inputData.empty()) {
             return {};
         }
         const int64_t shapeArr = 1;
 
+        const bool variableDepth = dsConfig.features & kfVariableDepth;
+        if (variableDepth && dsConfig.maxDepth < 0) {
+            putStatus(status, Status_InferError, "!! ERROR: max_depth is unset or negative in acoustic configuration.");
+            return {};
+        }
+        const float maxDepth = variableDepth ? (std::min)(depth, dsConfig.maxDepth) : depth;
+        const std::chrono::duration<double> preprocessing = std::chrono::steady_clock::now() - start;
+        auto plan = scheduler.plan(inputData["f0"].shape.back(), budget - preprocessing.count(), steps, maxDepth,
+                                   dsConfig.features & kfContinuousAcceleration, variableDepth);
+
         if (dsConfig.features & kfContinuousAcceleration) {
-            inputData["steps"] = flowonnx::Tensor::create(&steps, 1, &shapeArr, 1);
+            inputData["steps"] = flowonnx::Tensor::create(&plan.info.steps, 1, &shapeArr, 1);
         } else {
-            int64_t speedup = getSpeedupFromSteps(steps);
+            int64_t speedup = getSpeedupFromSteps(plan.info.steps);
             inputData["speedup"] = flowonnx::Tensor::create(&speedup, 1, &shapeArr, 1);
         }
 
-        if (dsConfig.features & kfVariableDepth) {
-            if (dsConfig.maxDepth < 0) {
-                putStatus(status, Status_InferError, "!! ERROR: max_depth is unset or negative in acoustic configuration.");
+        if (variableDepth) {
+            inputData["depth"] = flowonnx::Tensor::create(&plan.info.depth, 1, &shapeArr, 1);
+        }
+
+        // The vocoder gets the f0 without tone shift if it is pitch controllable.
+        flowonnx::Tensor f0 = applyToneShift ? std::move(originalF0) : inputData["f0"];
+
+        // Reuse the mel if the acoustic inputs are unchanged since a previous run. The tone
+        // shift is one of them, so an edit of it runs the acoustic model again.
+        const auto key = fingerprintInputs(inputData);
+        flowonnx::Tensor mel;
+        const bool cached = melCache.find(key, &mel);
+        if (cached) {
+            tensorPool.recycle(inputData);
+        } else {
+            flowonnx::InferenceData dataAcoustic;
+            dataAcoustic.inputData = std::move(inputData);
+            dataAcoustic.outputNames.emplace_back("mel");
+
+            std::vector<flowonnx::InferenceData> dataList;
+            dataList.push_back(std::move(dataAcoustic));
+
+            std::string errorMessage;
+            flowonnx::TensorMap result;
+            {
+                RunLimiter::Slot runSlot(options.limitConcurrentRuns);
+                result = worker.inferenceHandle.run(dataList, &errorMessage);
+            }
+            tensorPool.recycle(dataList);
+
+            auto it = result.find("mel");
+            if (it == result.end()) {
+                putStatus(status, Status_InferError, result.empty() ? std::move(errorMessage) : "Missing mel output");
                 return {};
             }
-            const float inferDepth = (std::min)(depth, dsConfig.maxDepth);
-            inputData["depth"] = flowonnx::Tensor::create(&inferDepth, 1, &shapeArr, 1);
+            mel = std::move(it->second);
+            melCache.insert(key, mel);
+        }
+
+        auto result = runVocoderChunked(worker.vocoders(), std::move(mel), std::move(f0), dsVocoderConfig.hopSize,
+                                        vocoderChunkFrames, vocoderChunkOverlapFrames, options, tensorPool, status);
+        // A cached mel skips the acoustic model, so its runtime says nothing about the steps.
+        worker.runInfo =
+            DiffusionScheduler::merge(worker.runInfo, scheduler.finish(std::move(plan), !cached && !result.empty()));
+        return result;
+    }
+
+    std::shared_ptr<flowonnx::Tensor> inferWaveform(AcousticWorker &worker, const Segment &dsSegment, double budget,
+                                                    Status *status) {
+        auto result = infer(worker, dsSegment, budget, status);
+        if (result.empty()) {
+            return {};
+        }
+        auto it = result.find("waveform");
+        if (it == result.end()) {
+            putStatus(status, Status_InferError, "Missing waveform output");
+            return {};
         }
+        // Take over the output tensor instead of copying the samples.
+        return std::make_shared<flowonnx::Tensor>(std::move(it->second));
+    }
 
-        flowonnx::InferenceData dataAcoustic, dataVocoder;
+    AudioBuffer toAudioBuffer(std::shared_ptr<flowonnx::Tensor> tensor, double offset) const {
+        const float *buffer;
+        const auto bufferSize = tensor->getDataBuffer<float>(&buffer);
+
+        AudioBuffer waveform;
+        waveform.samples = buffer;
+        waveform.sampleCount = static_cast<size_t>(bufferSize);
+        waveform.sampleRate = dsVocoderConfig.sampleRate;
+        waveform.offset = offset;
+        waveform.storage = std::move(tensor);
+        return waveform;
+    }
 
-        dataAcoustic.inputData = std::move(inputData);
-        dataAcoustic.bindings.push_back({1, "mel", "mel", false});
-        if (applyToneShift) {
-            dataVocoder.inputData["f0"] = std::move(originalF0);
-        } else {
-            dataAcoustic.bindings.push_back({1, "f0", "f0", true});
+    // Returns the buffer of a waveform tensor to the pool of the worker that produced it,
+    // or disowns it if it is still held elsewhere.
+    static void recycle(std::shared_ptr<flowonnx::Tensor> &tensor, TensorPool &tensorPool) {
+        if (tensor && tensor.use_count() == 1) {
+            tensorPool.release(std::move(tensor->data));
+        } else if (tensor) {
+            tensorPool.disown(tensor->data);
         }
+        tensor.reset();
+    }
 
-        dataVocoder.outputNames.emplace_back("waveform");
+    std::vector<SegmentChunk> split(const Segment &dsSegment) const {
+        const double frameLength = 1.0 * dsConfig.hopSize / dsConfig.sampleRate;
+        return splitSegmentAtRests(dsSegment, frameLength, maxChunkFrames, kChunkPadding);
+    }
 
-        std::vector dataList{dataAcoustic, dataVocoder};
+    int64_t expectedSampleCount(const Segment &dsSegment, const std::vector<SegmentChunk> &chunks) const {
+        // The vocoder produces hopSize samples per mel frame.
+        const double frameLength = 1.0 * dsConfig.hopSize / dsConfig.sampleRate;
+        const int64_t hopSize = dsVocoderConfig.hopSize;
+        if (chunks.empty()) {
+            return getFrameCount(dsSegment, frameLength) * hopSize;
+        }
+        // Same placement as Mixdown
+        int64_t count = 0;
+        for (const auto &chunk : chunks) {
+            const int64_t start = std::llround(chunk.start * dsVocoderConfig.sampleRate);
+            count = (std::max)(count, start + getFrameCount(chunk.segment, frameLength) * hopSize);
+        }
+        return count;
+    }
 
-        std::string errorMessage;
-        auto result = inferenceHandle.run(dataList, &errorMessage);
+    /**
+     * Runs the segment, splitting it if it is too long. With a target buffer, the waveform
+     * is copied to the target, otherwise it is returned in a buffer of its own. If the
+     * target is too small, the returned buffer has no samples but reports the required size.
+     *
+     * The size of a target run is decided before the models run, by expectedSampleCount():
+     * the call fails right away if it does not fit, and a waveform of any other size is an
+     * inference error.
+     */
+    AudioBuffer run(const Segment &dsSegment, Status *status, float *target = nullptr, size_t capacity = 0) {
+        // The deadline covers the whole call, across the chunks.
+        const auto start = std::chrono::steady_clock::now();
+        for (const auto &worker : workers) {
+            worker->runInfo = {};
+        }
+        const auto waveform = runChunks(dsSegment, start, status, target, capacity);
+        DiffusionRunInfo runInfo;
+        for (const auto &worker : workers) {
+            if (worker->runInfo.steps != 0) {
+                runInfo = DiffusionScheduler::merge(runInfo, worker->runInfo);
+            }
+        }
+        workers.front()->scheduler.setLastRun(runInfo);
+        return waveform;
+    }
 
-        if (status) {
-            if (result.empty()) {
-                status->code = Status_InferError;
-                status->msg = std::move(errorMessage);
+    AudioBuffer runChunks(const Segment &dsSegment, std::chrono::steady_clock::time_point start, Status *status,
+                          float *target, size_t capacity) {
+        auto chunks = split(dsSegment);
+        const size_t expected = target ? static_cast<size_t>(expectedSampleCount(dsSegment, chunks)) : 0;
+        if (target && expected > capacity) {
+            return bufferTooSmall(expected, status);
+        }
+
+        if (chunks.empty()) {
+            auto &worker = *workers.front();
+            auto tensor = inferWaveform(worker, dsSegment, DiffusionScheduler::remaining(deadline, start), status);
+            if (!tensor) {
+                return {};
+            }
+            if (!target) {
+                // The caller owns the waveform from now on.
+                worker.tensorPool.disown(tensor->data);
+                return toAudioBuffer(std::move(tensor), dsSegment.offset);
+            }
+            // flowonnx has no output binding, so the runtime cannot write to the target.
+            const float *buffer;
+            const auto bufferSize = static_cast<size_t>(tensor->getDataBuffer<float>(&buffer));
+            if (bufferSize != expected) {
+                recycle(tensor, worker.tensorPool);
+                return unexpectedSize(status);
+            }
+            std::copy(buffer, buffer + bufferSize, target);
+            recycle(tensor, worker.tensorPool);
+            return targetBuffer(target, bufferSize, dsSegment.offset);
+        }
+
+        // Each worker takes the next chunk until none are left. The chunks not started yet
+        // share the time left in proportion to their frames, spread over the workers.
+        const double frameLength = 1.0 * dsConfig.hopSize / dsConfig.sampleRate;
+        std::vector<int64_t> frames(chunks.size());
+        int64_t pendingFrames = 0;
+        for (size_t i = 0; i < chunks.size(); ++i) {
+            frames[i] = getFrameCount(chunks[i].segment, frameLength);
+            pendingFrames += frames[i];
+        }
+        const size_t workerCount = (std::min)(workers.size(), chunks.size());
+        std::vector<std::shared_ptr<flowonnx::Tensor>> waveforms(chunks.size());
+        std::vector<TensorPool *> owners(chunks.size(), nullptr);
+        std::vector<Status> chunkStatus(chunks.size());
+        std::mutex mutex;
+        size_t nextChunk = 0;
+        bool failed = false;
+        TaskPool::global().parallelFor(workerCount, [&](size_t w) {
+            auto &worker = *workers[w];
+            for (;;) {
+                size_t i;
+                double budget;
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    if (failed || nextChunk == chunks.size()) {
+                        return;
+                    }
+                    i = nextChunk++;
+                    const auto busy = static_cast<int64_t>((std::min)(workerCount, chunks.size() - i));
+                    budget = DiffusionScheduler::share(DiffusionScheduler::remaining(deadline, start), frames[i],
+                                                       (pendingFrames + busy - 1) / busy);
+                    pendingFrames -= frames[i];
+                }
+                owners[i] = &worker.tensorPool;
+                waveforms[i] = inferWaveform(worker, chunks[i].segment, budget, &chunkStatus[i]);
+                if (!waveforms[i]) {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    failed = true;
+                    return;
+                }
+            }
+        });
+        const auto recycleAll = [&]() {
+            for (size_t i = 0; i < chunks.size(); ++i) {
+                if (owners[i]) {
+                    recycle(waveforms[i], *owners[i]);
+                }
+            }
+        };
+        for (size_t i = 0; i < chunks.size(); ++i) {
+            if (owners[i] && !waveforms[i]) {
+                recycleAll();
+                putStatus(status, chunkStatus[i].code, std::move(chunkStatus[i].msg));
+                return {};
+            }
+        }
+
+        // Stitch the chunks, relative to the start of the segment.
+        AudioBuffer waveform;
+        {
+            Mixdown mixdown(dsVocoderConfig.sampleRate, 2 * kChunkPadding);
+            for (size_t i = 0; i < chunks.size(); ++i) {
+                if (!mixdown.addSegment(toAudioBuffer(waveforms[i], chunks[i].start), status)) {
+                    recycleAll();
+                    return {};
+                }
+            }
+            const auto sampleCount = static_cast<size_t>(mixdown.sampleCount());
+            if (target) {
+                if (sampleCount != expected) {
+                    recycleAll();
+                    return unexpectedSize(status);
+                }
+                mixdown.renderTo(target, capacity, nullptr);
+                waveform = targetBuffer(target, sampleCount, dsSegment.offset);
             } else {
-                status->code = Status_Ok;
-                status->msg = "";
+                auto samples = std::make_shared<std::vector<float>>(sampleCount);
+                mixdown.renderTo(samples->data(), samples->size(), nullptr);
+                waveform = targetBuffer(samples->data(), sampleCount, dsSegment.offset);
+                waveform.storage = std::move(samples);
             }
         }
-        return result;
+        recycleAll();
+        putStatusOk(status);
+        return waveform;
+    }
+
+    AudioBuffer targetBuffer(float *target, size_t sampleCount, double offset) const {
+        AudioBuffer waveform;
+        waveform.samples = target;
+        waveform.sampleCount = sampleCount;
+        waveform.sampleRate = dsVocoderConfig.sampleRate;
+        waveform.offset = offset;
+        return waveform;
+    }
+
+    static AudioBuffer unexpectedSize(Status *status) {
+        putStatus(status, Status_InferError, "Unexpected waveform size");
+        return {};
+    }
+
+    static AudioBuffer bufferTooSmall(size_t required, Status *status) {
+        putStatus(status, Status_GenericError,
+                  "Buffer too small: " + std::to_string(required) + " samples required");
+        AudioBuffer waveform;
+        waveform.sampleCount = required;
+        return waveform;
     }
 
     bool terminate() {
-        return inferenceHandle.terminate();
+        // All of them, whichever are running
+        bool terminated = true;
+        for (const auto &worker : workers) {
+            terminated = worker->inferenceHandle.terminate() && terminated;
+            for (const auto &handle : worker->vocoderHandles) {
+                terminated = handle->terminate() && terminated;
+            }
+        }
+        return terminated;
+    }
+
+    TensorPoolStats tensorPoolStats() const {
+        TensorPoolStats result;
+        for (const auto &worker : workers) {
+            const auto stats = worker->tensorPool.stats();
+            result.hits += stats.hits;
+            result.misses += stats.misses;
+            result.pooledBytes += stats.pooledBytes;
+            result.peakBytes += stats.peakBytes;
+        }
+        return result;
     }
 
     //std::filesystem::path dsConfigPath;
     //std::filesystem::path dsVocoderConfigPath;
     DsConfig dsConfig;
+    InputPlan inputPlan;
     DsVocoderConfig dsVocoderConfig;
-    std::unordered_map<std::string, int64_t> name2token;
-    std::unordered_map<std::string, int64_t> languages;
-    flowonnx::Inference inferenceHandle;
+    std::shared_ptr<const PhonemeDict> phonemeDict;
+    InferenceOptions options;
+    // The first one runs unsplit segments and keeps the info of the last run.
+    std::vector<std::unique_ptr<AcousticWorker>> workers;
+    MelCache melCache;
     bool vocoderPreferCpu;
     float depth;
     int64_t steps;
+    double deadline = 0.0;
+    int64_t maxChunkFrames = 0;
+    int maxParallelChunks = 1;
+    int64_t vocoderChunkFrames = 0;
+    int64_t vocoderChunkOverlapFrames = 32;
+    int vocoderSessionCount = 1;
 };
 
 AcousticInference::AcousticInference(DsConfig &&dsConfig,
@@ -160,6 +535,7 @@ AcousticInference::AcousticInference(const DsConfig &dsConfig,
 
 Status AcousticInference::open() {
     auto &impl = *_impl;
+    impl.options = m_options;
     return impl.open();
 }
 
@@ -193,43 +569,101 @@ int64_t AcousticInference::steps() const {
     return impl.steps;
 }
 
+void AcousticInference::setDeadline(double seconds) {
+    auto &impl = *_impl;
+    impl.deadline = seconds;
+}
+
+double AcousticInference::deadline() const {
+    auto &impl = *_impl;
+    return impl.deadline;
+}
+
+DiffusionRunInfo AcousticInference::lastRunInfo() const {
+    auto &impl = *_impl;
+    return impl.workers.front()->scheduler.lastRun();
+}
+
+void AcousticInference::setMaxChunkFrames(int64_t frames) {
+    auto &impl = *_impl;
+    impl.maxChunkFrames = frames;
+}
+
+int64_t AcousticInference::maxChunkFrames() const {
+    auto &impl = *_impl;
+    return impl.maxChunkFrames;
+}
+
+void AcousticInference::setMaxParallelChunks(int count) {
+    auto &impl = *_impl;
+    impl.maxParallelChunks = (std::max)(count, 1);
+}
+
+int AcousticInference::maxParallelChunks() const {
+    auto &impl = *_impl;
+    return impl.maxParallelChunks;
+}
+
+void AcousticInference::setVocoderChunkFrames(int64_t frames) {
+    auto &impl = *_impl;
+    impl.vocoderChunkFrames = frames;
+}
+
+int64_t AcousticInference::vocoderChunkFrames() const {
+    auto &impl = *_impl;
+    return impl.vocoderChunkFrames;
+}
+
+void AcousticInference::setVocoderChunkOverlapFrames(int64_t frames) {
+    auto &impl = *_impl;
+    impl.vocoderChunkOverlapFrames = frames;
+}
+
+int64_t AcousticInference::vocoderChunkOverlapFrames() const {
+    auto &impl = *_impl;
+    return impl.vocoderChunkOverlapFrames;
+}
+
+void AcousticInference::setVocoderSessionCount(int count) {
+    auto &impl = *_impl;
+    impl.vocoderSessionCount = (std::max)(count, 1);
+}
+
+int AcousticInference::vocoderSessionCount() const {
+    auto &impl = *_impl;
+    return impl.vocoderSessionCount;
+}
+
+void AcousticInference::setMelCacheCapacity(size_t bytes) {
+    auto &impl = *_impl;
+    impl.melCache.setCapacity(bytes);
+}
+
+size_t AcousticInference::melCacheCapacity() const {
+    auto &impl = *_impl;
+    return impl.melCache.capacity();
+}
+
+int AcousticInference::sampleRate() const {
+    auto &impl = *_impl;
+    return impl.dsVocoderConfig.sampleRate;
+}
+
 bool AcousticInference::runAndSaveAudio(
         const Segment &dsSegment,
         const std::filesystem::path &path,
         Status *status) {
 #ifdef DSONNXINFER_ENABLE_AUDIO_EXPORT
     auto &impl = *_impl;
-    const auto result = impl.infer(dsSegment, status);
-    if (result.empty()) {
+    AudioFileSink sink;
+    if (!sink.open(path, impl.dsVocoderConfig.sampleRate, {}, status)) {
         return false;
     }
-    if (auto it = result.find("waveform"); it != result.end()) {
-        const auto &tensor = it->second;
-        const float *buffer;
-        const auto bufferSize = tensor.getDataBuffer<float>(&buffer);
-        const auto filePath =
-#ifdef _WIN32
-            path.wstring();
-#else
-            path.string();
-#endif
-        SndfileHandle audioFile(
-                filePath.c_str(),
-                SFM_WRITE, SF_FORMAT_WAV | SF_FORMAT_FLOAT,
-                1,
-                impl.dsVocoderConfig.sampleRate);
-        auto numFrames = static_cast<sf_count_t>(bufferSize);
-        auto numWritten = audioFile.write(buffer, numFrames);
-        if (numWritten < numFrames) {
-            if (status) {
-                status->code = Status_GenericError;
-                status->msg = "Failed to write audio file";
-            }
-            return false;
-        }
-        return true;
+    if (!runToSink(dsSegment, sink, status)) {
+        sink.discard();
+        return false;
     }
-    return false;
+    return sink.close(status);
 #else
     if (status) {
         status->code = Status_GenericError;
@@ -239,6 +673,39 @@ bool AcousticInference::runAndSaveAudio(
 #endif
 }
 
+bool AcousticInference::runToSink(const Segment &dsSegment, AudioSink &sink, Status *status) {
+    const auto waveform = runToBuffer(dsSegment, status);
+    if (!waveform.samples) {
+        return false;
+    }
+    return sink.write(waveform.samples, waveform.sampleCount, status);
+}
+
+AudioBuffer AcousticInference::runToBuffer(const Segment &dsSegment, Status *status) {
+    auto &impl = *_impl;
+    return impl.run(dsSegment, status);
+}
+
+bool AcousticInference::runToBuffer(const Segment &dsSegment, float *buffer, size_t capacity, size_t *sampleCount,
+                                    Status *status) {
+    auto &impl = *_impl;
+    const auto waveform = impl.run(dsSegment, status, buffer, capacity);
+    if (sampleCount) {
+        *sampleCount = waveform.sampleCount;
+    }
+    return waveform.samples != nullptr;
+}
+
+size_t AcousticInference::expectedSampleCount(const Segment &dsSegment) const {
+    auto &impl = *_impl;
+    return static_cast<size_t>(impl.expectedSampleCount(dsSegment, impl.split(dsSegment)));
+}
+
+TensorPoolStats AcousticInference::tensorPoolStats() const {
+    auto &impl = *_impl;
+    return impl.tensorPoolStats();
+}
+
 bool AcousticInference::terminate() {
     auto &impl = *_impl;
     return impl.terminate();
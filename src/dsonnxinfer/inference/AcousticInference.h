@@ -4,6 +4,8 @@
 #include <memory>
 #include <dsonnxinfer/dsonnxinfer_global.h>
 #include "IInference.h"
+#include <dsonnxinfer/AudioBuffer.h>
+#include <dsonnxinfer/AudioSink.h>
 
 DSONNXINFER_BEGIN_NAMESPACE
 
@@ -17,6 +19,7 @@ public:
                       bool vocoderPreferCpu = false);
     ~AcousticInference() override;
 
+    using IInference::open;
     Status open() override;
     void close() override;
 
@@ -25,11 +28,117 @@ public:
     void setDepth(float depth);
     void setSteps(int64_t steps);
 
+    /**
+     * @brief Latency deadline of a run in seconds, from the call to the waveform; 0 (the
+     *        default) always runs with steps() and depth().
+     *
+     * With a deadline, a cost model fitted to the previous runs of this object lowers the
+     * steps, and then the depth, until the expected runtime fits. steps() and depth() are
+     * upper bounds. The chunks of a split segment share the time left in proportion to
+     * their frames.
+     */
+    double deadline() const;
+    void setDeadline(double seconds);
+
+    /**
+     * @brief The steps and depth of the last run, with its expected and actual runtime.
+     *        For a split segment, the lowest steps and depth of its chunks, and the sums
+     *        of their runtimes.
+     */
+    DiffusionRunInfo lastRunInfo() const;
+
+    /**
+     * @brief Segments longer than this many frames are split at rests, inferred up to
+     *        `maxParallelChunks()` chunks at a time and stitched back together. 0 (the
+     *        default) disables splitting.
+     */
+    int64_t maxChunkFrames() const;
+    void setMaxChunkFrames(int64_t frames);
+
+    /**
+     * @brief The maximum number of chunks of a split segment inferred at the same time;
+     *        1 (the default) infers them one after another. Applied by the next open().
+     *
+     * Every chunk in flight has acoustic and vocoder sessions of its own, so each one
+     * more keeps another copy of the models in memory.
+     */
+    int maxParallelChunks() const;
+    void setMaxParallelChunks(int count);
+
+    /**
+     * @brief Mel spectrograms longer than this many frames are split along time into chunks
+     *        sharing `vocoderChunkOverlapFrames()` frames, which are vocoded up to
+     *        `vocoderSessionCount()` at a time and crossfaded over the overlap, to bound the
+     *        memory of a run. 0 (the default) vocodes them in one piece.
+     */
+    int64_t vocoderChunkFrames() const;
+    void setVocoderChunkFrames(int64_t frames);
+    int64_t vocoderChunkOverlapFrames() const;
+    void setVocoderChunkOverlapFrames(int64_t frames);
+
+    /**
+     * @brief The number of vocoder sessions of each chunk in flight, one per vocoder chunk
+     *        vocoded at the same time; 1 (the default) vocodes them one after another.
+     *        Applied by the next open(). Each session keeps a copy of the vocoder in memory.
+     */
+    int vocoderSessionCount() const;
+    void setVocoderSessionCount(int count);
+
+    /**
+     * @brief Size of the cache of mel spectrograms in bytes; 0 (the default) disables it.
+     *        A segment whose acoustic model inputs are unchanged since a cached run is only
+     *        vocoded again. An edit of the tone shift changes the f0 of the acoustic model,
+     *        so it is not served from the cache.
+     */
+    size_t melCacheCapacity() const;
+    void setMelCacheCapacity(size_t bytes);
+
+    /**
+     * @brief Sample rate of the waveform, as in the vocoder config.
+     */
+    int sampleRate() const;
+
     //InferMap infer(const Segment &dsSegment, Status *status) override;
     bool runAndSaveAudio(const Segment &dsSegment, const std::filesystem::path &path, Status *status);
 
+    /**
+     * @brief Runs inference and writes the waveform to the sink. The sink is not closed,
+     *        so that consecutive segments can be written to the same sink.
+     */
+    bool runToSink(const Segment &dsSegment, AudioSink &sink, Status *status);
+
+    /**
+     * @brief Runs inference and returns the waveform in memory, without touching the filesystem.
+     * @return The waveform, or an empty buffer on failure.
+     */
+    AudioBuffer runToBuffer(const Segment &dsSegment, Status *status);
+
+    /**
+     * @brief Runs inference and copies the waveform to a caller-provided buffer.
+     *
+     * The waveform is produced in buffers of the library and copied into `buffer`; the
+     * runtime does not write to it directly, as flowonnx has no output binding. The size
+     * is checked against expectedSampleCount() before any model runs.
+     *
+     * @param buffer        The output buffer.
+     * @param capacity      The number of samples the buffer can hold.
+     * @param sampleCount   Receives the number of samples of the waveform. If the buffer is
+     *                      too small, the call fails without running the models, but the
+     *                      required size is still reported.
+     */
+    bool runToBuffer(const Segment &dsSegment, float *buffer, size_t capacity, size_t *sampleCount,
+                     Status *status);
+
+    /**
+     * @brief The number of samples runToBuffer() produces for the segment, computed from the
+     *        phoneme durations without running the models. Use it to size the output buffer.
+     */
+    size_t expectedSampleCount(const Segment &dsSegment) const;
+
     bool terminate() override;
 
+    TensorPoolStats tensorPoolStats() const override;
+
 protected:
     class Impl;
     std::unique_ptr<Impl> _impl;
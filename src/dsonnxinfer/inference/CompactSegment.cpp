@@ -0,0 +1,88 @@
+#include "CompactSegment_p.h"
+
+#include "PhonemeDict_p.h"
+#include "../utils/SymbolTable_p.h"
+
+DSONNXINFER_BEGIN_NAMESPACE
+
+static constexpr const char *kParameterNames[PK_Count] = {
+    "pitch", "expr", "tone_shift", "gender", "velocity",
+    "energy", "breathiness", "tension", "voicing", "mouth_opening",
+};
+
+const char *parameterName(ParameterKind kind) {
+    return kind < PK_Count ? kParameterNames[kind] : "";
+}
+
+ParameterKind parameterKind(std::string_view name) {
+    for (int i = 0; i < PK_Count; ++i) {
+        if (name == kParameterNames[i]) {
+            return static_cast<ParameterKind>(i);
+        }
+    }
+    return PK_Count;
+}
+
+CompactSegment::CompactSegment(const Segment &dsSegment, const PhonemeDict *phonemeDict) {
+    const auto &words = dsSegment.words;
+    const size_t phoneCount = dsSegment.phoneCount();
+    const size_t noteCount = dsSegment.noteCount();
+
+    wordPhones.reserve(words.size() + 1);
+    wordNotes.reserve(words.size() + 1);
+    wordDurations.reserve(words.size());
+    phoneStarts.reserve(phoneCount);
+    noteKeys.reserve(noteCount);
+    noteCents.reserve(noteCount);
+    noteDurations.reserve(noteCount);
+    noteRests.reserve(noteCount);
+    if (phonemeDict) {
+        tokens.reserve(phoneCount);
+        tokenSymbols.reserve(phoneCount);
+        languageSymbols.reserve(phoneCount);
+        multiLanguage = phonemeDict->isMultiLanguage();
+        if (multiLanguage) {
+            languages.reserve(phoneCount);
+        }
+    }
+
+    wordPhones.push_back(0);
+    wordNotes.push_back(0);
+    for (const auto &word : words) {
+        for (const auto &phone : word.phones) {
+            phoneStarts.push_back(phone.start);
+            if (phonemeDict) {
+                // Looked up only, so that the names of segments are never added to the table.
+                const auto tokenSymbol = SymbolTable::find(phone.token);
+                const auto languageSymbol = SymbolTable::find(phone.language);
+                tokenSymbols.push_back(tokenSymbol);
+                languageSymbols.push_back(languageSymbol);
+                // Unknown phonemes and languages are mapped to 0.
+                tokens.push_back(phonemeDict->phoneToken(phone, tokenSymbol, languageSymbol));
+                if (multiLanguage) {
+                    languages.push_back(phonemeDict->phoneLanguage(languageSymbol));
+                }
+            }
+        }
+        double duration = 0.0;
+        for (const auto &note : word.notes) {
+            noteKeys.push_back(note.key);
+            noteCents.push_back(note.cents);
+            noteDurations.push_back(note.duration);
+            noteRests.push_back(note.is_rest ? 1 : 0);
+            duration += note.duration;
+        }
+        wordDurations.push_back(duration);
+        wordPhones.push_back(static_cast<uint32_t>(phoneStarts.size()));
+        wordNotes.push_back(static_cast<uint32_t>(noteDurations.size()));
+    }
+
+    for (const auto &[name, param] : dsSegment.parameters) {
+        if (const auto kind = parameterKind(name); kind != PK_Count) {
+            parameters[kind] = &param;
+        }
+    }
+    speakers = &dsSegment.speakers;
+}
+
+DSONNXINFER_END_NAMESPACE
@@ -0,0 +1,93 @@
+#ifndef DS_ONNX_INFER_COMPACTSEGMENT_P_H
+#define DS_ONNX_INFER_COMPACTSEGMENT_P_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#include <dsonnxinfer/dsonnxinfer_global.h>
+#include <dsonnxinfer/DsProject.h>
+
+DSONNXINFER_BEGIN_NAMESPACE
+
+class PhonemeDict;
+
+// Parameters read by the models
+enum ParameterKind {
+    PK_Pitch = 0,
+    PK_Expr,
+    PK_ToneShift,
+    PK_Gender,
+    PK_Velocity,
+    PK_Energy,
+    PK_Breathiness,
+    PK_Tension,
+    PK_Voicing,
+    PK_MouthOpening,
+    PK_Count,
+};
+
+const char *parameterName(ParameterKind kind);
+
+// Returns PK_Count for parameters no model reads.
+ParameterKind parameterKind(std::string_view name);
+
+/**
+ * @brief Flat view of a segment for preprocessing.
+ *
+ * Phones and notes of all words are stored in flat arrays, with an offset table per
+ * word; the phones are tokenized once with the dictionary of the model. Parameters
+ * are looked up once into a table indexed by ParameterKind, which points into the
+ * source segment, so curves are not copied and the segment must outlive this view.
+ *
+ * Building the view is a single pass over the segment with one allocation per array.
+ */
+struct CompactSegment {
+    CompactSegment(const Segment &dsSegment, const PhonemeDict *phonemeDict);
+
+    size_t wordCount() const {
+        return wordDurations.size();
+    }
+
+    size_t phoneCount() const {
+        return phoneStarts.size();
+    }
+
+    size_t noteCount() const {
+        return noteDurations.size();
+    }
+
+    // Word i has the phones [wordPhones[i], wordPhones[i + 1]) and the notes [wordNotes[i], wordNotes[i + 1]).
+    std::vector<uint32_t> wordPhones;
+    std::vector<uint32_t> wordNotes;
+    std::vector<double> wordDurations;
+
+    // Empty without a dictionary; languages are only set for multi-language dictionaries.
+    std::vector<int64_t> tokens;
+    std::vector<int64_t> languages;
+    // Process-wide symbols of the token and the language of each phone, NoSymbol for names
+    // in no dictionary; empty without a dictionary.
+    std::vector<int32_t> tokenSymbols;
+    std::vector<int32_t> languageSymbols;
+    bool multiLanguage = false;
+    // Relative to the start of the word, in seconds
+    std::vector<double> phoneStarts;
+
+    std::vector<int32_t> noteKeys;
+    std::vector<int32_t> noteCents;
+    std::vector<double> noteDurations;
+    std::vector<uint8_t> noteRests;
+
+    std::array<const Parameter *, PK_Count> parameters{};
+    const SpeakerMixCurve *speakers = nullptr;
+
+    const Parameter *parameter(ParameterKind kind) const {
+        return parameters[kind];
+    }
+};
+
+DSONNXINFER_END_NAMESPACE
+
+#endif // DS_ONNX_INFER_COMPACTSEGMENT_P_H
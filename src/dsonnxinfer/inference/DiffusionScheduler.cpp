@@ -0,0 +1,203 @@
+#include "DiffusionScheduler_p.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "InferenceCommon_p.h"
+
+DSONNXINFER_BEGIN_NAMESPACE
+
+// Weight of the previous runs at each new run
+constexpr double kForgetting = 0.95;
+// Initial covariance; large, so that the first runs dominate the zero prior.
+constexpr double kInitialCovariance = 1e4;
+// Forgetting stops while the covariance is this large, so that it does not blow up
+// while the runs do not vary.
+constexpr double kMaxCovarianceTrace = 1e6;
+// The depth is not lowered below this fraction of the configured depth.
+constexpr float kMinDepthFraction = 0.1f;
+
+// Frames are counted in thousands, to keep the features in a similar range.
+static std::array<double, 3> features(int64_t frames, double iterations) {
+    const double kiloFrames = static_cast<double>(frames) / 1000.0;
+    return {1.0, kiloFrames, kiloFrames * iterations};
+}
+
+// Denoising iterations of the models for the given steps
+static double effectiveSteps(int64_t steps, bool continuousAcceleration) {
+    if (continuousAcceleration) {
+        return static_cast<double>((std::max)(steps, int64_t{1}));
+    }
+    return 1000.0 / static_cast<double>(getSpeedupFromSteps(steps));
+}
+
+DiffusionScheduler::DiffusionScheduler() {
+    reset();
+}
+
+double DiffusionScheduler::iterations(int64_t steps, float depth, bool continuousAcceleration, bool variableDepth) {
+    const double result = effectiveSteps(steps, continuousAcceleration);
+    // A DDPM model denoises from the depth, so its steps are spread over a shorter chain.
+    return variableDepth && !continuousAcceleration ? result * (std::max)(depth, 0.0f) : result;
+}
+
+double DiffusionScheduler::remaining(double deadline, std::chrono::steady_clock::time_point start) {
+    if (deadline <= 0) {
+        return std::numeric_limits<double>::infinity();
+    }
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return deadline - elapsed.count();
+}
+
+double DiffusionScheduler::share(double budget, int64_t frames, int64_t remainingFrames) {
+    if (!std::isfinite(budget) || budget <= 0 || remainingFrames <= 0 || frames >= remainingFrames) {
+        return budget;
+    }
+    return budget * static_cast<double>((std::max)(frames, int64_t{0})) / static_cast<double>(remainingFrames);
+}
+
+DiffusionRunInfo DiffusionScheduler::merge(const DiffusionRunInfo &total, const DiffusionRunInfo &chunk) {
+    if (total.steps == 0) {
+        return chunk;
+    }
+    DiffusionRunInfo result;
+    result.steps = (std::min)(total.steps, chunk.steps);
+    result.depth = (std::min)(total.depth, chunk.depth);
+    result.expectedSeconds = total.expectedSeconds < 0 || chunk.expectedSeconds < 0
+                                 ? -1.0
+                                 : total.expectedSeconds + chunk.expectedSeconds;
+    result.elapsedSeconds = total.elapsedSeconds + chunk.elapsedSeconds;
+    result.adapted = total.adapted || chunk.adapted;
+    return result;
+}
+
+double DiffusionScheduler::predict(int64_t frames, double iterations) const {
+    const auto x = features(frames, iterations);
+    return m_theta[0] * x[0] + m_theta[1] * x[1] + m_theta[2] * x[2];
+}
+
+DiffusionPlan DiffusionScheduler::plan(int64_t frames, double budget, int64_t steps, float depth,
+                                       bool continuousAcceleration, bool variableDepth) const {
+    const auto iterationsOf = [continuousAcceleration, variableDepth](int64_t s, float d) {
+        return iterations(s, d, continuousAcceleration, variableDepth);
+    };
+
+    DiffusionPlan result;
+    result.frames = frames;
+    result.info.steps = steps;
+    result.info.depth = depth;
+    result.iterations = iterationsOf(steps, depth);
+    result.start = std::chrono::steady_clock::now();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_runs == 0) {
+        return result;
+    }
+    result.info.expectedSeconds = predict(frames, result.iterations);
+    // Without a deadline, or if more iterations are not expected to cost more, keep the
+    // configured values.
+    if (!std::isfinite(budget) || result.info.expectedSeconds <= budget || m_theta[2] <= 0 || frames <= 0) {
+        return result;
+    }
+
+    // The most steps that fit, and then, if it saves time, the deepest depth at one step.
+    int64_t chosenSteps = 1;
+    for (int64_t s = steps - 1; s > 1; --s) {
+        if (predict(frames, iterationsOf(s, depth)) <= budget) {
+            chosenSteps = s;
+            break;
+        }
+    }
+    float chosenDepth = depth;
+    if (variableDepth && !continuousAcceleration && chosenSteps == 1) {
+        const double perDepth = iterationsOf(1, 1.0f);
+        const auto x = features(frames, perDepth);
+        const double fitting = (budget - m_theta[0] * x[0] - m_theta[1] * x[1]) / (m_theta[2] * x[2]);
+        chosenDepth = static_cast<float>(
+                std::clamp(fitting, static_cast<double>(depth * kMinDepthFraction), static_cast<double>(depth)));
+    }
+
+    result.info.steps = chosenSteps;
+    result.info.depth = chosenDepth;
+    result.info.adapted = chosenSteps != steps || chosenDepth != depth;
+    result.iterations = iterationsOf(chosenSteps, chosenDepth);
+    result.info.expectedSeconds = predict(frames, result.iterations);
+    return result;
+}
+
+DiffusionRunInfo DiffusionScheduler::finish(DiffusionPlan plan, bool observe) {
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - plan.start;
+    plan.info.elapsedSeconds = elapsed.count();
+    if (observe) {
+        this->observe(plan.frames, plan.iterations, plan.info.elapsedSeconds);
+    }
+    setLastRun(plan.info);
+    return plan.info;
+}
+
+void DiffusionScheduler::observe(int64_t frames, double iterations, double seconds) {
+    if (frames <= 0) {
+        return;
+    }
+
+    // Recursive least squares update
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const auto x = features(frames, iterations);
+    std::array<double, 3> px{};
+    for (size_t i = 0; i < 3; ++i) {
+        for (size_t j = 0; j < 3; ++j) {
+            px[i] += m_covariance[i][j] * x[j];
+        }
+    }
+    double trace = 0.0;
+    for (size_t i = 0; i < 3; ++i) {
+        trace += m_covariance[i][i];
+    }
+    const double lambda = trace < kMaxCovarianceTrace ? kForgetting : 1.0;
+    const double denominator = lambda + x[0] * px[0] + x[1] * px[1] + x[2] * px[2];
+    const double error = seconds - predict(frames, iterations);
+    for (size_t i = 0; i < 3; ++i) {
+        m_theta[i] += px[i] / denominator * error;
+    }
+    for (size_t i = 0; i < 3; ++i) {
+        for (size_t j = 0; j < 3; ++j) {
+            m_covariance[i][j] = (m_covariance[i][j] - px[i] * px[j] / denominator) / lambda;
+        }
+    }
+    ++m_runs;
+}
+
+DiffusionScheduler::Coefficients DiffusionScheduler::coefficients() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_theta;
+}
+
+void DiffusionScheduler::setCoefficients(const Coefficients &theta) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_theta = theta;
+    m_runs = (std::max)(m_runs, size_t{1});
+}
+
+DiffusionRunInfo DiffusionScheduler::lastRun() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_lastRun;
+}
+
+void DiffusionScheduler::setLastRun(const DiffusionRunInfo &info) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_lastRun = info;
+}
+
+void DiffusionScheduler::reset() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_theta = {};
+    for (size_t i = 0; i < 3; ++i) {
+        m_covariance[i] = {};
+        m_covariance[i][i] = kInitialCovariance;
+    }
+    m_runs = 0;
+    m_lastRun = {};
+}
+
+DSONNXINFER_END_NAMESPACE
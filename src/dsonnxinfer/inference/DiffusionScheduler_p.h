@@ -0,0 +1,91 @@
+#ifndef DS_ONNX_INFER_DIFFUSIONSCHEDULER_P_H
+#define DS_ONNX_INFER_DIFFUSIONSCHEDULER_P_H
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+#include <dsonnxinfer/dsonnxinfer_global.h>
+#include <dsonnxinfer/IInference.h>
+
+DSONNXINFER_BEGIN_NAMESPACE
+
+struct DiffusionPlan {
+    DiffusionRunInfo info;
+    int64_t frames = 0;
+    // Denoising iterations per frame: the effective steps, times the depth if it shortens
+    // the sampling
+    double iterations = 0.0;
+    std::chrono::steady_clock::time_point start;
+};
+
+/**
+ * @brief Picks the steps and depth of diffusion runs to meet a latency deadline.
+ *
+ * The runtime of the models after preprocessing is modeled as
+ * `a + b * frames + c * frames * iterations`, fitted by recursive least squares over the
+ * runs of the inference object, with older runs gradually forgotten. For a deadline, the
+ * steps are lowered until the expected runtime fits, and then, if the depth shortens the
+ * sampling, the depth. Until a run has been observed, the configured values are used.
+ */
+class DiffusionScheduler {
+public:
+    using Coefficients = std::array<double, 3>;
+
+    DiffusionScheduler();
+
+    DSONNXINFER_DISABLE_COPY_MOVE(DiffusionScheduler)
+
+    /**
+     * @brief Plans a run of `frames` frames that must end within `budget` seconds (infinite
+     *        for no deadline). `steps` and `depth` are the configured values and upper bounds.
+     */
+    DiffusionPlan plan(int64_t frames, double budget, int64_t steps, float depth,
+                       bool continuousAcceleration, bool variableDepth) const;
+
+    // Records the runtime of a planned run, and learns from it if `observe` is set.
+    // Returns the run info, with the runtime.
+    DiffusionRunInfo finish(DiffusionPlan plan, bool observe);
+
+    // Updates the fit with a run of `frames` frames and `iterations` iterations per frame.
+    void observe(int64_t frames, double iterations, double seconds);
+
+    // `a`, `b` and `c` of the cost model, with the frames in thousands
+    Coefficients coefficients() const;
+    // Replaces the fit, which is then used as if runs had been observed.
+    void setCoefficients(const Coefficients &theta);
+
+    DiffusionRunInfo lastRun() const;
+    void setLastRun(const DiffusionRunInfo &info);
+    void reset();
+
+    // Denoising iterations per frame of a run, as used by the cost model. For continuous
+    // acceleration models, the depth only moves the start of the ODE solver, which still
+    // takes `steps` iterations.
+    static double iterations(int64_t steps, float depth, bool continuousAcceleration, bool variableDepth);
+
+    // Seconds left before a deadline that started at `start`; infinite for no deadline.
+    static double remaining(double deadline, std::chrono::steady_clock::time_point start);
+
+    // Share of `budget` seconds for `frames` out of `remainingFrames` frames still to run.
+    static double share(double budget, int64_t frames, int64_t remainingFrames);
+
+    // Combines the run infos of the chunks of a segment: the lowest steps and depth, and
+    // the total runtimes.
+    static DiffusionRunInfo merge(const DiffusionRunInfo &total, const DiffusionRunInfo &chunk);
+
+private:
+    double predict(int64_t frames, double iterations) const;
+
+    mutable std::mutex m_mutex;
+    Coefficients m_theta;
+    std::array<std::array<double, 3>, 3> m_covariance;
+    size_t m_runs = 0;
+    DiffusionRunInfo m_lastRun;
+};
+
+DSONNXINFER_END_NAMESPACE
+
+#endif // DS_ONNX_INFER_DIFFUSIONSCHEDULER_P_H
@@ -7,6 +7,13 @@
 
 #include <flowonnx/inference.h>
 #include "InferenceCommon_p.h"
+#include "CompactSegment_p.h"
+#include "PhonemeDict_p.h"
+#include "TensorPool_p.h"
+#include "RunLimiter_p.h"
+#include "ModelVariant_p.h"
+#include "InputPlan_p.h"
+#include "../core/Placement_p.h"
 
 DSONNXINFER_BEGIN_NAMESPACE
 
@@ -16,38 +23,51 @@ public:
             inferenceHandle("ds_duration") {}
 
     Status open() {
-        if (dsDurConfig.features & kfMultiLanguage) {
-            readLangIdFile(dsDurConfig.languages, languages);
-        }
-        if (isFileExtJson(dsDurConfig.phonemes)) {
-            readMultiLangPhonemesFile(dsDurConfig.phonemes, name2token);
-        } else {
-            readPhonemesFile(dsDurConfig.phonemes, name2token);
-        }
-
         std::string errorMessage;
-        if (!inferenceHandle.open({{dsDurConfig.linguistic, false}, {dsDurConfig.dur, false}}, &errorMessage)) {
+        phonemeDict = PhonemeDict::load(dsDurConfig.phonemes, dsDurConfig.languages,
+                                        dsDurConfig.features & kfMultiLanguage, &errorMessage);
+        if (!phonemeDict) {
             return {Status_ModelLoadError, errorMessage};
         }
 
-        return {Status_Ok, ""};
+        const auto dur = selectModelVariant(dsDurConfig.dur, dsDurConfig.durVariants, options);
+        inputPlan = InputPlan::forDuration(dsDurConfig);
+        if (auto s = inputPlan.validate(dsDurConfig.dur, dur, "duration"); !s.isOk()) {
+            return s;
+        }
+
+        // The session threads inherit the placement of this thread.
+        Placement::Scope placement(options.numaNode);
+        const ModelList reference = {{dsDurConfig.linguistic, false}, {dsDurConfig.dur, false}};
+        const ModelList selected = {
+            {selectModelVariant(dsDurConfig.linguistic, dsDurConfig.linguisticVariants, options), false},
+            {dur, false},
+        };
+        return openModelVariants(inferenceHandle, reference, selected, options, [this](Status *status) {
+            return infer(*options.precisionProbe, status);
+        });
     }
 
     void close() {
         inferenceHandle.close();
+        inputPlan = {};
         dsDurConfig = {};
-        name2token.clear();
-        languages.clear();
+        phonemeDict.reset();
+        tensorPool.clear();
     }
 
     InferMap infer(const Segment &dsSegment, Status *status) {
+        TensorPool::Scope poolScope(&tensorPool);
+        Placement::Scope placement(options.numaNode);
+
         int sampleRate = dsDurConfig.sampleRate;
         int hopSize = dsDurConfig.hopSize;
         double frameLength = 1.0 * hopSize / sampleRate;
         bool predictDur = dsDurConfig.features & kfLinguisticPredictDur;
 
-        auto linguisticInputData = linguisticPreprocess(name2token, languages, dsSegment, frameLength, predictDur);
-        auto durInputData = durPreprocess(dsSegment, dsDurConfig);
+        const CompactSegment segment(dsSegment, phonemeDict.get());
+        auto linguisticInputData = linguisticPreprocess(segment, frameLength, predictDur);
+        auto durInputData = durPreprocess(segment, inputPlan);
 
 
         flowonnx::InferenceData dataLinguistic, dataDur;
@@ -58,10 +78,18 @@ public:
         dataDur.inputData = std::move(durInputData);
         dataDur.outputNames.emplace_back("ph_dur_pred");
 
-        std::vector dataList{dataLinguistic, dataDur};
+        std::vector<flowonnx::InferenceData> dataList;
+        dataList.reserve(2);
+        dataList.push_back(std::move(dataLinguistic));
+        dataList.push_back(std::move(dataDur));
 
         std::string errorMessage;
-        auto result = inferenceHandle.run(dataList, &errorMessage);
+        flowonnx::TensorMap result;
+        {
+            RunLimiter::Slot runSlot(options.limitConcurrentRuns);
+            result = inferenceHandle.run(dataList, &errorMessage);
+        }
+        tensorPool.recycle(dataList);
 
         if (status) {
             if (result.empty()) {
@@ -80,8 +108,10 @@ public:
     }
 
     DsDurConfig dsDurConfig;
-    std::unordered_map<std::string, int64_t> name2token;
-    std::unordered_map<std::string, int64_t> languages;
+    InputPlan inputPlan;
+    std::shared_ptr<const PhonemeDict> phonemeDict;
+    TensorPool tensorPool;
+    InferenceOptions options;
     flowonnx::Inference inferenceHandle;
 };
 
@@ -103,6 +133,7 @@ DurationInference::DurationInference(const DsDurConfig &dsDurConfig)
 
 Status DurationInference::open() {
     auto &impl = *_impl;
+    impl.options = m_options;
     return impl.open();
 }
 
@@ -149,11 +180,17 @@ bool DurationInference::runInPlace(Segment &dsSegment, Status *status) {
             }
             begin = end;
         }
+        impl.tensorPool.recycle(result);
         return true;
     }
     return false;
 }
 
+TensorPoolStats DurationInference::tensorPoolStats() const {
+    auto &impl = *_impl;
+    return impl.tensorPool.stats();
+}
+
 bool DurationInference::terminate() {
     auto &impl = *_impl;
     return impl.terminate();
@@ -13,6 +13,7 @@ public:
     explicit DurationInference(const DsDurConfig &dsDurConfig);
     ~DurationInference() override;
 
+    using IInference::open;
     Status open() override;
     void close() override;
 
@@ -20,6 +21,8 @@ public:
     bool runInPlace(Segment &dsSegment, Status *status);
     bool terminate() override;
 
+    TensorPoolStats tensorPoolStats() const override;
+
 protected:
     class Impl;
     std::unique_ptr<Impl> _impl;
@@ -6,5 +6,22 @@ IInference::IInference() : m_type(IT_Unknown) {}
 
 IInference::~IInference() = default;
 
+Status IInference::open(const InferenceOptions &options) {
+    setOptions(options);
+    return open();
+}
+
+TensorPoolStats IInference::tensorPoolStats() const {
+    return {};
+}
+
+InferenceOptions IInference::options() const {
+    return m_options;
+}
+
+void IInference::setOptions(const InferenceOptions &options) {
+    m_options = options;
+}
+
 DSONNXINFER_END_NAMESPACE
 
@@ -1,6 +1,9 @@
 #ifndef DS_ONNX_INFER_IINFERENCE_H
 #define DS_ONNX_INFER_IINFERENCE_H
 
+#include <cstddef>
+#include <cstdint>
+#include <memory>
 
 #include <dsonnxinfer/dsonnxinfer_global.h>
 #include <dsonnxinfer/Status.h>
@@ -18,6 +21,58 @@ enum InferenceType {
     IT_MultiVariance,
 };
 
+struct TensorPoolStats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    // Bytes of idle buffers kept in the pool
+    size_t pooledBytes = 0;
+    // Peak bytes of the buffers held by the pool and by the tensors drawn from it
+    size_t peakBytes = 0;
+};
+
+// Steps and depth of the last diffusion run of an inference object
+struct DiffusionRunInfo {
+    int64_t steps = 0;
+    float depth = 0.0f;
+    // Runtime the cost model expected for these values, or -1 if it had no estimate
+    double expectedSeconds = -1.0;
+    // Runtime of the models, after preprocessing
+    double elapsedSeconds = 0.0;
+    // Whether the steps or the depth were lowered to meet the deadline
+    bool adapted = false;
+};
+
+enum PrecisionPolicy {
+    // Always the float32 reference models
+    PP_QualityFirst = 0,
+    // The variants of `InferenceOptions::precision`, where available
+    PP_Explicit,
+    // The fastest variants available for the execution provider
+    PP_Fastest,
+};
+
+struct InferenceOptions {
+    // Whether the runs of this object count against Environment::maxConcurrentRuns().
+    bool limitConcurrentRuns = true;
+    // NUMA node the sessions and the runs of this object are placed on; -1 for no placement.
+    int numaNode = -1;
+    // Whether the pitch and the variance model share their linguistic encoder if both use the
+    // same one, so that it runs once per segment. Off by default, which keeps the encoder and
+    // the downstream model in one session per object.
+    bool shareLinguisticEncoder = false;
+
+    PrecisionPolicy precisionPolicy = PP_QualityFirst;
+    ModelPrecision precision = MP_Float32;
+    // If set, open() runs this (short) segment on the reference models and on the selected
+    // variants, and falls back to the reference models if the relative RMS error of the
+    // outputs exceeds the run-to-run variation of the reference by more than the tolerance.
+    std::shared_ptr<const Segment> precisionProbe;
+    double precisionTolerance = 0.05;
+    // Whether open() runs the precision probe. If not, the selected variants are used unchecked,
+    // for example when they have been checked by another object with the same models.
+    bool runPrecisionProbe = true;
+};
+
 class DSONNXINFER_EXPORT IInference {
 public:
     IInference();
@@ -25,12 +80,25 @@ public:
 
 public:
     virtual Status open() = 0;
+    Status open(const InferenceOptions &options);
     virtual void close() = 0;
     //virtual InferMap infer(const Segment &dsSegment, Status *status) = 0;
     virtual bool terminate() = 0;
 
+    /**
+     * @brief Counters of the tensor buffer pool of this inference object.
+     */
+    virtual TensorPoolStats tensorPoolStats() const;
+
+    /**
+     * @brief Options of this object, applied by the next open().
+     */
+    InferenceOptions options() const;
+    void setOptions(const InferenceOptions &options);
+
 protected:
     InferenceType m_type;
+    InferenceOptions m_options;
 };
 
 DSONNXINFER_END_NAMESPACE
@@ -1,5 +1,6 @@
 #include "InferenceCommon_p.h"
 
+#include <functional>
 #include <iterator>
 #include <numeric>
 #include <unordered_map>
@@ -15,6 +16,14 @@
 #include <dsonnxinfer/SampleCurve.h>
 #include <dsonnxinfer/SpeakerEmbed.h>
 
+#include "PhonemeDict_p.h"
+#include "TensorPool_p.h"
+#include "InputPlan_p.h"
+#include "CompactSegment_p.h"
+#include "../core/CurveKernels_p.h"
+#include "../utils/Fnv1a_p.h"
+#include <dsonnxinfer/TaskPool.h>
+
 
 DSONNXINFER_BEGIN_NAMESPACE
 
@@ -39,148 +48,182 @@ template<typename T>
 void fillRestMidiWithNearestInPlace(std::vector<T> &src, T restMidi = 0);
 
 
+// Creates an uninitialized tensor, drawing its buffer from the current tensor pool.
+template<typename T>
+Tensor makeTensor(size_t count, std::vector<int64_t> shape) {
+    Tensor t;
+    t.data = acquireTensorBuffer(count * sizeof(T));
+    t.shape = std::move(shape);
+    if constexpr (std::is_same_v<T, float>) {
+        t.type = Tensor::Float;
+    } else if constexpr (std::is_same_v<T, int64_t>) {
+        t.type = Tensor::Int64;
+    } else if constexpr (std::is_same_v<T, bool>) {
+        t.type = Tensor::Bool;
+    }
+    return t;
+}
+
+// Creates a {1, length} tensor filled with `value`. If the model broadcasts constant inputs
+// (kfBroadcastConstants), a {1, 1} tensor is created instead.
+template<typename T>
+Tensor makeConstantTensor(T value, int64_t length, dsfeature_t features) {
+    if (features & kfBroadcastConstants) {
+        length = 1;
+    }
+    Tensor t = makeTensor<T>(length, {1, length});
+    T *buf;
+    t.getDataBuffer<T>(&buf);
+    std::fill(buf, buf + length, value);
+    return t;
+}
+
+// Below this number of frames, independent inputs are computed on the calling thread.
+constexpr int64_t kParallelPreprocessFrames = 2048;
+
+// Pitch curves are kept within the MIDI note range before they reach a model, so a stray
+// point or a large tone shift cannot produce an unbounded f0.
+constexpr double kMinMidiPitch = 0.0;
+constexpr double kMaxMidiPitch = 127.0;
+
+static inline void clampMidiPitch(std::vector<double> &samples) {
+    CurveKernels::clamp(samples.data(), samples.size(), kMinMidiPitch, kMaxMidiPitch, samples.data());
+}
+
+// Independent input tensors of a preprocessing step, computed in parallel on the task pool
+// if the segment is long enough.
+class ParallelInputs {
+public:
+    explicit ParallelInputs(int64_t frameCount) : m_frameCount(frameCount) {
+    }
+
+    void add(std::string name, std::function<Tensor()> fn) {
+        m_names.push_back(std::move(name));
+        m_tasks.push_back(std::move(fn));
+    }
+
+    void run(InferMap &m) {
+        std::vector<Tensor> results(m_tasks.size());
+        if (m_tasks.size() > 1 && m_frameCount >= kParallelPreprocessFrames) {
+            // The tensor pool scope is per thread, so hand it over to the workers.
+            const auto pool = TensorPool::current();
+            TaskPool::global().parallelFor(m_tasks.size(), [&](size_t i) {
+                TensorPool::Scope poolScope(pool);
+                results[i] = m_tasks[i]();
+            });
+        } else {
+            for (size_t i = 0; i < m_tasks.size(); ++i) {
+                results[i] = m_tasks[i]();
+            }
+        }
+        for (size_t i = 0; i < results.size(); ++i) {
+            m[m_names[i]] = std::move(results[i]);
+        }
+    }
+
+private:
+    int64_t m_frameCount;
+    std::vector<std::string> m_names;
+    std::vector<std::function<Tensor()>> m_tasks;
+};
+
+// The speaker mix of the IS_SpeakerEmbed slot of a plan, {1, N, SPK_EMBED_SIZE}
+static Tensor makeSpeakerEmbed(const InputPlan &plan, const CompactSegment &segment, double frameLength, int64_t targetLength) {
+    auto spkEmbed = makeTensor<float>(targetLength * SPK_EMBED_SIZE, {int64_t{1}, targetLength, static_cast<int64_t>(SPK_EMBED_SIZE)});
+    float *spkEmbedBuffer;
+    spkEmbed.getDataBuffer<float>(&spkEmbedBuffer);
+    getSpkMix(plan.spkEmb, plan.speakers, *segment.speakers, frameLength, targetLength, spkEmbedBuffer);
+    return spkEmbed;
+}
+
 template<typename T>
 Tensor toInferDataInPlace(std::vector<T> &&v) {
     int64_t size = v.size();
-    int64_t shape[2] = {1, size};
-    return Tensor::create(v.data(), v.size(), shape, 2);
+    Tensor t = makeTensor<T>(v.size(), {1, size});
+    T *buf;
+    t.getDataBuffer<T>(&buf);
+    std::copy(v.begin(), v.end(), buf);
+    return t;
 }
 
 template<typename T>
 Tensor toInferDataAndResizeInPlace(std::vector<T> &&v, int64_t targetLength, T val) {
-    int64_t shape[2] = {1, targetLength};
-    if (targetLength > v.size()) {
-        v.resize(targetLength, val);
-    }
-    return Tensor::create(v.data(), targetLength, shape, 2);
+    Tensor t = makeTensor<T>(targetLength, {1, targetLength});
+    T *buf;
+    t.getDataBuffer<T>(&buf);
+    const auto copied = (std::min)(static_cast<int64_t>(v.size()), targetLength);
+    std::copy(v.begin(), v.begin() + copied, buf);
+    std::fill(buf + copied, buf + targetLength, val);
+    return t;
 }
 
 template<typename T_Src, typename T_Dst>
 Tensor toInferDataAsType(const std::vector<T_Src> &v) {
-    Tensor t;
-    t.data.resize(v.size() * sizeof(T_Dst));
+    Tensor t = makeTensor<T_Dst>(v.size(), {1, static_cast<int64_t>(v.size())});
     T_Dst *buf;
     t.getDataBuffer<T_Dst>(&buf);
 
-    for (const auto &item : v) {
-        *(buf++) = static_cast<T_Dst>(item);
-    }
-
-    t.shape = {1, static_cast<int64_t>(v.size())};
-    if constexpr (std::is_same_v<T_Dst, float>) {
-        t.type = Tensor::Float;
-    } else if constexpr (std::is_same_v<T_Dst, int64_t>) {
-        t.type = Tensor::Int64;
-    } else if constexpr (std::is_same_v<T_Dst, bool>) {
-        t.type = Tensor::Bool;
+    if constexpr (std::is_same_v<T_Src, double> && std::is_same_v<T_Dst, float>) {
+        CurveKernels::toFloat(v.data(), v.size(), buf);
+    } else {
+        for (const auto &item : v) {
+            *(buf++) = static_cast<T_Dst>(item);
+        }
     }
     return t;
 }
 
 template<typename T_Src, typename T_Dst>
 Tensor toInferDataAsTypeAndResize(const std::vector<T_Src> &v, int64_t targetLength, T_Dst val) {
-    int64_t shape[2] = {1, targetLength};
-
-    if (v.empty()) {
-        std::vector<T_Dst> v2(targetLength, val);
-        return Tensor::create(v2.data(), v2.size(), shape, 2);
-    }
-
-    const int64_t len = v.size();
-    if (targetLength <= len) {
-        std::vector<T_Dst> v2(v.begin(), v.begin() + targetLength);
-        return Tensor::create(v2.data(), v2.size(), shape, 2);
+    Tensor t = makeTensor<T_Dst>(targetLength, {1, targetLength});
+    T_Dst *buf;
+    t.getDataBuffer<T_Dst>(&buf);
+    const auto copied = (std::min)(static_cast<int64_t>(v.size()), targetLength);
+    if constexpr (std::is_same_v<T_Src, double> && std::is_same_v<T_Dst, float>) {
+        CurveKernels::toFloat(v.data(), copied, buf);
+    } else {
+        std::transform(v.begin(), v.begin() + copied, buf, [](const T_Src &item) { return static_cast<T_Dst>(item); });
     }
-
-    std::vector<T_Dst> v2(v.begin(), v.end());
-    v2.resize(targetLength, val);
-    return Tensor::create(v2.data(), v2.size(), shape, 2);
+    std::fill(buf + copied, buf + targetLength, val);
+    return t;
 }
 
-
-Tensor parsePhonemeTokens(
-        const Segment &dsSegment,
-        const std::unordered_map<std::string, int64_t> &name2token) {
-
-    std::vector<int64_t> tokens;
-    tokens.reserve(dsSegment.phoneCount());
-    for (const auto &word : dsSegment.words) {
-        for (const auto &phone : word.phones) {
-            // tokens
-            std::string tokenWithLang =
-                    (phone.language.empty() || phone.token == "SP" || phone.token == "AP") ?
-                    phone.token :
-                    (phone.language + '/' + phone.token);
-            if (const auto it = name2token.find(tokenWithLang); it != name2token.end()) {
-                // first try finding the phoneme with the language tag (lang/phoneme)
-                tokens.push_back(it->second);
-            } else if (const auto it2 = name2token.find(phone.token); it2 != name2token.end()) {
-                // then try finding the phoneme without the language tag (phoneme)
-                tokens.push_back(it2->second);
-            } else {
-                // TODO: error handling
-                tokens.push_back(0);
-            }
-        }
-    }
-    return toInferDataInPlace(std::move(tokens));
+// f0 tensor of a pitch curve: 2^(midiPitch * scale + bias) per frame
+static Tensor toFrequencyTensor(const std::vector<double> &midiPitch, double scale, double bias) {
+    Tensor t = makeTensor<float>(midiPitch.size(), {1, static_cast<int64_t>(midiPitch.size())});
+    float *buf;
+    t.getDataBuffer<float>(&buf);
+    CurveKernels::exp2Affine(midiPitch.data(), midiPitch.size(), scale, bias, buf);
+    return t;
 }
 
 
-Tensor parsePhonemeLanguages(
-        const Segment &dsSegment,
-        const std::unordered_map<std::string, int64_t> &languages) {
-
-    std::vector<int64_t> lang;
-    lang.reserve(dsSegment.phoneCount());
-    for (const auto &word : dsSegment.words) {
-        for (const auto &phone : word.phones) {
-            // tokens
-            if (const auto it = languages.find(phone.language); it != languages.end()) {
-                lang.push_back(it->second);
-            } else {
-                // TODO: error handling
-                lang.push_back(0);
-            }
-        }
-    }
-    return toInferDataInPlace(std::move(lang));
-}
-
 Tensor parsePhonemeDurations(
-        const Segment &dsSegment,
+        const CompactSegment &segment,
         double frameLength) {
-    auto phoneCount = dsSegment.phoneCount();
-
     std::vector<int64_t> durations;
-    durations.reserve(phoneCount);
+    durations.reserve(segment.phoneCount());
 
     double phoneDurSum = 0.0;
 
-    for (size_t currWordIndex = 0; currWordIndex < dsSegment.words.size(); ++currWordIndex) {
-        const auto &word = dsSegment.words[currWordIndex];
-        auto wordDuration = word.duration();
-
-        for (size_t i = 0; i < word.phones.size(); ++i) {
-
-            // durations
-            {
-                bool currPhoneIsTheLastPhone = (i == word.phones.size() - 1);
-                auto currPhoneStart = phoneDurSum +
-                                      word.phones[i].start;
-                auto nextPhoneStart = phoneDurSum +
-                                      (currPhoneIsTheLastPhone ? wordDuration : word.phones[i + 1].start);
-                if (currPhoneIsTheLastPhone && (currWordIndex + 1 < dsSegment.words.size())) {
-                    // If current word is not the last word
-                    const auto &nextWord = dsSegment.words[currWordIndex + 1];
-                    if (!nextWord.phones.empty()) {
-                        nextPhoneStart += nextWord.phones[0].start;
-                    }
+    const auto &starts = segment.phoneStarts;
+    for (size_t currWordIndex = 0; currWordIndex < segment.wordCount(); ++currWordIndex) {
+        const auto wordDuration = segment.wordDurations[currWordIndex];
+        const size_t phoneEnd = segment.wordPhones[currWordIndex + 1];
+
+        for (size_t i = segment.wordPhones[currWordIndex]; i < phoneEnd; ++i) {
+            bool currPhoneIsTheLastPhone = (i + 1 == phoneEnd);
+            auto currPhoneStart = phoneDurSum + starts[i];
+            auto nextPhoneStart = phoneDurSum + (currPhoneIsTheLastPhone ? wordDuration : starts[i + 1]);
+            if (currPhoneIsTheLastPhone && (currWordIndex + 1 < segment.wordCount())) {
+                // If current word is not the last word, and the next word has phones
+                if (segment.wordPhones[currWordIndex + 2] > phoneEnd) {
+                    nextPhoneStart += starts[phoneEnd];
                 }
-                int64_t currPhoneStartFrames = std::llround(currPhoneStart / frameLength);
-                int64_t nextPhoneStartFrames = std::llround(nextPhoneStart / frameLength);
-                durations.push_back(nextPhoneStartFrames - currPhoneStartFrames);
             }
+            int64_t currPhoneStartFrames = std::llround(currPhoneStart / frameLength);
+            int64_t nextPhoneStartFrames = std::llround(nextPhoneStart / frameLength);
+            durations.push_back(nextPhoneStartFrames - currPhoneStartFrames);
         }
         phoneDurSum += wordDuration;
     }
@@ -188,13 +231,92 @@ Tensor parsePhonemeDurations(
     return toInferDataInPlace(std::move(durations));
 }
 
+// The retake mask of a parameter, rescaled to `nFrames` frames of `frameLength`
+static void fillRetake(const Parameter &param, double frameLength, int64_t nFrames,
+                       std::vector<unsigned char>::iterator row) {
+    const auto toFrames = [&param, frameLength, nFrames](int64_t index) {
+        return std::clamp(
+                static_cast<int64_t>(std::llround(static_cast<double>(index) * param.sample_curve.timestep / frameLength)),
+                int64_t{0},
+                nFrames);
+    };
+    std::fill(row + toFrames(param.retake_start), row + toFrames(param.retake_end), 1);
+}
+
+// Adds the inputs of the slots that all frame-level models read the same way. Parameters
+// are resampled on the task pool when `inputs` runs; required parameters that are missing
+// are added to `missingParameters`.
+static void addSlotInputs(
+        const CompactSegment &segment,
+        const InputPlan &plan,
+        double frameLength,
+        int64_t nFrames,
+        InferMap &m,
+        ParallelInputs &inputs,
+        std::vector<std::string> &missingParameters) {
+    std::vector<unsigned char> retake(plan.predictedCount * nFrames);
+    size_t predictedIndex = 0;
+    for (const auto &slot : plan.slots) {
+        switch (slot.source) {
+            case IS_Parameter: {
+                const auto found = segment.parameter(slot.parameter);
+                if (found && found->tag == slot.name) {
+                    const auto &param = *found;
+                    inputs.add(slot.name, [&param, frameLength, nFrames] {
+                        return toInferDataAsType<double, float>(param.sample_curve.resample(frameLength, nFrames));
+                    });
+                } else if (slot.required) {
+                    missingParameters.push_back(slot.name);
+                } else {
+                    m[slot.name] = makeConstantTensor(slot.fallback, nFrames, plan.features);
+                }
+                break;
+            }
+            case IS_PredictedParameter: {
+                const auto row = retake.begin() + nFrames * predictedIndex++;
+                if (const auto param = segment.parameter(slot.parameter)) {
+                    const auto &p = *param;
+                    inputs.add(slot.name, [&p, frameLength, nFrames] {
+                        return toInferDataAsType<double, float>(p.sample_curve.resample(frameLength, nFrames));
+                    });
+                    fillRetake(p, frameLength, nFrames, row);
+                } else {
+                    // Predicted from scratch
+                    m[slot.name] = makeConstantTensor(slot.fallback, nFrames, plan.features);
+                    std::fill(row, row + nFrames, 1);
+                }
+                break;
+            }
+            case IS_Retake: {
+                auto retakeTensor = toInferDataAsType<unsigned char, bool>(retake);
+                if (slot.rank == 3) {
+                    auto numParams = static_cast<int64_t>(plan.predictedCount);
+                    retakeTensor.shape = {int64_t{1}, static_cast<int64_t>(retake.size()) / numParams, numParams};
+                }
+                m[slot.name] = std::move(retakeTensor);
+                break;
+            }
+            case IS_PhonemeDurations:
+                m[slot.name] = parsePhonemeDurations(segment, frameLength);
+                break;
+            case IS_SpeakerEmbed:
+                // {1, N, 256}
+                inputs.add(slot.name, [&plan, &segment, frameLength, nFrames] {
+                    return makeSpeakerEmbed(plan, segment, frameLength, nFrames);
+                });
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+
 
 
 InferMap acousticPreprocess(
-        const std::unordered_map<std::string, int64_t> &name2token,
-        const std::unordered_map<std::string, int64_t> &languages,
-        const Segment &dsSegment,
-        const DsConfig &dsConfig,
+        const CompactSegment &segment,
+        const InputPlan &plan,
         double frameLength,
         double transpose,
         bool applyToneShift,
@@ -203,13 +325,12 @@ InferMap acousticPreprocess(
 
     InferMap m;
 
-    bool isMultiLang = !languages.empty();
-    m["tokens"] = parsePhonemeTokens(dsSegment, name2token);
-    if (isMultiLang) {
-        m["languages"] = parsePhonemeLanguages(dsSegment, languages);
+    m["tokens"] = toInferDataAsType<int64_t, int64_t>(segment.tokens);
+    if (segment.multiLanguage) {
+        m["languages"] = toInferDataAsType<int64_t, int64_t>(segment.languages);
     }
 
-    auto durations = parsePhonemeDurations(dsSegment, frameLength);
+    auto durations = parsePhonemeDurations(segment, frameLength);
 
     const int64_t *buffer;
     const auto bufferSize = durations.getDataBuffer<int64_t>(&buffer);
@@ -218,35 +339,38 @@ InferMap acousticPreprocess(
     m["durations"] = durations;
 
     bool hasPitch = false;
-    if (auto it = dsSegment.parameters.find("pitch"); it != dsSegment.parameters.end()) {
-        const auto &param = it->second;
+    if (const auto pitch = segment.parameter(PK_Pitch)) {
+        const auto &param = *pitch;
         if (param.tag == "pitch") {
             auto samples = param.sample_curve.resample(frameLength, targetLength);
-            std::transform(samples.begin(), samples.end(), samples.begin(), [transpose](double midiPitch) {
-                constexpr double referenceFrequency = 440.0;
-                constexpr double semitonesInOctave = 12.0;
-                constexpr double midiPitchOffset = 69.0;
-                return (referenceFrequency *
-                        std::pow(2.0, (midiPitch - midiPitchOffset + transpose) / semitonesInOctave));
-            });
+            clampMidiPitch(samples);
+            // f0 = 440 * 2^((midiPitch - 69 + transpose) / 12), as exp2 of an affine transform
+            constexpr double referenceFrequency = 440.0;
+            constexpr double semitonesInOctave = 12.0;
+            constexpr double midiPitchOffset = 69.0;
+            const double scale = 1.0 / semitonesInOctave;
+            const double bias = std::log2(referenceFrequency) + (transpose - midiPitchOffset) / semitonesInOctave;
+            m["f0"] = toFrequencyTensor(samples, scale, bias);
+            // The vocoder keeps the original pitch, and the acoustic model gets the shifted
+            // f0, which shifts the formants.
             if (outOriginalF0 != nullptr) {
-                *outOriginalF0 = toInferDataAsType<double, float>(samples);;
+                *outOriginalF0 = m["f0"];
             }
             if (applyToneShift) {
-                if (const auto it2 = dsSegment.parameters.find("tone_shift"); it2 != dsSegment.parameters.end()) {
-                    const auto &toneShift = it2->second.sample_curve;
-                    if (!toneShift.samples.empty() && toneShift.timestep > 0) {
+                if (const auto toneShiftParam = segment.parameter(PK_ToneShift)) {
+                    const auto &toneShift = toneShiftParam->sample_curve;
+                    if (!toneShift.empty() && (toneShift.isPiecewise() || toneShift.timestep > 0)) {
                         // assuming `tone_shift` is in cents
-                        const auto toneShiftSamples = it2->second.sample_curve.resample(
-                            frameLength, targetLength, false);
-                        for (size_t i = 0; i < targetLength; ++i) {
-                            // assuming `tone_shift` is in semitones
-                            samples[i] *= std::pow(2.0, toneShiftSamples[i] / 1200.0);
-                        }
+                        const auto toneShiftSamples = toneShift.resample(frameLength, targetLength, false);
+                        // Shifting by cents multiplies the frequency, so add it to the pitch in semitones.
+                        CurveKernels::addScaled(toneShiftSamples.data(),
+                                                (std::min)(samples.size(), toneShiftSamples.size()),
+                                                1.0 / 100.0, samples.data());
+                        clampMidiPitch(samples);
+                        m["f0"] = toFrequencyTensor(samples, scale, bias);
                     }
                 }
             }
-            m["f0"] = toInferDataAsType<double, float>(samples);;
             hasPitch = true;
         }
         //m[param.tag] = toInferDataAsType<double, float>(samples);
@@ -255,43 +379,9 @@ InferMap acousticPreprocess(
         putStatus(status, Status_InferError, "Missing parameter \"pitch\" from segment");
         return {};
     }
-    // velocity, gender, energy, breathiness
-    auto tryAddParam = [frameLength, targetLength, &dsSegment, &m](const std::string &paramName) {
-        if (auto it = dsSegment.parameters.find(paramName); it != dsSegment.parameters.end()) {
-            const auto &param = it->second;
-            if (param.tag == paramName) {
-                auto samples = param.sample_curve.resample(frameLength, targetLength);
-                m[paramName] = toInferDataAsType<double, float>(samples);
-                return true;
-            }
-        }
-        return false;
-    };
-
-    auto tensor0 = toInferDataAsType<float, float>(std::vector<float>(targetLength, 0.0f));
-    auto tensor1 = toInferDataAsType<float, float>(std::vector<float>(targetLength, 1.0f));
-    if ((dsConfig.features & kfParamGender) && !tryAddParam("gender")) {
-        m["gender"] = tensor0;
-    }
-    if ((dsConfig.features & kfParamVelocity) && !tryAddParam("velocity")) {
-        m["velocity"] = tensor1;
-    }
+    ParallelInputs inputs(targetLength);
     std::vector<std::string> missingParameters;
-    if ((dsConfig.features & kfParamBreathiness) && !tryAddParam("breathiness")) {
-        missingParameters.emplace_back("breathiness");
-    }
-    if ((dsConfig.features & kfParamTension) && !tryAddParam("tension")) {
-        missingParameters.emplace_back("tension");
-    }
-    if ((dsConfig.features & kfParamVoicing) && !tryAddParam("voicing")) {
-        missingParameters.emplace_back("voicing");
-    }
-    if ((dsConfig.features & kfParamEnergy) && !tryAddParam("energy")) {
-        missingParameters.emplace_back("energy");
-    }
-    if ((dsConfig.features & kfParamMouthOpening) && !tryAddParam("mouth_opening")) {
-        missingParameters.emplace_back("mouth_opening");
-    }
+    addSlotInputs(segment, plan, frameLength, targetLength, m, inputs, missingParameters);
 
     if (!missingParameters.empty()) {
         std::string errMsg = "The acoustic model expects";
@@ -302,66 +392,55 @@ InferMap acousticPreprocess(
         putStatus(status, Status_InferError, std::move(errMsg));
         return {};
     }
-    // DONE: static spk_mix
-    // TODO: curve spk_mix
-
-    if (!dsConfig.speakers.empty()) {
-        // Required to choose a speaker.
-        // {1, N, 256}
-        auto spkMix = getSpkMix(dsConfig.spkEmb, dsConfig.speakers, dsSegment.speakers, frameLength, targetLength);
-        std::array<int64_t, 3> shape = {int64_t{1}, targetLength, static_cast<int64_t>(SPK_EMBED_SIZE)};
-        m["spk_embed"] = Tensor::create(spkMix.data(), spkMix.size(), shape.data(), shape.size());
-    }
+    inputs.run(m);
 
     return m;
 }
 
 InferMap linguisticPreprocess(
-        const std::unordered_map<std::string, int64_t> &name2token,
-        const std::unordered_map<std::string, int64_t> &languages,
-        const Segment &dsSegment,
+        const CompactSegment &segment,
         double frameLength,
         bool predictDur,
         Status *status) {
     InferMap m;
 
-    bool isMultiLang = !languages.empty();
-    m["tokens"] = parsePhonemeTokens(dsSegment, name2token);
-    if (isMultiLang) {
-        m["languages"] = parsePhonemeLanguages(dsSegment, languages);
+    m["tokens"] = toInferDataAsType<int64_t, int64_t>(segment.tokens);
+    if (segment.multiLanguage) {
+        m["languages"] = toInferDataAsType<int64_t, int64_t>(segment.languages);
     }
 
     if (predictDur) {
-        std::vector<int64_t> wordDiv(dsSegment.words.size());
-        std::transform(dsSegment.words.begin(), dsSegment.words.end(), wordDiv.begin(),
-                       [](const Word &word) { return word.phones.size(); });
+        std::vector<int64_t> wordDiv(segment.wordCount());
+        for (size_t i = 0; i < wordDiv.size(); ++i) {
+            wordDiv[i] = segment.wordPhones[i + 1] - segment.wordPhones[i];
+        }
 
         m["word_div"] = toInferDataInPlace(std::move(wordDiv));
 
         std::vector<int64_t> wordDurFrames;
-        wordDurFrames.reserve(dsSegment.words.size());
+        wordDurFrames.reserve(segment.wordCount());
 
         int64_t wordDurSumPrevFrames = 0;
         double wordDurSumCurr = 0.0;
-        for (const auto &word: dsSegment.words) {
-            wordDurSumCurr += word.duration();
+        for (const auto wordDuration : segment.wordDurations) {
+            wordDurSumCurr += wordDuration;
             int64_t wordDurSumCurrFrames = std::llround(wordDurSumCurr / frameLength);
             wordDurFrames.push_back(wordDurSumCurrFrames - wordDurSumPrevFrames);
             wordDurSumPrevFrames = wordDurSumCurrFrames;
         }
         m["word_dur"] = toInferDataInPlace(std::move(wordDurFrames));
     } else {
-        m["ph_dur"] = parsePhonemeDurations(dsSegment, frameLength);
+        m["ph_dur"] = parsePhonemeDurations(segment, frameLength);
     }
     return m;
 }
 
 InferMap durPreprocess(
-        const Segment &dsSegment,
-        const DsDurConfig &dsDurConfig,
+        const CompactSegment &segment,
+        const InputPlan &plan,
         Status *status) {
     InferMap m;
-    auto phoneCount = dsSegment.phoneCount();
+    auto phoneCount = segment.phoneCount();
     std::vector<int64_t> phMidi;
     phMidi.reserve(phoneCount);
 
@@ -372,72 +451,59 @@ InferMap durPreprocess(
     int64_t fillMidiForBeginning = 0;
     int64_t lastMidi = restMidi;
 
+    // Updates the state with the note of a phone, returns whether the phone is a leading rest.
+    auto visitNote = [&](size_t note) {
+        const bool isRest = segment.noteRests[note];
+        if (!nonRestOccurred) {
+            if (!isRest) {
+                fillMidiForBeginning = segment.noteKeys[note];
+                nonRestOccurred = true;
+                return false;
+            }
+            return true;
+        }
+        if (!isRest) {
+            lastMidi = segment.noteKeys[note];
+        }
+#if 1
+        else {
+            lastMidi = restMidi;
+        }
+#endif
+        return false;
+    };
 
-    for (const auto &word : dsSegment.words) {
-        if (word.notes.empty()) {
+    for (size_t w = 0; w < segment.wordCount(); ++w) {
+        const size_t noteBegin = segment.wordNotes[w];
+        const size_t noteEnd = segment.wordNotes[w + 1];
+        const size_t phoneBegin = segment.wordPhones[w];
+        const size_t phoneEnd = segment.wordPhones[w + 1];
+        if (noteBegin == noteEnd) {
             // TODO: error handling
             continue;
         }
 
-        if (word.notes.size() == 1) {
-            const auto &note = word.notes[0];
-            if (!nonRestOccurred) {
-                if (!note.is_rest) {
-                    fillMidiForBeginning = note.key;
-                    nonRestOccurred = true;
-                } else {
-                    restCountAtBeginning += word.phones.size();
-                }
-            } else {
-                if (!note.is_rest) {
-                    lastMidi = note.key;
-                }
-#if 1
-                else {
-                    lastMidi = restMidi;
-                }
-#endif
-            }
-            for (const auto &phone: word.phones) {
-                phMidi.push_back(lastMidi);
+        if (noteEnd - noteBegin == 1) {
+            if (visitNote(noteBegin)) {
+                restCountAtBeginning += phoneEnd - phoneBegin;
             }
+            phMidi.insert(phMidi.end(), phoneEnd - phoneBegin, lastMidi);
         } else {
-            std::vector<double> noteCumDur;
-            noteCumDur.reserve(word.notes.size());
-            double s = 0.0;
-            for (const auto &note: word.notes) {
-                s += note.duration;
-                noteCumDur.push_back(s);
-            }
-
-            for (const auto &phone: word.phones) {
-                size_t noteIndex = 0;
-                while (noteIndex < noteCumDur.size()) {
-                    if (phone.start > noteCumDur[noteIndex]) {
+            for (size_t i = phoneBegin; i < phoneEnd; ++i) {
+                // The first note that ends before the phone starts, or the last note
+                size_t note = noteBegin;
+                double noteEndTime = 0.0;
+                for (; note < noteEnd; ++note) {
+                    noteEndTime += segment.noteDurations[note];
+                    if (segment.phoneStarts[i] > noteEndTime) {
                         break;
                     }
-                    ++noteIndex;
                 }
-                if (noteIndex >= word.notes.size()) {
-                    noteIndex = word.notes.size() - 1;
+                if (note >= noteEnd) {
+                    note = noteEnd - 1;
                 }
-                const auto &note = word.notes[noteIndex];
-                if (!nonRestOccurred) {
-                    if (!note.is_rest) {
-                        fillMidiForBeginning = note.key;
-                        nonRestOccurred = true;
-                    } else {
-                        ++restCountAtBeginning;
-                    }
-                } else {
-                    if (!note.is_rest) {
-                        lastMidi = note.key;
-                    }
-#if 1
-                    else {
-                        lastMidi = restMidi;
-                    }
-#endif
+                if (visitNote(note)) {
+                    ++restCountAtBeginning;
                 }
                 phMidi.push_back(lastMidi);
             }
@@ -455,7 +521,10 @@ InferMap durPreprocess(
 #endif
     m["ph_midi"] = toInferDataInPlace(std::move(phMidi));
 
-    if (!dsDurConfig.speakers.empty()) {
+    for (const auto &slot : plan.slots) {
+        if (slot.source != IS_SpeakerEmbed) {
+            continue;
+        }
         // Required to choose a speaker.
         // {1, N, 256}
 
@@ -463,14 +532,17 @@ InferMap durPreprocess(
         //       Consider allowing dynamic mix, but the axis is in phonemes instead of frames,
         //       so processing `spk_embed` in dur model is different than that in pitch, variance and acoustic models.
         std::unordered_map<std::string, double> staticMixMap;
-        staticMixMap.reserve(dsSegment.speakers.spk.size());
-        for (const auto &[key, value] : dsSegment.speakers.spk) {
-            staticMixMap[key] = value.samples.empty() ? 0 : value.samples[0];
+        staticMixMap.reserve(segment.speakers->spk.size());
+        for (const auto &[key, value] : segment.speakers->spk) {
+            staticMixMap[key] = value.valueAt(0.0);
         }
-        auto spkMix = getSpkMix(dsDurConfig.spkEmb, dsDurConfig.speakers, SpeakerMixCurve::fromStaticMix(staticMixMap),
-                                1, static_cast<int64_t>(phoneCount));
-        std::array<int64_t, 3> shape = {int64_t{1}, static_cast<int64_t>(phoneCount), static_cast<int64_t>(SPK_EMBED_SIZE)};
-        m["spk_embed"] = Tensor::create(spkMix.data(), spkMix.size(), shape.data(), shape.size());
+        const auto nPhones = static_cast<int64_t>(phoneCount);
+        auto spkEmbed = makeTensor<float>(nPhones * SPK_EMBED_SIZE, {int64_t{1}, nPhones, static_cast<int64_t>(SPK_EMBED_SIZE)});
+        float *spkEmbedBuffer;
+        spkEmbed.getDataBuffer<float>(&spkEmbedBuffer);
+        getSpkMix(plan.spkEmb, plan.speakers, SpeakerMixCurve::fromStaticMix(staticMixMap),
+                  1, nPhones, spkEmbedBuffer);
+        m[slot.name] = std::move(spkEmbed);
     }
 
     return m;
@@ -478,14 +550,13 @@ InferMap durPreprocess(
 
 
 InferMap pitchProcess(
-        const Segment &dsSegment,
-        const DsPitchConfig &dsPitchConfig,
+        const CompactSegment &segment,
+        const InputPlan &plan,
         double frameLength,
-        bool predictDur,
         Status *status) {
     InferMap m;
 
-    size_t noteCount = dsSegment.noteCount();
+    size_t noteCount = segment.noteCount();
     std::vector<float> noteMidi;
     std::vector<unsigned char> noteRest;
     std::vector<int64_t> noteDur;
@@ -496,19 +567,18 @@ InferMap pitchProcess(
     constexpr float restMidi = -127.0f;
 
     double noteDurSum = 0.0;
-    for (const auto &word: dsSegment.words) {
-        for (const auto &note : word.notes) {
-            noteRest.push_back(note.is_rest ? 1 : 0);
-            if (note.is_rest) {
-                noteMidi.push_back(restMidi);
-            } else {
-                noteMidi.push_back(static_cast<float>(note.key) + static_cast<float>(note.cents) / 100.0f);
-            }
-            int64_t noteDurPrevFrames = std::llround(noteDurSum / frameLength);
-            noteDurSum += note.duration;
-            int64_t noteDurCurrFrames = std::llround(noteDurSum / frameLength);
-            noteDur.push_back(noteDurCurrFrames - noteDurPrevFrames);
+    for (size_t i = 0; i < noteCount; ++i) {
+        const bool isRest = segment.noteRests[i];
+        noteRest.push_back(isRest ? 1 : 0);
+        if (isRest) {
+            noteMidi.push_back(restMidi);
+        } else {
+            noteMidi.push_back(static_cast<float>(segment.noteKeys[i]) + static_cast<float>(segment.noteCents[i]) / 100.0f);
         }
+        int64_t noteDurPrevFrames = std::llround(noteDurSum / frameLength);
+        noteDurSum += segment.noteDurations[i];
+        int64_t noteDurCurrFrames = std::llround(noteDurSum / frameLength);
+        noteDur.push_back(noteDurCurrFrames - noteDurPrevFrames);
     }
 
     int64_t nFrames = std::accumulate(noteDur.begin(), noteDur.end(), int64_t{0}, std::plus<>());
@@ -517,166 +587,63 @@ InferMap pitchProcess(
     fillRestMidiWithNearestInPlace(noteMidi, restMidi);
 #endif
     m["note_midi"] = toInferDataInPlace(std::move(noteMidi));
-    if (dsPitchConfig.features & kfParamNoteRest) {
-        m["note_rest"] = toInferDataAsType<unsigned char, bool>(noteRest);
-    }
     m["note_dur"] = toInferDataInPlace(std::move(noteDur));
-
-    if (predictDur) {
-        // The linguistic model inputs word_div and word_dur.
-        // So ph_dur should be an input of pitch model, instead of binding from linguistic model input.
-        m["ph_dur"] = parsePhonemeDurations(dsSegment, frameLength);
-    }
-
-    if (auto it = dsSegment.parameters.find("pitch"); it != dsSegment.parameters.end()) {
-        const auto &pitch = it->second;
-        m["pitch"] = toInferDataAsType<double, float>(pitch.sample_curve.resample(frameLength, nFrames));
-        int64_t newRetakeStart = std::clamp(
-                static_cast<int64_t>(std::llround(static_cast<double>(pitch.retake_start) * pitch.sample_curve.timestep / frameLength)),
-                int64_t{0},
-                nFrames);
-        auto newRetakeEnd = std::clamp(
-                static_cast<int64_t>(std::llround(static_cast<double>(pitch.retake_end) * pitch.sample_curve.timestep / frameLength)),
-                int64_t{0},
-                nFrames);
-        std::vector<unsigned char> retake(nFrames, 0);
-        std::fill(retake.begin() + newRetakeStart, retake.begin() + newRetakeEnd, 1);
-        m["retake"] = toInferDataAsType<unsigned char, bool>(retake);
-    } else {
-        // TODO: error handling
-        m["pitch"] = toInferDataInPlace(std::vector<float>(nFrames, 0.0f));
-        m["retake"] = toInferDataAsType<unsigned char, bool>(std::vector<unsigned char>(nFrames, 1));
-    }
-
-    if (dsPitchConfig.features & kfParamExpr) {
-        if (auto it = dsSegment.parameters.find("expr"); it != dsSegment.parameters.end()) {
-            const auto &expr = it->second;
-            m["expr"] = toInferDataAsType<double, float>(expr.sample_curve.resample(frameLength, nFrames));
-        } else {
-            // TODO: warn user that expr is not specified and will use 1.
-            m["expr"] = toInferDataInPlace(std::vector<float>(nFrames, 1.0f));
+    for (const auto &slot : plan.slots) {
+        if (slot.source == IS_NoteRest) {
+            m[slot.name] = toInferDataAsType<unsigned char, bool>(noteRest);
         }
     }
 
-    if (!dsPitchConfig.speakers.empty()) {
-        // Required to choose a speaker.
-        // {1, N, 256}
-        auto spkMix = getSpkMix(dsPitchConfig.spkEmb, dsPitchConfig.speakers, dsSegment.speakers, frameLength, nFrames);
-        std::array<int64_t, 3> shape = {int64_t{1}, nFrames, static_cast<int64_t>(SPK_EMBED_SIZE)};
-        m["spk_embed"] = Tensor::create(spkMix.data(), spkMix.size(), shape.data(), shape.size());
-    }
+    // Missing parameters fall back to constants; the pitch itself is predicted if missing.
+    ParallelInputs inputs(nFrames);
+    std::vector<std::string> missingParameters;
+    addSlotInputs(segment, plan, frameLength, nFrames, m, inputs, missingParameters);
+    inputs.run(m);
 
     return m;
 }
 
 InferMap variancePreprocess(
-        const Segment &dsSegment,
-        const DsVarianceConfig &dsVarianceConfig,
+        const CompactSegment &segment,
+        const InputPlan &plan,
         double frameLength,
-        bool predictDur,
         Status *status) {
     InferMap m;
     // TODO
     double durSum = 0.0;
-    for (const auto &word : dsSegment.words) {
-        durSum += word.duration();
+    for (const auto wordDuration : segment.wordDurations) {
+        durSum += wordDuration;
     }
 
     int64_t nFrames = std::llround(durSum / frameLength);
 
-    if (const auto it = dsSegment.parameters.find("pitch"); it != dsSegment.parameters.end()) {
-        const auto &pitch = it->second;
+    if (const auto pitchParam = segment.parameter(PK_Pitch)) {
+        const auto &pitch = *pitchParam;
         auto pitchSamples = pitch.sample_curve.resample(frameLength, nFrames);
 
-        if (const auto it2 = dsSegment.parameters.find("tone_shift"); it2 != dsSegment.parameters.end()) {
-            const auto &toneShift = it2->second.sample_curve;
-            if (!toneShift.samples.empty() && toneShift.timestep > 0) {
+        if (const auto toneShiftParam = segment.parameter(PK_ToneShift)) {
+            const auto &toneShift = toneShiftParam->sample_curve;
+            if (!toneShift.empty() && (toneShift.isPiecewise() || toneShift.timestep > 0)) {
                 // assuming `tone_shift` is in cents
                 const auto toneShiftSamples = toneShift.resample(
                     frameLength, nFrames, false);
-                for (size_t i = 0; i < nFrames; ++i) {
-                    // assuming `tone_shift` is in semitones
-                    pitchSamples[i] += toneShiftSamples[i] / 100.0;
-                }
+                // cents to semitones
+                CurveKernels::addScaled(toneShiftSamples.data(),
+                                        (std::min)(pitchSamples.size(), toneShiftSamples.size()),
+                                        1.0 / 100.0, pitchSamples.data());
             }
         }
+        clampMidiPitch(pitchSamples);
         m["pitch"] = toInferDataAsType<double, float>(pitchSamples);
     } else {
         putStatus(status, Status_InferError, "Missing parameter \"pitch\" from segment");
         return {};
     }
 
-    if (predictDur) {
-        // The linguistic model inputs word_div and word_dur.
-        // So ph_dur should be an input of variance model, instead of binding from linguistic model input.
-        m["ph_dur"] = parsePhonemeDurations(dsSegment, frameLength);
-    }
-
-    std::vector<unsigned char> retake;
-
-    std::vector<std::string> expectParamNames;
-
-    if (dsVarianceConfig.features & kfParamEnergy) {
-        expectParamNames.emplace_back("energy");
-    }
-    if (dsVarianceConfig.features & kfParamBreathiness) {
-        expectParamNames.emplace_back("breathiness");
-    }
-    if (dsVarianceConfig.features & kfParamTension) {
-        expectParamNames.emplace_back("tension");
-    }
-    if (dsVarianceConfig.features & kfParamVoicing) {
-        expectParamNames.emplace_back("voicing");
-    }
-    if (dsVarianceConfig.features & kfParamMouthOpening) {
-        expectParamNames.emplace_back("mouth_opening");
-    }
-
-    if (expectParamNames.empty()) {
-        putStatus(status, Status_InferError,
-                  "According to the variance model config, it does not predict any parameters. Please check the config!");
-        return {};
-    } else {
-        retake.resize(expectParamNames.size() * nFrames);
-    }
-
-    for (int64_t i = 0; i < expectParamNames.size(); ++i) {
-        const auto &paramName = expectParamNames[i];
-        if (auto it = dsSegment.parameters.find(paramName); it != dsSegment.parameters.end()) {
-            const auto &p = it->second;
-            m[paramName] = toInferDataAsType<double, float>(p.sample_curve.resample(frameLength, nFrames));
-            int64_t newRetakeStart = std::clamp(
-                    static_cast<int64_t>(std::llround(static_cast<double>(p.retake_start) * p.sample_curve.timestep / frameLength)),
-                    int64_t{0},
-                    nFrames);
-            auto newRetakeEnd = std::clamp(
-                    static_cast<int64_t>(std::llround(static_cast<double>(p.retake_end) * p.sample_curve.timestep / frameLength)),
-                    int64_t{0},
-                    nFrames);
-            std::fill(retake.begin() + nFrames * i + newRetakeStart,
-                      retake.begin() + nFrames * i + newRetakeEnd,
-                      1);
-        } else {
-            // TODO: error handling
-            m[paramName] = toInferDataInPlace(std::vector<float>(nFrames));
-            std::fill(retake.begin() + nFrames * i,
-                      retake.begin() + nFrames * (i + 1),
-                      1);
-        }
-    }
-
-    auto retakeTensor = toInferDataAsType<unsigned char, bool>(retake);
-    auto numParams = static_cast<int64_t>(expectParamNames.size());
-    retakeTensor.shape = {int64_t{1}, static_cast<int64_t>(retake.size()) / numParams, numParams};
-    m["retake"] = std::move(retakeTensor);
-
-    if (!dsVarianceConfig.speakers.empty()) {
-        // Required to choose a speaker.
-        // {1, N, 256}
-        auto spkMix = getSpkMix(dsVarianceConfig.spkEmb, dsVarianceConfig.speakers, dsSegment.speakers, frameLength, nFrames);
-        std::array<int64_t, 3> shape = {int64_t{1}, nFrames, static_cast<int64_t>(SPK_EMBED_SIZE)};
-        m["spk_embed"] = Tensor::create(spkMix.data(), spkMix.size(), shape.data(), shape.size());
-    }
+    ParallelInputs inputs(nFrames);
+    std::vector<std::string> missingParameters;
+    addSlotInputs(segment, plan, frameLength, nFrames, m, inputs, missingParameters);
+    inputs.run(m);
 
     return m;
 }
@@ -725,43 +692,115 @@ std::vector<T> fillRestMidiWithNearest(const std::vector<T> &src, T restMidi) {
     return dst;
 }
 
+int64_t getFrameCount(const Segment &dsSegment, double frameLength) {
+    // The phoneme durations of a word sum up to the frames from the start of its first phone
+    // to the start of the next phone, computed as in parsePhonemeDurations(), so only these
+    // two boundaries are rounded.
+    const auto &words = dsSegment.words;
+    int64_t frameCount = 0;
+    double phoneDurSum = 0.0;
+    for (size_t i = 0; i < words.size(); ++i) {
+        const auto &word = words[i];
+        const auto wordDuration = word.duration();
+        if (!word.phones.empty()) {
+            auto nextPhoneStart = phoneDurSum + wordDuration;
+            if (i + 1 < words.size() && !words[i + 1].phones.empty()) {
+                nextPhoneStart += words[i + 1].phones.front().start;
+            }
+            const auto firstPhoneStart = phoneDurSum + word.phones.front().start;
+            frameCount += std::llround(nextPhoneStart / frameLength) - std::llround(firstPhoneStart / frameLength);
+        }
+        phoneDurSum += wordDuration;
+    }
+    return frameCount;
+}
+
 std::vector<float> getSpkMix(const SpeakerEmbed &spkEmb, const std::vector<std::string> &speakers, const SpeakerMixCurve &spkMix, double frameLength, int64_t targetLength) {
+    std::vector<float> spk_embed(targetLength * SPK_EMBED_SIZE);
+    getSpkMix(spkEmb, speakers, spkMix, frameLength, targetLength, spk_embed.data());
+    return spk_embed;
+}
+
+void getSpkMix(const SpeakerEmbed &spkEmb, const std::vector<std::string> &speakers, const SpeakerMixCurve &spkMix, double frameLength, int64_t targetLength, float *out) {
     // Required to choose a speaker.
-    std::vector<float> spk_embed;
-    int64_t spkEmbedArraySize = targetLength * SPK_EMBED_SIZE;
-    spk_embed.resize(spkEmbedArraySize);
+    std::fill(out, out + targetLength * SPK_EMBED_SIZE, 0.0f);
     if (spkMix.empty()) {
         // Use the first one by default.
-        auto emb = spkEmb.getMixedEmb({{speakers[0], 1.0}});
-        for (size_t i = 0; i < spkEmbedArraySize; ++i) {
-            spk_embed[i] = emb[i % SPK_EMBED_SIZE];
+        const float *emb = spkEmb.embedding(spkEmb.speakerIndex(speakers[0]));
+        if (emb) {
+            for (int64_t i = 0; i < targetLength; ++i) {
+                std::copy(emb, emb + SPK_EMBED_SIZE, out + i * SPK_EMBED_SIZE);
+            }
+        }
+    } else if (targetLength > 0 && std::all_of(spkMix.spk.begin(), spkMix.spk.end(),
+                                               [](const auto &item) { return item.second.isConstant(); })) {
+        // Constant weights: mix the embeddings once and broadcast the row to every frame.
+        double mixSum = 0.0;
+        for (const auto &[name, curve] : spkMix.spk) {
+            mixSum += curve.valueAt(0.0);
+        }
+        if (mixSum == 0) {
+            mixSum = 1;
+        }
+        for (const auto &[name, curve] : spkMix.spk) {
+            if (const float *row = spkEmb.embedding(spkEmb.speakerIndex(name))) {
+                CurveKernels::accumulateScaled(row, SPK_EMBED_SIZE, curve.valueAt(0.0) / mixSum, out);
+            }
+        }
+        for (int64_t i = 1; i < targetLength; ++i) {
+            std::copy(out, out + SPK_EMBED_SIZE, out + i * SPK_EMBED_SIZE);
         }
     } else {
         auto spkMixResampled = spkMix.resample(frameLength, targetLength);
+
+        // Resolve speaker names once; the per-frame loop only works on rows and curves.
+        // Unknown speakers still count towards the sum of weights.
+        std::vector<const std::vector<double> *> curves;
+        std::vector<std::pair<const float *, const std::vector<double> *>> rows;
+        curves.reserve(spkMixResampled.spk.size());
+        rows.reserve(spkMixResampled.spk.size());
+        for (const auto &[name, curve] : spkMixResampled.spk) {
+            curves.push_back(&curve.samples);
+            if (const float *row = spkEmb.embedding(spkEmb.speakerIndex(name))) {
+                rows.emplace_back(row, &curve.samples);
+            }
+        }
+
         for (int64_t i = 0; i < targetLength; ++i) {
-            std::unordered_map<std::string, double> mix;
-            double mixSum = std::accumulate(spkMixResampled.spk.begin(), spkMixResampled.spk.end(), 0.0,
-                                            [i](double value, const auto &speakerItem) {
-                                                return value + speakerItem.second.samples[i];
-                                            });
+            // If SampleCurve::resample guarantees the size of returned array is at least `targetLength`,
+            // subscripting will not go out of range here.
+            double mixSum = 0.0;
+            for (const auto *samples : curves) {
+                mixSum += (*samples)[i];
+            }
             if (mixSum == 0) {
                 mixSum = 1;
             }
-            int64_t speakerIndex = 0;
-            for (const auto &speakerItem : spkMixResampled.spk) {
-                // If SampleCurve::resample guarantees the size of returned array is at least `targetLength`,
-                // subscripting will not go out of range here.
-                mix[speakerItem.first] = speakerItem.second.samples[i] / mixSum;
-                ++speakerIndex;
-            }
-            auto emb = spkEmb.getMixedEmb(mix);
-            int64_t y = i * SPK_EMBED_SIZE;
-            for (int64_t j = 0; j < SPK_EMBED_SIZE; ++j) {
-                spk_embed[y + j] = emb[j];
+            float *dst = out + i * SPK_EMBED_SIZE;
+            for (const auto &[row, samples] : rows) {
+                CurveKernels::accumulateScaled(row, SPK_EMBED_SIZE, (*samples)[i] / mixSum, dst);
             }
         }
     }
-    return spk_embed;
+}
+
+uint64_t fingerprintInputs(const InferMap &inputs) {
+    Fnv1a hash;
+    // The map may be unordered, so the names are combined in sorted order.
+    std::vector<const InferMap::value_type *> items;
+    items.reserve(inputs.size());
+    for (const auto &item : inputs) {
+        items.push_back(&item);
+    }
+    std::sort(items.begin(), items.end(), [](auto a, auto b) { return a->first < b->first; });
+    for (const auto item : items) {
+        const auto &[name, tensor] = *item;
+        hash.bytes(name.data(), name.size() + 1);
+        hash.value(static_cast<int>(tensor.type));
+        hash.bytes(tensor.shape.data(), tensor.shape.size() * sizeof(int64_t));
+        hash.bytes(tensor.data.data(), tensor.data.size());
+    }
+    return hash.result();
 }
 
 bool isFileExtJson(const std::filesystem::path &path) {
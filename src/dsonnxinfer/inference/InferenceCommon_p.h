@@ -26,14 +26,21 @@ struct DsPitchConfig;
 struct DsVarianceConfig;
 struct SpeakerEmbed;
 struct SpeakerMixCurve;
+class PhonemeDict;
+struct InputPlan;
+struct CompactSegment;
 
 using InferMap = flowonnx::TensorMap;
 
+/**
+ * @brief The inputs of the acoustic model, whose f0 has the tone shift applied if
+ *        `applyToneShift` is set.
+ *
+ * @param outOriginalF0 If not null, receives the f0 without the tone shift, for the vocoder.
+ */
 InferMap acousticPreprocess(
-        const std::unordered_map<std::string, int64_t> &name2token,
-        const std::unordered_map<std::string, int64_t> &languages,
-        const Segment &dsSegment,
-        const DsConfig &dsConfig,
+        const CompactSegment &segment,
+        const InputPlan &plan,
         double frameLength,
         double transpose,
         bool applyToneShift,
@@ -41,34 +48,44 @@ InferMap acousticPreprocess(
         Status *status = nullptr);
 
 InferMap linguisticPreprocess(
-        const std::unordered_map<std::string, int64_t> &name2token,
-        const std::unordered_map<std::string, int64_t> &languages,
-        const Segment &dsSegment,
+        const CompactSegment &segment,
         double frameLength,
         bool predictDur,
         Status *status = nullptr);
 
 InferMap durPreprocess(
-        const Segment &dsSegment,
-        const DsDurConfig &dsDurConfig,
+        const CompactSegment &segment,
+        const InputPlan &plan,
         Status *status = nullptr);
 
 InferMap pitchProcess(
-        const Segment &dsSegment,
-        const DsPitchConfig &dsPitchConfig,
+        const CompactSegment &segment,
+        const InputPlan &plan,
         double frameLength,
-        bool predictDur,
         Status *status = nullptr);
 
 InferMap variancePreprocess(
-        const Segment &dsSegment,
-        const DsVarianceConfig &dsVarianceConfig,
+        const CompactSegment &segment,
+        const InputPlan &plan,
         double frameLength,
-        bool predictDur,
         Status *status = nullptr);
 
+/**
+ * @brief The number of frames of a segment, i.e. the sum of its phoneme durations in frames.
+ */
+int64_t getFrameCount(const Segment &dsSegment, double frameLength);
+
 std::vector<float> getSpkMix(const SpeakerEmbed &spkEmb, const std::vector<std::string> &speakers, const SpeakerMixCurve &spkMix, double frameLength, int64_t targetLength);
 
+// Writes `targetLength * SPK_EMBED_SIZE` floats to `out`.
+void getSpkMix(const SpeakerEmbed &spkEmb, const std::vector<std::string> &speakers, const SpeakerMixCurve &spkMix, double frameLength, int64_t targetLength, float *out);
+
+/**
+ * @brief FNV-1a hash of the names, types, shapes and data of model inputs, for caches
+ *        keyed by what a model reads.
+ */
+uint64_t fingerprintInputs(const InferMap &inputs);
+
 bool isFileExtJson(const std::filesystem::path &path);
 
 bool readPhonemesFile(const std::filesystem::path &path, std::unordered_map<std::string, int64_t> &out);
@@ -0,0 +1,445 @@
+#include "InputPlan_p.h"
+
+#include <algorithm>
+#include <unordered_set>
+#include <utility>
+
+#include "../utils/MappedFile_p.h"
+
+DSONNXINFER_BEGIN_NAMESPACE
+
+namespace {
+    // Inputs that only exist if some feature of the config enables them
+    const char *const kFeatureInputs[] = {
+        "gender", "velocity", "energy", "breathiness", "tension", "voicing", "mouth_opening",
+        "expr", "note_rest", "retake", "spk_embed",
+    };
+
+    struct ModelInput {
+        std::string name;
+        // TensorProto.DataType, 0 if unknown
+        int elemType = 0;
+        // -1 if unknown
+        int rank = -1;
+    };
+
+    // Reads the protobuf wire format, enough to walk the graph of an ONNX model.
+    class ProtoReader {
+    public:
+        ProtoReader(const char *data, size_t size) : m_pos(data), m_end(data + size) {
+        }
+
+        bool atEnd() const {
+            return m_pos >= m_end;
+        }
+
+        bool varint(uint64_t &value) {
+            value = 0;
+            for (int shift = 0; shift < 64 && m_pos < m_end; shift += 7) {
+                const auto byte = static_cast<unsigned char>(*m_pos++);
+                value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+                if (!(byte & 0x80)) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        bool next(uint32_t &field, uint32_t &wireType) {
+            uint64_t key;
+            if (!varint(key)) {
+                return false;
+            }
+            field = static_cast<uint32_t>(key >> 3);
+            wireType = static_cast<uint32_t>(key & 7);
+            return true;
+        }
+
+        bool bytes(ProtoReader &out) {
+            uint64_t size;
+            if (!varint(size) || size > static_cast<uint64_t>(m_end - m_pos)) {
+                return false;
+            }
+            out = ProtoReader(m_pos, size);
+            m_pos += size;
+            return true;
+        }
+
+        bool string(std::string &out) {
+            ProtoReader sub(nullptr, 0);
+            if (!bytes(sub)) {
+                return false;
+            }
+            out.assign(sub.m_pos, sub.m_end);
+            return true;
+        }
+
+        bool skip(uint32_t wireType) {
+            uint64_t value;
+            ProtoReader sub(nullptr, 0);
+            switch (wireType) {
+                case 0:
+                    return varint(value);
+                case 1:
+                    return advance(8);
+                case 2:
+                    return bytes(sub);
+                case 5:
+                    return advance(4);
+                default:
+                    return false;
+            }
+        }
+
+    private:
+        bool advance(size_t count) {
+            if (count > static_cast<size_t>(m_end - m_pos)) {
+                return false;
+            }
+            m_pos += count;
+            return true;
+        }
+
+        const char *m_pos;
+        const char *m_end;
+    };
+
+    // TypeProto { Tensor tensor_type = 1 { int32 elem_type = 1; TensorShapeProto shape = 2 { repeated dim = 1 } } }
+    bool readTensorType(ProtoReader reader, ModelInput &input) {
+        uint32_t field, wireType;
+        while (!reader.atEnd()) {
+            if (!reader.next(field, wireType)) {
+                return false;
+            }
+            ProtoReader tensorType(nullptr, 0);
+            if (field != 1 || wireType != 2) {
+                if (!reader.skip(wireType)) {
+                    return false;
+                }
+                continue;
+            }
+            if (!reader.bytes(tensorType)) {
+                return false;
+            }
+            while (!tensorType.atEnd()) {
+                if (!tensorType.next(field, wireType)) {
+                    return false;
+                }
+                uint64_t value;
+                ProtoReader shape(nullptr, 0);
+                if (field == 1 && wireType == 0) {
+                    if (!tensorType.varint(value)) {
+                        return false;
+                    }
+                    input.elemType = static_cast<int>(value);
+                } else if (field == 2 && wireType == 2) {
+                    if (!tensorType.bytes(shape)) {
+                        return false;
+                    }
+                    input.rank = 0;
+                    while (!shape.atEnd()) {
+                        if (!shape.next(field, wireType)) {
+                            return false;
+                        }
+                        if (field == 1) {
+                            ++input.rank;
+                        }
+                        if (!shape.skip(wireType)) {
+                            return false;
+                        }
+                    }
+                } else if (!tensorType.skip(wireType)) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    // ValueInfoProto { string name = 1; TypeProto type = 2 }
+    bool readValueInfo(ProtoReader reader, ModelInput &input) {
+        uint32_t field, wireType;
+        while (!reader.atEnd()) {
+            if (!reader.next(field, wireType)) {
+                return false;
+            }
+            ProtoReader type(nullptr, 0);
+            if (field == 1 && wireType == 2) {
+                if (!reader.string(input.name)) {
+                    return false;
+                }
+            } else if (field == 2 && wireType == 2) {
+                if (!reader.bytes(type) || !readTensorType(type, input)) {
+                    return false;
+                }
+            } else if (!reader.skip(wireType)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // TensorProto { string name = 8 }
+    bool readInitializerName(ProtoReader reader, std::string &name) {
+        uint32_t field, wireType;
+        while (!reader.atEnd()) {
+            if (!reader.next(field, wireType)) {
+                return false;
+            }
+            if (field == 8 && wireType == 2) {
+                return reader.string(name);
+            }
+            if (!reader.skip(wireType)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * Reads the runtime inputs of an ONNX model, i.e. ModelProto.graph (7).input (11) without
+     * the names of graph.initializer (5), which older exporters list as inputs too.
+     * Initializers are skipped by their length, so large models are cheap to read.
+     */
+    bool readModelInputs(const std::filesystem::path &path, std::vector<ModelInput> &inputs) {
+        MappedFile file;
+        if (!file.open(path)) {
+            return false;
+        }
+        ProtoReader model(file.data(), file.size());
+        std::unordered_set<std::string> initializers;
+        uint32_t field, wireType;
+        bool hasGraph = false;
+        while (!model.atEnd()) {
+            if (!model.next(field, wireType)) {
+                return false;
+            }
+            ProtoReader graph(nullptr, 0);
+            if (field != 7 || wireType != 2) {
+                if (!model.skip(wireType)) {
+                    return false;
+                }
+                continue;
+            }
+            if (!model.bytes(graph)) {
+                return false;
+            }
+            hasGraph = true;
+            while (!graph.atEnd()) {
+                if (!graph.next(field, wireType)) {
+                    return false;
+                }
+                ProtoReader item(nullptr, 0);
+                if (field == 11 && wireType == 2) {
+                    ModelInput input;
+                    if (!graph.bytes(item) || !readValueInfo(item, input)) {
+                        return false;
+                    }
+                    inputs.push_back(std::move(input));
+                } else if (field == 5 && wireType == 2) {
+                    std::string name;
+                    if (!graph.bytes(item) || !readInitializerName(item, name)) {
+                        return false;
+                    }
+                    initializers.insert(std::move(name));
+                } else if (!graph.skip(wireType)) {
+                    return false;
+                }
+            }
+        }
+        inputs.erase(std::remove_if(inputs.begin(), inputs.end(),
+                                    [&initializers](const ModelInput &input) {
+                                        return initializers.count(input.name) != 0;
+                                    }),
+                     inputs.end());
+        return hasGraph;
+    }
+
+    // TensorProto.DataType of a tensor type
+    int onnxElemType(flowonnx::Tensor::DataType type) {
+        switch (type) {
+            case flowonnx::Tensor::Float:
+                return 1;
+            case flowonnx::Tensor::Int64:
+                return 7;
+            case flowonnx::Tensor::Bool:
+                return 9;
+            default:
+                return 0;
+        }
+    }
+
+    void addSpeakerSlot(InputPlan &plan, const std::vector<std::string> &speakers, const SpeakerEmbed &spkEmb) {
+        if (speakers.empty()) {
+            return;
+        }
+        InputSlot slot;
+        slot.name = "spk_embed";
+        slot.source = IS_SpeakerEmbed;
+        slot.rank = 3;
+        plan.slots.push_back(std::move(slot));
+        plan.speakers = speakers;
+        plan.spkEmb = spkEmb;
+    }
+
+    // With the durations predicted, the linguistic model takes word_div and word_dur, so
+    // ph_dur is an input of the downstream model instead of being bound from the linguistic model.
+    void addPhonemeDurationSlot(InputPlan &plan) {
+        if (!(plan.features & kfLinguisticPredictDur)) {
+            return;
+        }
+        InputSlot slot;
+        slot.name = "ph_dur";
+        slot.source = IS_PhonemeDurations;
+        slot.type = flowonnx::Tensor::Int64;
+        plan.slots.push_back(std::move(slot));
+    }
+}
+
+InputPlan InputPlan::forAcoustic(const DsConfig &dsConfig) {
+    InputPlan plan;
+    plan.features = dsConfig.features;
+    const auto addParameter = [&plan](dsfeature_t feature, ParameterKind kind, bool required, float fallback) {
+        if (plan.features & feature) {
+            InputSlot slot;
+            slot.name = parameterName(kind);
+            slot.parameter = kind;
+            slot.required = required;
+            slot.fallback = fallback;
+            plan.slots.push_back(std::move(slot));
+        }
+    };
+    addParameter(kfParamGender, PK_Gender, false, 0.0f);
+    addParameter(kfParamVelocity, PK_Velocity, false, 1.0f);
+    addParameter(kfParamBreathiness, PK_Breathiness, true, 0.0f);
+    addParameter(kfParamTension, PK_Tension, true, 0.0f);
+    addParameter(kfParamVoicing, PK_Voicing, true, 0.0f);
+    addParameter(kfParamEnergy, PK_Energy, true, 0.0f);
+    addParameter(kfParamMouthOpening, PK_MouthOpening, true, 0.0f);
+    addSpeakerSlot(plan, dsConfig.speakers, dsConfig.spkEmb);
+    return plan;
+}
+
+InputPlan InputPlan::forVariance(const DsVarianceConfig &dsVarianceConfig) {
+    InputPlan plan;
+    plan.features = dsVarianceConfig.features;
+    addPhonemeDurationSlot(plan);
+    const auto addPredicted = [&plan](dsfeature_t feature, ParameterKind kind) {
+        if (plan.features & feature) {
+            // Missing parameters are predicted from scratch.
+            InputSlot slot;
+            slot.name = parameterName(kind);
+            slot.parameter = kind;
+            slot.source = IS_PredictedParameter;
+            plan.slots.push_back(std::move(slot));
+            ++plan.predictedCount;
+        }
+    };
+    addPredicted(kfParamEnergy, PK_Energy);
+    addPredicted(kfParamBreathiness, PK_Breathiness);
+    addPredicted(kfParamTension, PK_Tension);
+    addPredicted(kfParamVoicing, PK_Voicing);
+    addPredicted(kfParamMouthOpening, PK_MouthOpening);
+    if (plan.predictedCount > 0) {
+        // After the predicted parameters, which fill the mask.
+        InputSlot slot;
+        slot.name = "retake";
+        slot.source = IS_Retake;
+        slot.type = flowonnx::Tensor::Bool;
+        slot.rank = 3;
+        plan.slots.push_back(std::move(slot));
+    }
+    addSpeakerSlot(plan, dsVarianceConfig.speakers, dsVarianceConfig.spkEmb);
+    return plan;
+}
+
+InputPlan InputPlan::forPitch(const DsPitchConfig &dsPitchConfig) {
+    InputPlan plan;
+    plan.features = dsPitchConfig.features;
+    if (plan.features & kfParamNoteRest) {
+        InputSlot slot;
+        slot.name = "note_rest";
+        slot.source = IS_NoteRest;
+        slot.type = flowonnx::Tensor::Bool;
+        plan.slots.push_back(std::move(slot));
+    }
+    addPhonemeDurationSlot(plan);
+    {
+        // A missing pitch is predicted from scratch.
+        InputSlot slot;
+        slot.name = parameterName(PK_Pitch);
+        slot.parameter = PK_Pitch;
+        slot.source = IS_PredictedParameter;
+        plan.slots.push_back(std::move(slot));
+        ++plan.predictedCount;
+    }
+    {
+        InputSlot slot;
+        slot.name = "retake";
+        slot.source = IS_Retake;
+        slot.type = flowonnx::Tensor::Bool;
+        plan.slots.push_back(std::move(slot));
+    }
+    if (plan.features & kfParamExpr) {
+        InputSlot slot;
+        slot.name = parameterName(PK_Expr);
+        slot.parameter = PK_Expr;
+        slot.fallback = 1.0f;
+        plan.slots.push_back(std::move(slot));
+    }
+    addSpeakerSlot(plan, dsPitchConfig.speakers, dsPitchConfig.spkEmb);
+    return plan;
+}
+
+InputPlan InputPlan::forDuration(const DsDurConfig &dsDurConfig) {
+    InputPlan plan;
+    plan.features = dsDurConfig.features;
+    addSpeakerSlot(plan, dsDurConfig.speakers, dsDurConfig.spkEmb);
+    return plan;
+}
+
+Status InputPlan::validate(const std::filesystem::path &reference, const std::filesystem::path &selected,
+                           const std::string &modelName) const {
+    if (auto s = validateModel(reference, modelName); !s.isOk() || selected == reference) {
+        return s;
+    }
+    return validateModel(selected, modelName + " (" + selected.filename().string() + ")");
+}
+
+Status InputPlan::validateModel(const std::filesystem::path &model, const std::string &modelName) const {
+    std::vector<ModelInput> inputs;
+    if (!readModelInputs(model, inputs)) {
+        // Loading the model reports the problem.
+        return {};
+    }
+    for (const auto &slot : slots) {
+        auto it = std::find_if(inputs.begin(), inputs.end(),
+                               [&slot](const ModelInput &input) { return input.name == slot.name; });
+        if (it == inputs.end()) {
+            return {Status_ModelLoadError,
+                    "The " + modelName + " config enables input \"" + slot.name + "\", but the model does not declare it"};
+        }
+        if (it->elemType != 0 && it->elemType != onnxElemType(slot.type)) {
+            return {Status_ModelLoadError,
+                    "Input \"" + slot.name + "\" of the " + modelName + " model has an unexpected type"};
+        }
+        if (it->rank >= 0 && it->rank != slot.rank) {
+            return {Status_ModelLoadError,
+                    "Input \"" + slot.name + "\" of the " + modelName + " model has rank " +
+                    std::to_string(it->rank) + ", expected " + std::to_string(slot.rank)};
+        }
+    }
+    for (const auto &input : inputs) {
+        const bool isFeatureInput = std::any_of(std::begin(kFeatureInputs), std::end(kFeatureInputs),
+                                                [&input](const char *name) { return input.name == name; });
+        const bool planned = std::any_of(slots.begin(), slots.end(),
+                                         [&input](const InputSlot &slot) { return slot.name == input.name; });
+        if (isFeatureInput && !planned) {
+            return {Status_ModelLoadError,
+                    "The " + modelName + " model takes input \"" + input.name + "\", but the config does not enable it"};
+        }
+    }
+    return {};
+}
+
+DSONNXINFER_END_NAMESPACE
@@ -0,0 +1,92 @@
+#ifndef DS_ONNX_INFER_INPUTPLAN_P_H
+#define DS_ONNX_INFER_INPUTPLAN_P_H
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include <dsonnxinfer/dsonnxinfer_global.h>
+#include <dsonnxinfer/Status.h>
+#include <dsonnxinfer/DsConfig.h>
+#include <flowonnx/tensormap.h>
+
+#include "CompactSegment_p.h"
+
+DSONNXINFER_BEGIN_NAMESPACE
+
+enum InputSource {
+    // A parameter curve of the segment, resampled to frames
+    IS_Parameter = 0,
+    // A parameter predicted by the variance model, whose retake range goes into the retake input
+    IS_PredictedParameter,
+    // The retake mask of all predicted parameters, {1, frames, count}; {1, frames} if the
+    // slot has rank 2
+    IS_Retake,
+    // The speaker mix, {1, frames, SPK_EMBED_SIZE}; for the duration model the mix at the
+    // start of the segment, {1, phones, SPK_EMBED_SIZE}
+    IS_SpeakerEmbed,
+    // The phoneme durations in frames, {1, phones}
+    IS_PhonemeDurations,
+    // Whether each note is a rest, {1, notes}
+    IS_NoteRest,
+};
+
+struct InputSlot {
+    // Input name of the model; for parameters also the parameter tag.
+    std::string name;
+    InputSource source = IS_Parameter;
+    // The parameter read by IS_Parameter and IS_PredictedParameter slots
+    ParameterKind parameter = PK_Count;
+    flowonnx::Tensor::DataType type = flowonnx::Tensor::Float;
+    int rank = 2;
+    // A parameter that is missing from the segment is an error if required,
+    // and the constant `fallback` otherwise.
+    bool required = false;
+    float fallback = 0.0f;
+};
+
+/**
+ * @brief The frame-level inputs of a model, compiled from its config when it is opened.
+ *
+ * The feature flags of a config decide which parameters, speaker embeddings and masks
+ * a model takes. The plan resolves them once into an ordered list of slots, so that
+ * preprocessing a segment is a loop over the slots. Inputs that do not depend on the
+ * features (tokens, durations, pitch) are still built by the preprocessing itself.
+ */
+struct InputPlan {
+    std::vector<InputSlot> slots;
+    // Features of the config, for the shape of constant inputs
+    dsfeature_t features = 0;
+    // Number of IS_PredictedParameter slots
+    size_t predictedCount = 0;
+    // Speakers of the config, read by the IS_SpeakerEmbed slot. Copied, so that the plan
+    // stays valid independently of the config; the embeddings themselves are shared.
+    SpeakerEmbed spkEmb;
+    std::vector<std::string> speakers;
+
+    static InputPlan forAcoustic(const DsConfig &dsConfig);
+    static InputPlan forVariance(const DsVarianceConfig &dsVarianceConfig);
+    static InputPlan forPitch(const DsPitchConfig &dsPitchConfig);
+    static InputPlan forDuration(const DsDurConfig &dsDurConfig);
+
+    /**
+     * @brief Checks the slots against the inputs the models declare: each slot must be
+     *        declared with its type and rank, and each feature input declared by a model
+     *        must be enabled by the config. Models that cannot be read are not checked.
+     *
+     * @param reference The model of the config.
+     * @param selected  The variant picked by the precision policy, checked as well if it
+     *                  is another file.
+     */
+    Status validate(const std::filesystem::path &reference, const std::filesystem::path &selected,
+                    const std::string &modelName) const;
+
+private:
+    Status validateModel(const std::filesystem::path &model, const std::string &modelName) const;
+};
+
+DSONNXINFER_END_NAMESPACE
+
+#endif // DS_ONNX_INFER_INPUTPLAN_P_H
@@ -0,0 +1,227 @@
+#include "LinguisticEncoder_p.h"
+
+#include <algorithm>
+#include <exception>
+#include <utility>
+#include <vector>
+
+#include <dsonnxinfer/DsProject.h>
+
+#include "PhonemeDict_p.h"
+#include "CompactSegment_p.h"
+#include "TensorPool_p.h"
+#include "RunLimiter_p.h"
+#include "ModelVariant_p.h"
+#include "../core/Placement_p.h"
+
+DSONNXINFER_BEGIN_NAMESPACE
+
+// Segments whose encoder outputs are kept; the pitch and the variance model of a
+// segment usually run right after each other.
+static constexpr size_t kMaxCachedEncodings = 4;
+
+static flowonnx::Tensor copyTensor(const flowonnx::Tensor &tensor) {
+    flowonnx::Tensor result;
+    result.data = acquireTensorBuffer(tensor.data.size());
+    std::copy(tensor.data.begin(), tensor.data.end(), result.data.begin());
+    result.shape = tensor.shape;
+    result.type = tensor.type;
+    return result;
+}
+
+LinguisticEncoder::LinguisticEncoder() : m_handle("ds_linguistic") {
+}
+
+LinguisticEncoder::~LinguisticEncoder() {
+    m_handle.close();
+}
+
+std::shared_ptr<LinguisticEncoder> LinguisticEncoder::open(std::shared_ptr<const PhonemeDict> phonemeDict,
+                                                           const std::filesystem::path &reference,
+                                                           const std::filesystem::path &selected,
+                                                           bool predictDur, double frameLength,
+                                                           const InferenceOptions &options, Status *status) {
+    using Opened = std::pair<std::shared_ptr<LinguisticEncoder>, Status>;
+    struct CacheEntry {
+        std::weak_ptr<LinguisticEncoder> encoder;
+        // Set while the encoder is being opened, so that other callers wait for it.
+        std::shared_future<Opened> opening;
+    };
+    static std::mutex cacheMutex;
+    static std::unordered_map<std::string, CacheEntry> cache;
+
+    // Sessions are placed on a NUMA node, so encoders are only shared within a node.
+    const auto key = selected.lexically_normal().string() + '\n' +
+                     std::to_string(reinterpret_cast<uintptr_t>(phonemeDict.get())) + '\n' +
+                     std::to_string(predictDur) + '\n' + std::to_string(frameLength) + '\n' +
+                     std::to_string(options.numaNode) + '\n' + std::to_string(options.limitConcurrentRuns);
+
+    // The lock is only held for the lookup; opening a session and running the probe take
+    // long and must not block callers that open other encoders.
+    std::promise<Opened> promise;
+    {
+        std::unique_lock<std::mutex> lock(cacheMutex);
+        auto &entry = cache[key];
+        if (auto encoder = entry.encoder.lock()) {
+            putStatusOk(status);
+            return encoder;
+        }
+        if (entry.opening.valid()) {
+            auto opening = entry.opening;
+            lock.unlock();
+            auto [encoder, s] = opening.get();
+            if (status) {
+                *status = std::move(s);
+            }
+            return encoder;
+        }
+        entry.opening = promise.get_future().share();
+    }
+
+    auto publish = [&key](const std::shared_ptr<LinguisticEncoder> &encoder) {
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        auto &entry = cache[key];
+        entry.encoder = encoder;
+        entry.opening = {};
+    };
+
+    auto encoder = std::make_shared<LinguisticEncoder>();
+    encoder->m_phonemeDict = std::move(phonemeDict);
+    encoder->m_predictDur = predictDur;
+    encoder->m_frameLength = frameLength;
+    encoder->m_options = options;
+
+    Status s;
+    try {
+        Placement::Scope placement(options.numaNode);
+        // The probe bypasses the cache, so that each candidate model really runs.
+        s = openModelVariants(encoder->m_handle, {{reference, false}}, {{selected, false}}, options,
+                              [&encoder](Status *status) {
+                                  TensorPool pool;
+                                  TensorPool::Scope poolScope(&pool);
+                                  const auto &probe = *encoder->m_options.precisionProbe;
+                                  const CompactSegment segment(probe, encoder->m_phonemeDict.get());
+                                  return encoder->run(linguisticPreprocess(segment, encoder->m_frameLength,
+                                                                           encoder->m_predictDur),
+                                                      status);
+                              });
+    } catch (...) {
+        publish(nullptr);
+        promise.set_exception(std::current_exception());
+        throw;
+    }
+    if (!s.isOk()) {
+        publish(nullptr);
+        promise.set_value({nullptr, s});
+        if (status) {
+            *status = std::move(s);
+        }
+        return nullptr;
+    }
+    publish(encoder);
+    promise.set_value({encoder, Status()});
+    putStatusOk(status);
+    return encoder;
+}
+
+InferMap LinguisticEncoder::run(InferMap &&linguisticInputs, Status *status) {
+    Placement::Scope placement(m_options.numaNode);
+
+    flowonnx::InferenceData data;
+    data.inputData = std::move(linguisticInputs);
+    data.outputNames.emplace_back("encoder_out");
+
+    std::vector<flowonnx::InferenceData> dataList;
+    dataList.push_back(std::move(data));
+
+    std::string errorMessage;
+    InferMap result;
+    {
+        RunLimiter::Slot runSlot(m_options.limitConcurrentRuns);
+        result = m_handle.run(dataList, &errorMessage);
+    }
+    if (auto pool = TensorPool::current()) {
+        pool->recycle(dataList);
+    }
+
+    if (result.empty()) {
+        putStatus(status, Status_InferError, std::move(errorMessage));
+    } else {
+        putStatusOk(status);
+    }
+    return result;
+}
+
+bool LinguisticEncoder::encode(const CompactSegment &segment, InferMap &inputs, Status *status) {
+    // The key is taken from the encoder inputs, which are cheap to build.
+    auto linguisticInputs = linguisticPreprocess(segment, m_frameLength, m_predictDur);
+    const auto key = fingerprintInputs(linguisticInputs);
+    if (!m_predictDur) {
+        inputs["ph_dur"] = copyTensor(linguisticInputs["ph_dur"]);
+    }
+
+    std::shared_future<std::shared_ptr<const Result>> future;
+    std::promise<std::shared_ptr<const Result>> promise;
+    bool owner = false;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (auto it = m_results.find(key); it != m_results.end()) {
+            future = it->second;
+            m_order.remove(key);
+        } else {
+            // Another run of the same segment waits for this one.
+            future = promise.get_future().share();
+            m_results.emplace(key, future);
+            owner = true;
+        }
+        m_order.push_front(key);
+    }
+
+    if (owner) {
+        auto result = std::make_shared<Result>();
+        Status s;
+        try {
+            result->outputs = run(std::move(linguisticInputs), &s);
+        } catch (...) {
+            // Waiting runs of the segment get the exception; the key is not cached.
+            promise.set_exception(std::current_exception());
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_results.erase(key) != 0) {
+                m_order.remove(key);
+            }
+            throw;
+        }
+        result->errorMessage = std::move(s.msg);
+        promise.set_value(std::move(result));
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        evict();
+    } else if (auto pool = TensorPool::current()) {
+        pool->recycle(linguisticInputs);
+    }
+
+    const auto result = future.get();
+    const auto it = result->outputs.find("encoder_out");
+    if (it == result->outputs.end()) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        // Failed runs are not cached.
+        if (owner && m_results.erase(key) != 0) {
+            m_order.remove(key);
+        }
+        putStatus(status, Status_InferError,
+                  result->errorMessage.empty() ? "Linguistic encoder returned no encoder_out" : result->errorMessage);
+        return false;
+    }
+    inputs["encoder_out"] = copyTensor(it->second);
+    putStatusOk(status);
+    return true;
+}
+
+void LinguisticEncoder::evict() {
+    while (m_order.size() > kMaxCachedEncodings) {
+        m_results.erase(m_order.back());
+        m_order.pop_back();
+    }
+}
+
+DSONNXINFER_END_NAMESPACE
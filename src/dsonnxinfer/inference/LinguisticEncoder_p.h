@@ -0,0 +1,80 @@
+#ifndef DS_ONNX_INFER_LINGUISTICENCODER_P_H
+#define DS_ONNX_INFER_LINGUISTICENCODER_P_H
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <future>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include <dsonnxinfer/dsonnxinfer_global.h>
+#include <dsonnxinfer/Status.h>
+#include <dsonnxinfer/IInference.h>
+#include <flowonnx/inference.h>
+
+#include "InferenceCommon_p.h"
+#include "CompactSegment_p.h"
+
+DSONNXINFER_BEGIN_NAMESPACE
+
+/**
+ * @brief A linguistic encoder session shared by the pitch and variance models.
+ *
+ * Both models run a linguistic encoder on the same tokens and durations. When they use
+ * the same encoder model with the same phoneme dictionary, `predictDur` flag and frame
+ * length, they share one session, and the `encoder_out` of the last few segments is
+ * cached, so that the encoder runs once per segment.
+ */
+class LinguisticEncoder {
+public:
+    LinguisticEncoder();
+    ~LinguisticEncoder();
+
+    DSONNXINFER_DISABLE_COPY_MOVE(LinguisticEncoder)
+
+    /**
+     * @brief Returns the encoder of the given model, opening it if no inference object holds it.
+     *
+     * @param reference  The float32 model.
+     * @param selected   The model variant picked by the precision policy of `options`.
+     */
+    static std::shared_ptr<LinguisticEncoder> open(std::shared_ptr<const PhonemeDict> phonemeDict,
+                                                   const std::filesystem::path &reference,
+                                                   const std::filesystem::path &selected,
+                                                   bool predictDur, double frameLength,
+                                                   const InferenceOptions &options, Status *status);
+
+    /**
+     * @brief Encodes the segment and adds `encoder_out` to the inputs of the downstream
+     *        model, along with `ph_dur` if the durations are given.
+     */
+    bool encode(const CompactSegment &segment, InferMap &inputs, Status *status);
+
+private:
+    struct Result {
+        InferMap outputs;
+        std::string errorMessage;
+    };
+
+    InferMap run(InferMap &&linguisticInputs, Status *status);
+    void evict();
+
+    std::shared_ptr<const PhonemeDict> m_phonemeDict;
+    bool m_predictDur = false;
+    double m_frameLength = 0.0;
+    InferenceOptions m_options;
+    flowonnx::Inference m_handle;
+
+    std::mutex m_mutex;
+    // Fingerprints of the linguistic inputs, most recently used first
+    std::list<uint64_t> m_order;
+    std::unordered_map<uint64_t, std::shared_future<std::shared_ptr<const Result>>> m_results;
+};
+
+DSONNXINFER_END_NAMESPACE
+
+#endif // DS_ONNX_INFER_LINGUISTICENCODER_P_H
@@ -0,0 +1,67 @@
+#include "MelCache_p.h"
+
+#include <algorithm>
+
+#include "TensorPool_p.h"
+
+DSONNXINFER_BEGIN_NAMESPACE
+
+MelCache::MelCache(size_t capacity) : m_capacity(capacity) {
+}
+
+MelCache::~MelCache() = default;
+
+size_t MelCache::capacity() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_capacity;
+}
+
+void MelCache::setCapacity(size_t capacity) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_capacity = capacity;
+    evict();
+}
+
+bool MelCache::find(uint64_t key, flowonnx::Tensor *mel) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_index.find(key);
+    if (it == m_index.end()) {
+        return false;
+    }
+    m_entries.splice(m_entries.begin(), m_entries, it->second);
+    const auto &cached = it->second->mel;
+    mel->data = acquireTensorBuffer(cached.data.size());
+    std::copy(cached.data.begin(), cached.data.end(), mel->data.begin());
+    mel->shape = cached.shape;
+    mel->type = cached.type;
+    return true;
+}
+
+void MelCache::insert(uint64_t key, const flowonnx::Tensor &mel) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (mel.data.size() > m_capacity || m_index.count(key) != 0) {
+        return;
+    }
+    m_entries.push_front({key, mel});
+    m_index[key] = m_entries.begin();
+    m_bytes += mel.data.size();
+    evict();
+}
+
+void MelCache::clear() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_entries.clear();
+    m_index.clear();
+    m_bytes = 0;
+}
+
+void MelCache::evict() {
+    while (m_bytes > m_capacity && !m_entries.empty()) {
+        const auto &entry = m_entries.back();
+        m_bytes -= entry.mel.data.size();
+        m_index.erase(entry.key);
+        m_entries.pop_back();
+    }
+}
+
+DSONNXINFER_END_NAMESPACE
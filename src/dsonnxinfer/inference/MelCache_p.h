@@ -0,0 +1,60 @@
+#ifndef DS_ONNX_INFER_MELCACHE_P_H
+#define DS_ONNX_INFER_MELCACHE_P_H
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+#include <dsonnxinfer/dsonnxinfer_global.h>
+#include <flowonnx/tensormap.h>
+
+DSONNXINFER_BEGIN_NAMESPACE
+
+/**
+ * @brief Least recently used cache of the mel outputs of the acoustic model.
+ *
+ * Entries are keyed by the fingerprintInputs() of all acoustic model inputs, so a
+ * segment rendered again with unchanged inputs, e.g. with other vocoder settings, is
+ * only vocoded again. The tone shift is applied to the f0 of the acoustic model, so an
+ * edit of it misses the cache. A new cache is disabled (capacity 0).
+ */
+class MelCache {
+public:
+    explicit MelCache(size_t capacity = 0);
+    ~MelCache();
+
+    DSONNXINFER_DISABLE_COPY_MOVE(MelCache)
+
+    // In bytes; 0 disables the cache.
+    size_t capacity() const;
+    void setCapacity(size_t capacity);
+
+    /**
+     * @brief Copies the cached mel of `key` into `mel`, drawing the buffer from the current
+     *        tensor pool.
+     */
+    bool find(uint64_t key, flowonnx::Tensor *mel);
+    void insert(uint64_t key, const flowonnx::Tensor &mel);
+    void clear();
+
+private:
+    struct Entry {
+        uint64_t key;
+        flowonnx::Tensor mel;
+    };
+
+    void evict();
+
+    mutable std::mutex m_mutex;
+    size_t m_capacity;
+    size_t m_bytes = 0;
+    // Most recently used first
+    std::list<Entry> m_entries;
+    std::unordered_map<uint64_t, std::list<Entry>::iterator> m_index;
+};
+
+DSONNXINFER_END_NAMESPACE
+
+#endif // DS_ONNX_INFER_MELCACHE_P_H
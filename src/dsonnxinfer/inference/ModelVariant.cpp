@@ -0,0 +1,189 @@
+#include "ModelVariant_p.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <string>
+
+#include <dsonnxinfer/Environment.h>
+
+DSONNXINFER_BEGIN_NAMESPACE
+
+std::filesystem::path selectModelVariant(const std::filesystem::path &reference, const ModelVariants &variants,
+                                         const InferenceOptions &options) {
+    switch (options.precisionPolicy) {
+        case PP_QualityFirst:
+            break;
+        case PP_Explicit:
+            if (auto it = variants.find(options.precision); it != variants.end()) {
+                return it->second;
+            }
+            break;
+        case PP_Fastest: {
+            // int8 kernels are the fastest on CPU, while GPUs run float16 natively.
+            const auto env = Environment::instance();
+            const bool gpu = env && env->executionProvider() != EP_CPU;
+            const ModelPrecision order[] = {gpu ? MP_Float16 : MP_Int8, gpu ? MP_Int8 : MP_Float16};
+            for (auto precision : order) {
+                if (auto it = variants.find(precision); it != variants.end()) {
+                    return it->second;
+                }
+            }
+            break;
+        }
+    }
+    return reference;
+}
+
+// Decodes an IEEE 754 half-precision number.
+static float halfToFloat(uint16_t half) {
+    const int exponent = (half >> 10) & 0x1f;
+    const int mantissa = half & 0x3ff;
+    float value;
+    if (exponent == 0) {
+        value = std::ldexp(static_cast<float>(mantissa), -24);
+    } else if (exponent == 0x1f) {
+        value = mantissa ? std::numeric_limits<float>::quiet_NaN() : std::numeric_limits<float>::infinity();
+    } else {
+        value = std::ldexp(static_cast<float>(mantissa | 0x400), exponent - 25);
+    }
+    return (half & 0x8000) ? -value : value;
+}
+
+// The values of a float32 or float16 tensor as floats; false for other tensors. The runtime
+// hands out float16 outputs as float tensors with two bytes per element.
+static bool floatValues(const flowonnx::Tensor &tensor, std::vector<float> *values) {
+    if (tensor.type == flowonnx::Tensor::Int64 || tensor.type == flowonnx::Tensor::Bool) {
+        return false;
+    }
+    size_t count = 1;
+    for (const auto dim : tensor.shape) {
+        count *= static_cast<size_t>((std::max)(dim, int64_t{0}));
+    }
+    const size_t bytes = tensor.data.size();
+    if (bytes == count * sizeof(float)) {
+        values->resize(count);
+        std::memcpy(values->data(), tensor.data.data(), bytes);
+        return true;
+    }
+    if (bytes == count * sizeof(uint16_t)) {
+        values->resize(count);
+        for (size_t i = 0; i < count; ++i) {
+            uint16_t half;
+            std::memcpy(&half, tensor.data.data() + i * sizeof(half), sizeof(half));
+            (*values)[i] = halfToFloat(half);
+        }
+        return true;
+    }
+    return false;
+}
+
+double relativeOutputError(const InferMap &reference, const InferMap &output) {
+    double maxError = 0.0;
+    std::vector<float> a;
+    std::vector<float> b;
+    for (const auto &[name, expected] : reference) {
+        if (!floatValues(expected, &a)) {
+            continue;
+        }
+        auto it = output.find(name);
+        if (it == output.end() || !floatValues(it->second, &b) || b.size() != a.size()) {
+            return std::numeric_limits<double>::infinity();
+        }
+        double errorSum = 0.0;
+        double referenceSum = 0.0;
+        for (size_t i = 0; i < a.size(); ++i) {
+            const double diff = static_cast<double>(a[i]) - b[i];
+            errorSum += diff * diff;
+            referenceSum += static_cast<double>(a[i]) * a[i];
+        }
+        if (referenceSum > 0) {
+            maxError = (std::max)(maxError, std::sqrt(errorSum / referenceSum));
+        } else if (errorSum > 0) {
+            return std::numeric_limits<double>::infinity();
+        }
+    }
+    return maxError;
+}
+
+// Opens the reference or the selected models of all sessions; on failure, none stays open.
+static bool openSessions(const std::vector<SessionModels> &sessions, bool selected, std::string *errorMessage) {
+    for (size_t i = 0; i < sessions.size(); ++i) {
+        const auto &session = sessions[i];
+        if (!session.handle->open(selected ? session.selected : session.reference, errorMessage)) {
+            for (size_t j = 0; j < i; ++j) {
+                sessions[j].handle->close();
+            }
+            return false;
+        }
+    }
+    return true;
+}
+
+static void closeSessions(const std::vector<SessionModels> &sessions) {
+    for (const auto &session : sessions) {
+        session.handle->close();
+    }
+}
+
+Status openModelVariants(const std::vector<SessionModels> &sessions, const InferenceOptions &options,
+                         const std::function<InferMap(Status *)> &runProbe) {
+    std::string errorMessage;
+    const bool hasVariants = std::any_of(sessions.begin(), sessions.end(), [](const SessionModels &session) {
+        return session.selected != session.reference;
+    });
+    if (!hasVariants || !options.precisionProbe || !options.runPrecisionProbe) {
+        if (!openSessions(sessions, true, &errorMessage)) {
+            return {Status_ModelLoadError, errorMessage};
+        }
+        return {Status_Ok, ""};
+    }
+
+    // Diffusion models sample noise, so the reference is run twice to measure its own variation.
+    if (!openSessions(sessions, false, &errorMessage)) {
+        return {Status_ModelLoadError, errorMessage};
+    }
+    Status probeStatus;
+    const auto expected = runProbe(&probeStatus);
+    InferMap again;
+    if (probeStatus.isOk()) {
+        again = runProbe(&probeStatus);
+    }
+    closeSessions(sessions);
+    if (!probeStatus.isOk()) {
+        return {Status_ModelLoadError, "Precision probe failed on the reference models: " + probeStatus.msg};
+    }
+    const double baseline = relativeOutputError(expected, again);
+
+    std::string rejection;
+    if (openSessions(sessions, true, &errorMessage)) {
+        const auto output = runProbe(&probeStatus);
+        if (!probeStatus.isOk()) {
+            rejection = probeStatus.msg;
+        } else {
+            const double error = relativeOutputError(expected, output);
+            if (error <= baseline + options.precisionTolerance) {
+                return {Status_Ok, ""};
+            }
+            rejection = "relative error " + std::to_string(error) + " against " + std::to_string(baseline);
+        }
+        closeSessions(sessions);
+    } else {
+        rejection = errorMessage;
+    }
+
+    if (!openSessions(sessions, false, &errorMessage)) {
+        return {Status_ModelLoadError, errorMessage};
+    }
+    // Still usable, so the status is Ok; the message tells why the variants are not used.
+    return {Status_Ok, "Precision variant rejected, using the reference models: " + rejection};
+}
+
+Status openModelVariants(flowonnx::Inference &handle, const ModelList &reference, const ModelList &selected,
+                         const InferenceOptions &options, const std::function<InferMap(Status *)> &runProbe) {
+    return openModelVariants({{&handle, reference, selected}}, options, runProbe);
+}
+
+DSONNXINFER_END_NAMESPACE
@@ -0,0 +1,54 @@
+#ifndef DS_ONNX_INFER_MODELVARIANT_P_H
+#define DS_ONNX_INFER_MODELVARIANT_P_H
+
+#include <filesystem>
+#include <functional>
+#include <utility>
+#include <vector>
+
+#include <dsonnxinfer/dsonnxinfer_global.h>
+#include <dsonnxinfer/IInference.h>
+#include <flowonnx/inference.h>
+
+#include "InferenceCommon_p.h"
+
+DSONNXINFER_BEGIN_NAMESPACE
+
+// Models of an inference session, with their "prefer CPU" flags
+using ModelList = std::vector<std::pair<std::filesystem::path, bool>>;
+
+/**
+ * @brief The model of the precision policy of `options`, or `reference` if it has no such variant.
+ */
+std::filesystem::path selectModelVariant(const std::filesystem::path &reference, const ModelVariants &variants,
+                                         const InferenceOptions &options);
+
+/**
+ * @brief Relative RMS error of `output` against `reference`, the maximum over their float tensors.
+ *        Float16 outputs are converted to float first; an output missing from `output` or of
+ *        another size gives infinity.
+ */
+double relativeOutputError(const InferMap &reference, const InferMap &output);
+
+// An inference session with its reference and its selected models
+struct SessionModels {
+    flowonnx::Inference *handle;
+    ModelList reference;
+    ModelList selected;
+};
+
+/**
+ * @brief Opens the selected models. If they are variants and `options` has a precision probe
+ *        that is enabled, they are checked against the reference models first, and the reference models are
+ *        opened instead if the check fails.
+ *
+ * @param runProbe Runs the probe segment on the opened sessions.
+ */
+Status openModelVariants(const std::vector<SessionModels> &sessions, const InferenceOptions &options,
+                         const std::function<InferMap(Status *)> &runProbe);
+Status openModelVariants(flowonnx::Inference &handle, const ModelList &reference, const ModelList &selected,
+                         const InferenceOptions &options, const std::function<InferMap(Status *)> &runProbe);
+
+DSONNXINFER_END_NAMESPACE
+
+#endif // DS_ONNX_INFER_MODELVARIANT_P_H
@@ -0,0 +1,622 @@
+#include "PhonemeDict_p.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <mutex>
+#include <random>
+#include <unordered_map>
+
+#include <dsonnxinfer/Environment.h>
+
+#include "InferenceCommon_p.h"
+#include "../utils/SymbolTable_p.h"
+
+DSONNXINFER_BEGIN_NAMESPACE
+
+namespace fs = std::filesystem;
+
+namespace {
+    constexpr char kDictMagic[8] = {'D', 'S', 'P', 'H', 'D', 'I', 'C', 'T'};
+    constexpr uint32_t kDictVersion = 1;
+    constexpr uint32_t kDictByteOrderMark = 0x01020304;
+    constexpr uint32_t kDictFlagMultiLanguage = 1;
+
+    struct DictFileStamp {
+        uint64_t size;
+        int64_t mtime;
+        uint64_t hash;
+    };
+
+    struct DictHeader {
+        char magic[8];
+        uint32_t version;
+        uint32_t byteOrderMark;
+        uint32_t flags;
+        uint32_t languageCount;
+        uint32_t phonemeCount;
+        uint32_t languageSlotCount;
+        uint32_t phonemeSlotCount;
+        uint32_t reserved;
+        DictFileStamp phonemesStamp;
+        DictFileStamp languagesStamp;
+        uint64_t languageNamesOffset;
+        uint64_t phonemeNamesOffset;
+        uint64_t languageSlotsOffset;
+        uint64_t phonemeSlotsOffset;
+        uint64_t tokensOffset;
+        uint64_t languageTokensOffset;
+        uint64_t poolOffset;
+        uint64_t poolSize;
+        uint64_t totalSize;
+    };
+
+    inline uint64_t hashBytes(const char *data, size_t size) {
+        // FNV-1a
+        uint64_t h = 14695981039346656037ull;
+        for (size_t i = 0; i < size; ++i) {
+            h ^= static_cast<unsigned char>(data[i]);
+            h *= 1099511628211ull;
+        }
+        return h;
+    }
+
+    inline uint64_t hashName(std::string_view name) {
+        return hashBytes(name.data(), name.size());
+    }
+
+    inline bool isRestPhoneme(std::string_view token) {
+        return token == "SP" || token == "AP";
+    }
+
+    // Size and modification time; the content hash is only read when they do not match.
+    bool statFile(const fs::path &path, DictFileStamp &stamp) {
+        std::error_code ec;
+        const auto size = fs::file_size(path, ec);
+        if (ec) {
+            return false;
+        }
+        const auto mtime = fs::last_write_time(path, ec);
+        if (ec) {
+            return false;
+        }
+        stamp.size = size;
+        stamp.mtime = static_cast<int64_t>(mtime.time_since_epoch().count());
+        stamp.hash = 0;
+        return true;
+    }
+
+    bool hashFile(const fs::path &path, uint64_t &hash) {
+        std::ifstream file(path, std::ios::binary);
+        if (!file.is_open()) {
+            return false;
+        }
+        const std::string content{std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+        hash = hashBytes(content.data(), content.size());
+        return true;
+    }
+
+    // Whether a file with the current size and modification time `current` is still the one
+    // `recorded` was taken from. Files that were only touched are recognized by their hash;
+    // `verifiedMtime` then takes the new time, so that they are hashed only once.
+    bool matchesStamp(const fs::path &path, const DictFileStamp &current, const DictFileStamp &recorded,
+                      int64_t &verifiedMtime) {
+        if (current.size != recorded.size) {
+            return false;
+        }
+        if (current.mtime == verifiedMtime) {
+            return true;
+        }
+        uint64_t hash;
+        if (!hashFile(path, hash) || hash != recorded.hash) {
+            return false;
+        }
+        verifiedMtime = current.mtime;
+        return true;
+    }
+
+    int32_t findName(const char *pool, const uint32_t *names, const int32_t *slots, uint32_t slotCount,
+                     std::string_view name) {
+        if (slotCount == 0) {
+            return -1;
+        }
+        const size_t mask = slotCount - 1;
+        for (size_t i = hashName(name) & mask;; i = (i + 1) & mask) {
+            const auto index = slots[i];
+            if (index < 0) {
+                return -1;
+            }
+            if (std::string_view(pool + names[2 * index], names[2 * index + 1]) == name) {
+                return index;
+            }
+        }
+    }
+
+    // Open addressing string set, used while compiling the dictionary
+    struct NameIndexBuilder {
+        std::vector<uint32_t> names;
+        std::vector<int32_t> slots;
+
+        uint32_t size() const {
+            return static_cast<uint32_t>(names.size() / 2);
+        }
+
+        int32_t find(const std::string &pool, std::string_view name) const {
+            return findName(pool.data(), names.data(), slots.data(), static_cast<uint32_t>(slots.size()), name);
+        }
+
+        void insert(std::string &pool, std::string_view name) {
+            if (find(pool, name) >= 0) {
+                return;
+            }
+            // Keep load factor at most 1/2, so that lookups always find an empty slot
+            if ((size() + 1) * 2 > slots.size()) {
+                rehash(pool, (std::max)(size_t{16}, slots.size() * 2));
+            }
+            const auto index = static_cast<int32_t>(size());
+            names.push_back(static_cast<uint32_t>(pool.size()));
+            names.push_back(static_cast<uint32_t>(name.size()));
+            pool.append(name);
+            place(name, index);
+        }
+
+        void rehash(const std::string &pool, size_t capacity) {
+            slots.assign(capacity, -1);
+            for (uint32_t index = 0; index < size(); ++index) {
+                place(std::string_view(pool.data() + names[2 * index], names[2 * index + 1]),
+                      static_cast<int32_t>(index));
+            }
+        }
+
+        void place(std::string_view name, int32_t index) {
+            const size_t mask = slots.size() - 1;
+            size_t i = hashName(name) & mask;
+            while (slots[i] >= 0) {
+                i = (i + 1) & mask;
+            }
+            slots[i] = index;
+        }
+    };
+
+    inline uint64_t align8(uint64_t offset) {
+        return (offset + 7) & ~uint64_t{7};
+    }
+
+    std::vector<char> compileDict(const std::unordered_map<std::string, int64_t> &name2token,
+                                  const std::unordered_map<std::string, int64_t> &languages,
+                                  bool multiLanguage,
+                                  const DictFileStamp &phonemesStamp,
+                                  const DictFileStamp &languagesStamp) {
+        std::string pool;
+        NameIndexBuilder languageIndex;
+        NameIndexBuilder phonemeIndex;
+
+        // Intern language and phoneme names. Keys of the phonemes file are either
+        // `phoneme` or `language/phoneme`.
+        for (const auto &[key, value] : name2token) {
+            std::string_view name(key);
+            if (const auto pos = name.find('/'); pos != std::string_view::npos) {
+                languageIndex.insert(pool, name.substr(0, pos));
+                phonemeIndex.insert(pool, name.substr(pos + 1));
+            } else {
+                phonemeIndex.insert(pool, name);
+            }
+        }
+        for (const auto &[key, value] : languages) {
+            languageIndex.insert(pool, key);
+        }
+
+        const size_t langCount = languageIndex.size();
+        const size_t phCount = phonemeIndex.size();
+
+        std::vector<int64_t> tokens((langCount + 1) * phCount, -1);
+        for (const auto &[key, value] : name2token) {
+            std::string_view name(key);
+            if (const auto pos = name.find('/'); pos != std::string_view::npos) {
+                const auto lang = languageIndex.find(pool, name.substr(0, pos)) + 1;
+                const auto ph = phonemeIndex.find(pool, name.substr(pos + 1));
+                tokens[lang * phCount + ph] = value;
+            } else {
+                tokens[phonemeIndex.find(pool, name)] = value;
+            }
+        }
+
+        std::vector<int64_t> languageTokens(langCount + 1, 0);
+        for (const auto &[key, value] : languages) {
+            languageTokens[languageIndex.find(pool, key) + 1] = value;
+        }
+
+        DictHeader header{};
+        std::memcpy(header.magic, kDictMagic, sizeof(kDictMagic));
+        header.version = kDictVersion;
+        header.byteOrderMark = kDictByteOrderMark;
+        header.flags = multiLanguage ? kDictFlagMultiLanguage : 0;
+        header.languageCount = static_cast<uint32_t>(langCount);
+        header.phonemeCount = static_cast<uint32_t>(phCount);
+        header.languageSlotCount = static_cast<uint32_t>(languageIndex.slots.size());
+        header.phonemeSlotCount = static_cast<uint32_t>(phonemeIndex.slots.size());
+        header.phonemesStamp = phonemesStamp;
+        header.languagesStamp = languagesStamp;
+
+        uint64_t offset = align8(sizeof(DictHeader));
+        auto section = [&offset](uint64_t &sectionOffset, size_t bytes) {
+            sectionOffset = offset;
+            offset = align8(offset + bytes);
+        };
+        section(header.languageNamesOffset, languageIndex.names.size() * sizeof(uint32_t));
+        section(header.phonemeNamesOffset, phonemeIndex.names.size() * sizeof(uint32_t));
+        section(header.languageSlotsOffset, languageIndex.slots.size() * sizeof(int32_t));
+        section(header.phonemeSlotsOffset, phonemeIndex.slots.size() * sizeof(int32_t));
+        section(header.tokensOffset, tokens.size() * sizeof(int64_t));
+        section(header.languageTokensOffset, languageTokens.size() * sizeof(int64_t));
+        section(header.poolOffset, pool.size());
+        header.poolSize = pool.size();
+        header.totalSize = offset;
+
+        std::vector<char> buffer(offset, 0);
+        auto write = [&buffer](uint64_t sectionOffset, const void *data, size_t bytes) {
+            if (bytes > 0) {
+                std::memcpy(buffer.data() + sectionOffset, data, bytes);
+            }
+        };
+        write(0, &header, sizeof(header));
+        write(header.languageNamesOffset, languageIndex.names.data(), languageIndex.names.size() * sizeof(uint32_t));
+        write(header.phonemeNamesOffset, phonemeIndex.names.data(), phonemeIndex.names.size() * sizeof(uint32_t));
+        write(header.languageSlotsOffset, languageIndex.slots.data(), languageIndex.slots.size() * sizeof(int32_t));
+        write(header.phonemeSlotsOffset, phonemeIndex.slots.data(), phonemeIndex.slots.size() * sizeof(int32_t));
+        write(header.tokensOffset, tokens.data(), tokens.size() * sizeof(int64_t));
+        write(header.languageTokensOffset, languageTokens.data(), languageTokens.size() * sizeof(int64_t));
+        write(header.poolOffset, pool.data(), pool.size());
+        return buffer;
+    }
+
+    bool validateNames(const uint32_t *names, uint32_t count, uint64_t poolSize) {
+        for (uint32_t i = 0; i < count; ++i) {
+            if (names[2 * i] > poolSize || names[2 * i + 1] > poolSize - names[2 * i]) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool validateSlots(const int32_t *slots, uint32_t slotCount, uint32_t count) {
+        if (slotCount == 0) {
+            return count == 0;
+        }
+        if ((slotCount & (slotCount - 1)) != 0 || uint64_t{count} * 2 > slotCount) {
+            return false;
+        }
+        return std::all_of(slots, slots + slotCount, [count](int32_t index) {
+            return index >= -1 && index < static_cast<int64_t>(count);
+        });
+    }
+
+    // Compiled dictionaries are named after the phonemes file and a hash of the source
+    // paths, in the cache directory of the environment.
+    fs::path compiledDictPath(const fs::path &phonemes, const std::string &key) {
+        const auto env = Environment::instance();
+        const auto directory = env ? env->cacheDirectory() : Environment::defaultCacheDirectory();
+        if (directory.empty()) {
+            return {};
+        }
+        char hex[17];
+        std::snprintf(hex, sizeof(hex), "%016llx", static_cast<unsigned long long>(hashName(key)));
+        auto fileName = phonemes.filename();
+        fileName += '-';
+        fileName += hex;
+        fileName += ".dsdict";
+        return directory / fileName;
+    }
+
+    void writeCompiledDict(const fs::path &path, const std::vector<char> &buffer) {
+        // Best effort: the cache directory may not be writable.
+        std::error_code ec;
+        fs::create_directories(path.parent_path(), ec);
+        auto tmpPath = path;
+        tmpPath += ".tmp" + std::to_string(std::random_device{}());
+        {
+            std::ofstream file(tmpPath, std::ios::binary | std::ios::trunc);
+            if (!file.is_open()) {
+                return;
+            }
+            file.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+            if (!file) {
+                file.close();
+                fs::remove(tmpPath, ec);
+                return;
+            }
+        }
+        fs::rename(tmpPath, path, ec);
+        if (ec) {
+            fs::remove(tmpPath, ec);
+        }
+    }
+}
+
+PhonemeDict::PhonemeDict() = default;
+
+PhonemeDict::~PhonemeDict() = default;
+
+bool PhonemeDict::attach(const char *data, size_t size) {
+    m_data = nullptr;
+    if (size < sizeof(DictHeader) || reinterpret_cast<uintptr_t>(data) % alignof(int64_t) != 0) {
+        return false;
+    }
+    const auto &header = *reinterpret_cast<const DictHeader *>(data);
+    if (std::memcmp(header.magic, kDictMagic, sizeof(kDictMagic)) != 0 ||
+        header.version != kDictVersion ||
+        header.byteOrderMark != kDictByteOrderMark ||
+        header.totalSize != size) {
+        return false;
+    }
+
+    auto sectionOk = [size](uint64_t offset, uint64_t count, uint64_t elementSize) {
+        return offset % 8 == 0 && offset <= size && count <= (size - offset) / elementSize;
+    };
+    const uint64_t tokenCount = (uint64_t{header.languageCount} + 1) * header.phonemeCount;
+    if (!sectionOk(header.languageNamesOffset, uint64_t{header.languageCount} * 2, sizeof(uint32_t)) ||
+        !sectionOk(header.phonemeNamesOffset, uint64_t{header.phonemeCount} * 2, sizeof(uint32_t)) ||
+        !sectionOk(header.languageSlotsOffset, header.languageSlotCount, sizeof(int32_t)) ||
+        !sectionOk(header.phonemeSlotsOffset, header.phonemeSlotCount, sizeof(int32_t)) ||
+        !sectionOk(header.tokensOffset, tokenCount, sizeof(int64_t)) ||
+        !sectionOk(header.languageTokensOffset, uint64_t{header.languageCount} + 1, sizeof(int64_t)) ||
+        !sectionOk(header.poolOffset, header.poolSize, 1)) {
+        return false;
+    }
+
+    const auto languageNames = reinterpret_cast<const uint32_t *>(data + header.languageNamesOffset);
+    const auto phonemeNames = reinterpret_cast<const uint32_t *>(data + header.phonemeNamesOffset);
+    const auto languageSlots = reinterpret_cast<const int32_t *>(data + header.languageSlotsOffset);
+    const auto phonemeSlots = reinterpret_cast<const int32_t *>(data + header.phonemeSlotsOffset);
+    if (!validateNames(languageNames, header.languageCount, header.poolSize) ||
+        !validateNames(phonemeNames, header.phonemeCount, header.poolSize) ||
+        !validateSlots(languageSlots, header.languageSlotCount, header.languageCount) ||
+        !validateSlots(phonemeSlots, header.phonemeSlotCount, header.phonemeCount)) {
+        return false;
+    }
+
+    m_data = data;
+    m_pool = data + header.poolOffset;
+    m_languageNames = languageNames;
+    m_phonemeNames = phonemeNames;
+    m_languageSlots = languageSlots;
+    m_phonemeSlots = phonemeSlots;
+    m_tokens = reinterpret_cast<const int64_t *>(data + header.tokensOffset);
+    m_languageTokens = reinterpret_cast<const int64_t *>(data + header.languageTokensOffset);
+    m_languageCount = header.languageCount;
+    m_phonemeCount = header.phonemeCount;
+    m_languageSlotCount = header.languageSlotCount;
+    m_phonemeSlotCount = header.phonemeSlotCount;
+    m_multiLanguage = (header.flags & kDictFlagMultiLanguage) != 0;
+    m_phonemesMtime = header.phonemesStamp.mtime;
+    m_languagesMtime = header.languagesStamp.mtime;
+    return true;
+}
+
+std::shared_ptr<const PhonemeDict> PhonemeDict::load(const fs::path &phonemes,
+                                                     const fs::path &languages,
+                                                     bool multiLanguage,
+                                                     std::string *errorMessage) {
+    static std::mutex cacheMutex;
+    static std::unordered_map<std::string, std::weak_ptr<const PhonemeDict>> cache;
+
+    DictFileStamp phonemesStamp{};
+    DictFileStamp languagesStamp{};
+    if (!statFile(phonemes, phonemesStamp)) {
+        if (errorMessage) {
+            *errorMessage = "Failed to read phonemes file: " + phonemes.string();
+        }
+        return nullptr;
+    }
+    if (multiLanguage && !statFile(languages, languagesStamp)) {
+        if (errorMessage) {
+            *errorMessage = "Failed to read languages file: " + languages.string();
+        }
+        return nullptr;
+    }
+
+    // Called with the cache lock held, which guards the verified modification times.
+    auto isUpToDate = [&](const PhonemeDict &dict) {
+        const auto &header = *reinterpret_cast<const DictHeader *>(dict.m_data);
+        return dict.m_multiLanguage == multiLanguage &&
+               matchesStamp(phonemes, phonemesStamp, header.phonemesStamp, dict.m_phonemesMtime) &&
+               (!multiLanguage ||
+                matchesStamp(languages, languagesStamp, header.languagesStamp, dict.m_languagesMtime));
+    };
+
+    std::error_code ec;
+    auto key = fs::absolute(phonemes, ec).lexically_normal().string();
+    if (multiLanguage) {
+        key += '\n';
+        key += fs::absolute(languages, ec).lexically_normal().string();
+    }
+
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    if (auto it = cache.find(key); it != cache.end()) {
+        if (auto dict = it->second.lock(); dict && isUpToDate(*dict)) {
+            return dict;
+        }
+    }
+
+    auto dict = std::make_shared<PhonemeDict>();
+    const auto compiledPath = compiledDictPath(phonemes, key);
+    if (compiledPath.empty() ||
+        !dict->m_mapped.open(compiledPath) ||
+        !dict->attach(dict->m_mapped.data(), dict->m_mapped.size()) ||
+        !isUpToDate(*dict)) {
+        dict->m_mapped.close();
+
+        if (!hashFile(phonemes, phonemesStamp.hash) ||
+            (multiLanguage && !hashFile(languages, languagesStamp.hash))) {
+            if (errorMessage) {
+                *errorMessage = "Failed to read phoneme dictionary: " + phonemes.string();
+            }
+            return nullptr;
+        }
+
+        std::unordered_map<std::string, int64_t> name2token;
+        std::unordered_map<std::string, int64_t> languageIds;
+        try {
+            if (multiLanguage) {
+                readLangIdFile(languages, languageIds);
+            }
+            if (isFileExtJson(phonemes)) {
+                readMultiLangPhonemesFile(phonemes, name2token);
+            } else {
+                readPhonemesFile(phonemes, name2token);
+            }
+        } catch (const std::exception &e) {
+            if (errorMessage) {
+                *errorMessage = std::string("Failed to parse phoneme dictionary: ") + e.what();
+            }
+            return nullptr;
+        }
+
+        dict->m_storage = compileDict(name2token, languageIds, multiLanguage, phonemesStamp, languagesStamp);
+        if (!dict->attach(dict->m_storage.data(), dict->m_storage.size())) {
+            if (errorMessage) {
+                *errorMessage = "Failed to build phoneme dictionary";
+            }
+            return nullptr;
+        }
+        if (!compiledPath.empty()) {
+            writeCompiledDict(compiledPath, dict->m_storage);
+        }
+    }
+    dict->indexSymbols();
+
+    cache[key] = dict;
+    return dict;
+}
+
+void PhonemeDict::indexSymbols() {
+    auto name = [this](const uint32_t *names, uint32_t index) {
+        return std::string_view(m_pool + names[2 * index], names[2 * index + 1]);
+    };
+    auto place = [](auto &table, int32_t symbol, auto value, auto absent) {
+        if (symbol < 0) {
+            return;
+        }
+        if (static_cast<size_t>(symbol) >= table.size()) {
+            table.resize(symbol + 1, absent);
+        }
+        table[symbol] = value;
+    };
+
+    for (uint32_t lang = 0; lang < m_languageCount; ++lang) {
+        place(m_languageBySymbol, SymbolTable::intern(name(m_languageNames, lang)),
+              static_cast<int32_t>(lang + 1), NoLanguage);
+    }
+    for (uint32_t ph = 0; ph < m_phonemeCount; ++ph) {
+        place(m_phonemeBySymbol, SymbolTable::intern(name(m_phonemeNames, ph)),
+              static_cast<int32_t>(ph), UnknownPhoneme);
+    }
+    std::string tagged;
+    for (uint32_t lang = 0; lang < m_languageCount; ++lang) {
+        for (uint32_t ph = 0; ph < m_phonemeCount; ++ph) {
+            const auto t = m_tokens[(lang + 1) * size_t{m_phonemeCount} + ph];
+            if (t < 0) {
+                continue;
+            }
+            tagged.assign(name(m_languageNames, lang));
+            tagged += '/';
+            tagged += name(m_phonemeNames, ph);
+            place(m_taggedTokenBySymbol, SymbolTable::intern(tagged), t, int64_t{0});
+        }
+    }
+}
+
+bool PhonemeDict::isMultiLanguage() const {
+    return m_multiLanguage;
+}
+
+int32_t PhonemeDict::languageCount() const {
+    return static_cast<int32_t>(m_languageCount);
+}
+
+int32_t PhonemeDict::phonemeCount() const {
+    return static_cast<int32_t>(m_phonemeCount);
+}
+
+int32_t PhonemeDict::languageId(std::string_view language) const {
+    return findName(m_pool, m_languageNames, m_languageSlots, m_languageSlotCount, language) + 1;
+}
+
+int32_t PhonemeDict::phonemeId(std::string_view phoneme) const {
+    return findName(m_pool, m_phonemeNames, m_phonemeSlots, m_phonemeSlotCount, phoneme);
+}
+
+int64_t PhonemeDict::token(int32_t languageId, int32_t phonemeId) const {
+    if (phonemeId < 0) {
+        return 0;
+    }
+    if (languageId != NoLanguage) {
+        if (const auto t = m_tokens[languageId * size_t{m_phonemeCount} + phonemeId]; t >= 0) {
+            return t;
+        }
+    }
+    const auto t = m_tokens[phonemeId];
+    return t >= 0 ? t : 0;
+}
+
+int64_t PhonemeDict::languageToken(int32_t languageId) const {
+    if (languageId < 0 || languageId > static_cast<int32_t>(m_languageCount)) {
+        return 0;
+    }
+    return m_languageTokens[languageId];
+}
+
+int64_t PhonemeDict::lookupToken(std::string_view token, std::string_view language) const {
+    const auto ph = phonemeId(token);
+    if (ph >= 0) {
+        const auto lang = (language.empty() || isRestPhoneme(token)) ? NoLanguage : languageId(language);
+        return this->token(lang, ph);
+    }
+
+    // The phoneme may already carry a language tag (lang/phoneme).
+    if (const auto pos = token.find('/'); pos != std::string_view::npos) {
+        const auto lang = languageId(token.substr(0, pos));
+        const auto ph2 = phonemeId(token.substr(pos + 1));
+        if (lang != NoLanguage && ph2 >= 0) {
+            const auto t = m_tokens[lang * size_t{m_phonemeCount} + ph2];
+            return t >= 0 ? t : 0;
+        }
+    }
+    return 0;
+}
+
+int64_t PhonemeDict::lookupLanguage(std::string_view language) const {
+    return languageToken(languageId(language));
+}
+
+int64_t PhonemeDict::phoneToken(const Phoneme &phone, int32_t tokenSymbol, int32_t languageSymbol) const {
+    // All names of the dictionary are interned and indexed, so a name without a symbol, or
+    // with a symbol missing from the tables, is not in the dictionary.
+    if (tokenSymbol < 0) {
+        return 0;
+    }
+    const auto ph = static_cast<size_t>(tokenSymbol) < m_phonemeBySymbol.size() ? m_phonemeBySymbol[tokenSymbol]
+                                                                                 : UnknownPhoneme;
+    if (ph < 0) {
+        return static_cast<size_t>(tokenSymbol) < m_taggedTokenBySymbol.size() ? m_taggedTokenBySymbol[tokenSymbol]
+                                                                               : 0;
+    }
+    if (phone.language.empty() || isRestPhoneme(phone.token)) {
+        return token(NoLanguage, ph);
+    }
+    const auto lang = languageSymbol >= 0 && static_cast<size_t>(languageSymbol) < m_languageBySymbol.size()
+                          ? m_languageBySymbol[languageSymbol]
+                          : NoLanguage;
+    return token(lang, ph);
+}
+
+int64_t PhonemeDict::phoneLanguage(int32_t languageSymbol) const {
+    const auto lang = languageSymbol >= 0 && static_cast<size_t>(languageSymbol) < m_languageBySymbol.size()
+                          ? m_languageBySymbol[languageSymbol]
+                          : NoLanguage;
+    return languageToken(lang);
+}
+
+DSONNXINFER_END_NAMESPACE
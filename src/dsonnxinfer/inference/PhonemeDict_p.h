@@ -0,0 +1,144 @@
+#ifndef DS_ONNX_INFER_PHONEMEDICT_P_H
+#define DS_ONNX_INFER_PHONEMEDICT_P_H
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <dsonnxinfer/dsonnxinfer_global.h>
+#include <dsonnxinfer/DsProject.h>
+
+#include "../utils/MappedFile_p.h"
+
+DSONNXINFER_BEGIN_NAMESPACE
+
+/**
+ * @brief Interned phoneme and language dictionary of an opened model.
+ *
+ * Phoneme names and language names are interned into compact integer IDs when the
+ * dictionary is built. Tokens are stored in a flat (languageId, phonemeId) table, so
+ * that tokenizing a phoneme is a hash lookup on a string_view followed by an array
+ * lookup, without building `language/phoneme` strings for every phone.
+ *
+ * Language ID 0 is reserved for "no language", i.e. phonemes looked up without
+ * the language prefix.
+ *
+ * When loaded, the dictionary also interns its names as process-wide symbols (see
+ * SymbolTable) and maps them to its IDs, so that phones whose symbols were looked up
+ * once are tokenized by phoneToken() and phoneLanguage() with array lookups only.
+ *
+ * The dictionary lives in a single position-independent buffer, which is also the
+ * format of the compiled dictionary file (`<phonemes file>-<hash>.dsdict`) written to
+ * the cache directory of the environment. When the compiled file is up to date it is
+ * memory-mapped and used as is, instead of parsing the phonemes and languages files
+ * again. Source files are compared by size and modification time, and only hashed
+ * when the time changed.
+ */
+class PhonemeDict {
+public:
+    static constexpr int32_t NoLanguage = 0;
+    static constexpr int32_t UnknownPhoneme = -1;
+
+    PhonemeDict();
+    ~PhonemeDict();
+
+    DSONNXINFER_DISABLE_COPY_MOVE(PhonemeDict)
+
+    /**
+     * @brief Loads the dictionary of a model.
+     *
+     * Dictionaries are shared between all inference objects that reference the same
+     * phonemes and languages files, as long as at least one of them holds it.
+     *
+     * @param phonemes       The phonemes file (plain text or json).
+     * @param languages      The languages file. Ignored if `multiLanguage` is false.
+     * @param multiLanguage  Whether the model uses language IDs.
+     * @param errorMessage   The optional error message output.
+     * @return               The dictionary, or nullptr on failure.
+     */
+    static std::shared_ptr<const PhonemeDict> load(const std::filesystem::path &phonemes,
+                                                   const std::filesystem::path &languages,
+                                                   bool multiLanguage,
+                                                   std::string *errorMessage = nullptr);
+
+    bool isMultiLanguage() const;
+
+    int32_t languageCount() const;
+    int32_t phonemeCount() const;
+
+    int32_t languageId(std::string_view language) const;
+    int32_t phonemeId(std::string_view phoneme) const;
+
+    /**
+     * @brief Finds the token of an interned phoneme.
+     *
+     * Tries the phoneme with the language tag first, then the phoneme without
+     * the language tag. Returns 0 if neither exists.
+     */
+    int64_t token(int32_t languageId, int32_t phonemeId) const;
+
+    /**
+     * @brief Finds the language token (as in the languages file) of an interned language.
+     */
+    int64_t languageToken(int32_t languageId) const;
+
+    /**
+     * @brief Tokenizes a phone as given in the segment.
+     *
+     * Equivalent to looking up `language/token` and then `token` in the phonemes file,
+     * except for `SP` and `AP`, which are always looked up without the language tag.
+     */
+    int64_t lookupToken(std::string_view token, std::string_view language) const;
+    int64_t lookupLanguage(std::string_view language) const;
+
+    /**
+     * @brief Same as lookupToken() and lookupLanguage(), by the symbols of the token and
+     *        the language of the phone, as found by SymbolTable::find(). A name without a
+     *        symbol is in no dictionary.
+     */
+    int64_t phoneToken(const Phoneme &phone, int32_t tokenSymbol, int32_t languageSymbol) const;
+    int64_t phoneLanguage(int32_t languageSymbol) const;
+
+private:
+    bool attach(const char *data, size_t size);
+    void indexSymbols();
+
+    std::vector<char> m_storage;
+    MappedFile m_mapped;
+
+    // Views into the dictionary buffer (either m_storage or m_mapped)
+    const char *m_data = nullptr;
+    const char *m_pool = nullptr;
+    // (offset, length) pairs into the pool
+    const uint32_t *m_languageNames = nullptr;
+    const uint32_t *m_phonemeNames = nullptr;
+    const int32_t *m_languageSlots = nullptr;
+    const int32_t *m_phonemeSlots = nullptr;
+    // (languageCount + 1) * phonemeCount, -1 if the phoneme does not exist for the language.
+    const int64_t *m_tokens = nullptr;
+    // languageCount + 1
+    const int64_t *m_languageTokens = nullptr;
+
+    // Indexed by symbol: the language ID (NoLanguage if absent), the phoneme ID
+    // (UnknownPhoneme if absent), and the token of tagged `language/phoneme` names (0 if absent).
+    std::vector<int32_t> m_languageBySymbol;
+    std::vector<int32_t> m_phonemeBySymbol;
+    std::vector<int64_t> m_taggedTokenBySymbol;
+
+    // Modification times at which the source files were last found to match the dictionary
+    mutable int64_t m_phonemesMtime = 0;
+    mutable int64_t m_languagesMtime = 0;
+
+    uint32_t m_languageCount = 0;
+    uint32_t m_phonemeCount = 0;
+    uint32_t m_languageSlotCount = 0;
+    uint32_t m_phonemeSlotCount = 0;
+    bool m_multiLanguage = false;
+};
+
+DSONNXINFER_END_NAMESPACE
+
+#endif // DS_ONNX_INFER_PHONEMEDICT_P_H
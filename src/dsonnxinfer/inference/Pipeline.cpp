@@ -0,0 +1,191 @@
+#include "Pipeline.h"
+
+#include <dsonnxinfer/AcousticInference.h>
+#include <dsonnxinfer/DurationInference.h>
+#include <dsonnxinfer/PitchInference.h>
+#include <dsonnxinfer/VarianceInference.h>
+#include "../utils/Fnv1a_p.h"
+
+DSONNXINFER_BEGIN_NAMESPACE
+
+class Pipeline::Impl {
+public:
+    explicit Impl(const Voicebank &voicebank) : voicebank(voicebank) {
+    }
+
+    bool runStage(VoicebankStage stage, Segment &dsSegment, AudioBuffer &waveform, Status *status) const {
+        switch (stage) {
+            case VS_Duration:
+                return duration->runInPlace(dsSegment, status);
+            case VS_Pitch:
+                return pitch->runInPlace(dsSegment, status);
+            case VS_Variance:
+                return variance->runInPlace(dsSegment, status);
+            case VS_Acoustic: {
+                Status s;
+                waveform = acoustic->runToBuffer(dsSegment, &s);
+                if (status) {
+                    *status = s;
+                }
+                return s.isOk();
+            }
+            default:
+                putStatusOk(status);
+                return true;
+        }
+    }
+
+    // Fingerprint of the settings of a stage's inference object that change its outputs
+    uint64_t settings(VoicebankStage stage) const {
+        Fnv1a hash;
+        switch (stage) {
+            case VS_Pitch:
+                hash.value(pitch->steps());
+                hash.value(pitch->depth());
+                hash.value(pitch->deadline());
+                break;
+            case VS_Variance:
+                hash.value(variance->steps());
+                hash.value(variance->depth());
+                hash.value(variance->deadline());
+                break;
+            case VS_Acoustic:
+                hash.value(acoustic->steps());
+                hash.value(acoustic->depth());
+                hash.value(acoustic->deadline());
+                hash.value(acoustic->maxChunkFrames());
+                hash.value(acoustic->vocoderChunkFrames());
+                hash.value(acoustic->vocoderChunkOverlapFrames());
+                break;
+            default:
+                break;
+        }
+        return hash.result();
+    }
+
+    const Voicebank &voicebank;
+    std::unique_ptr<DurationInference> duration;
+    std::unique_ptr<PitchInference> pitch;
+    std::unique_ptr<VarianceInference> variance;
+    std::unique_ptr<AcousticInference> acoustic;
+};
+
+Pipeline::Pipeline(const Voicebank &voicebank) : _impl(std::make_unique<Impl>(voicebank)) {
+}
+
+Pipeline::~Pipeline() = default;
+
+Status Pipeline::open(const InferenceOptions &options) {
+    auto &impl = *_impl;
+    close();
+    if (!impl.voicebank.isLoaded()) {
+        return {Status_GenericError, "Voice bank not loaded"};
+    }
+
+    const auto openStage = [&options](auto &inference) {
+        return inference->open(options);
+    };
+    for (const auto stage : impl.voicebank.stageOrder()) {
+        Status s;
+        switch (stage) {
+            case VS_Duration:
+                impl.duration = std::make_unique<DurationInference>(impl.voicebank.durationConfig());
+                s = openStage(impl.duration);
+                break;
+            case VS_Pitch:
+                impl.pitch = std::make_unique<PitchInference>(impl.voicebank.pitchConfig());
+                s = openStage(impl.pitch);
+                break;
+            case VS_Variance:
+                impl.variance = std::make_unique<VarianceInference>(impl.voicebank.varianceConfig());
+                s = openStage(impl.variance);
+                break;
+            case VS_Acoustic:
+                impl.acoustic = std::make_unique<AcousticInference>(impl.voicebank.acousticConfig(),
+                                                                    impl.voicebank.vocoderConfig());
+                s = openStage(impl.acoustic);
+                break;
+            default:
+                break;
+        }
+        if (!s.isOk()) {
+            close();
+            return s;
+        }
+    }
+    return {};
+}
+
+void Pipeline::close() {
+    auto &impl = *_impl;
+    if (impl.acoustic) {
+        impl.acoustic->close();
+        impl.acoustic.reset();
+    }
+    if (impl.variance) {
+        impl.variance->close();
+        impl.variance.reset();
+    }
+    if (impl.pitch) {
+        impl.pitch->close();
+        impl.pitch.reset();
+    }
+    if (impl.duration) {
+        impl.duration->close();
+        impl.duration.reset();
+    }
+}
+
+bool Pipeline::isOpen() const {
+    auto &impl = *_impl;
+    return impl.acoustic != nullptr;
+}
+
+IInference *Pipeline::inference(VoicebankStage stage) const {
+    auto &impl = *_impl;
+    switch (stage) {
+        case VS_Duration:
+            return impl.duration.get();
+        case VS_Pitch:
+            return impl.pitch.get();
+        case VS_Variance:
+            return impl.variance.get();
+        case VS_Acoustic:
+            return impl.acoustic.get();
+        default:
+            return nullptr;
+    }
+}
+
+AudioBuffer Pipeline::run(Segment &dsSegment, StageTracker &tracker, Status *status) {
+    auto &impl = *_impl;
+    if (!isOpen()) {
+        putStatus(status, Status_GenericError, "Pipeline not open");
+        return {};
+    }
+    for (const auto stage : impl.voicebank.stageOrder()) {
+        if (!tracker.prepare(stage, dsSegment, impl.settings(stage))) {
+            continue;
+        }
+        AudioBuffer waveform;
+        if (!impl.runStage(stage, dsSegment, waveform, status)) {
+            // Forget the runs, since the segment may be partly written.
+            tracker.reset();
+            return {};
+        }
+        tracker.commit(stage, dsSegment);
+        if (stage == VS_Acoustic) {
+            tracker.setWaveform(std::move(waveform));
+        }
+    }
+    putStatusOk(status);
+    return tracker.waveform();
+}
+
+AudioBuffer Pipeline::run(Segment &dsSegment, Status *status) {
+    auto &impl = *_impl;
+    StageTracker tracker(impl.voicebank);
+    return run(dsSegment, tracker, status);
+}
+
+DSONNXINFER_END_NAMESPACE
@@ -0,0 +1,63 @@
+#ifndef DS_ONNX_INFER_PIPELINE_H
+#define DS_ONNX_INFER_PIPELINE_H
+
+#include <memory>
+
+#include <dsonnxinfer/dsonnxinfer_global.h>
+#include <dsonnxinfer/Status.h>
+#include <dsonnxinfer/AudioBuffer.h>
+#include <dsonnxinfer/DsProject.h>
+#include <dsonnxinfer/Voicebank.h>
+#include <dsonnxinfer/IInference.h>
+#include <dsonnxinfer/StageTracker.h>
+
+DSONNXINFER_BEGIN_NAMESPACE
+
+/**
+ * @brief Runs all stages of a voice bank on a segment, from the phones to the waveform.
+ *
+ * With a StageTracker, only the stages whose inputs changed since the last run of the
+ * same segment run again; e.g. editing `gender` only runs the acoustic model, and editing
+ * a note runs everything from the duration model on. Changing the settings of an
+ * inference object (see inference()), such as its steps or depth, runs its stage again.
+ */
+class DSONNXINFER_EXPORT Pipeline {
+public:
+    explicit Pipeline(const Voicebank &voicebank);
+    ~Pipeline();
+
+    DSONNXINFER_DISABLE_COPY_MOVE(Pipeline)
+
+public:
+    /**
+     * @brief Opens the inference objects of all stages present in the voice bank.
+     */
+    Status open(const InferenceOptions &options = {});
+    void close();
+    bool isOpen() const;
+
+    /**
+     * @brief The inference object of a stage, for its settings; nullptr if the stage is
+     *        not present or the pipeline is not open. The vocoder is part of the acoustic stage.
+     */
+    IInference *inference(VoicebankStage stage) const;
+
+    /**
+     * @brief Runs the stages the tracker reports as dirty, writing their outputs into the
+     *        segment, and returns the waveform.
+     */
+    AudioBuffer run(Segment &dsSegment, StageTracker &tracker, Status *status);
+
+    /**
+     * @brief Runs all stages.
+     */
+    AudioBuffer run(Segment &dsSegment, Status *status);
+
+protected:
+    class Impl;
+    std::unique_ptr<Impl> _impl;
+};
+
+DSONNXINFER_END_NAMESPACE
+
+#endif // DS_ONNX_INFER_PIPELINE_H
@@ -1,6 +1,7 @@
 
 #include "PitchInference.h"
 
+#include <chrono>
 #include <fstream>
 #include <utility>
 #include <cstring>
@@ -8,6 +9,16 @@
 
 #include <flowonnx/inference.h>
 #include "InferenceCommon_p.h"
+#include "CompactSegment_p.h"
+#include "PhonemeDict_p.h"
+#include "TensorPool_p.h"
+#include "RunLimiter_p.h"
+#include "ModelVariant_p.h"
+#include "InputPlan_p.h"
+#include "LinguisticEncoder_p.h"
+#include "DiffusionScheduler_p.h"
+#include "../core/Placement_p.h"
+#include "../core/CurveKernels_p.h"
 #include <dsonnxinfer/Environment.h>
 
 DSONNXINFER_BEGIN_NAMESPACE
@@ -20,63 +31,114 @@ public:
             depth(Environment::instance()->defaultDepth()) {}
 
     Status open() {
-        if (dsPitchConfig.features & kfMultiLanguage) {
-            readLangIdFile(dsPitchConfig.languages, languages);
-        }
-        if (isFileExtJson(dsPitchConfig.phonemes)) {
-            readMultiLangPhonemesFile(dsPitchConfig.phonemes, name2token);
-        } else {
-            readPhonemesFile(dsPitchConfig.phonemes, name2token);
-        }
-
         std::string errorMessage;
-        if (!inferenceHandle.open({{dsPitchConfig.linguistic, false}, {dsPitchConfig.pitch, false}}, &errorMessage)) {
+        phonemeDict = PhonemeDict::load(dsPitchConfig.phonemes, dsPitchConfig.languages,
+                                        dsPitchConfig.features & kfMultiLanguage, &errorMessage);
+        if (!phonemeDict) {
             return {Status_ModelLoadError, errorMessage};
         }
 
-        return {Status_Ok, ""};
+        const auto linguistic = selectModelVariant(dsPitchConfig.linguistic, dsPitchConfig.linguisticVariants, options);
+        const auto pitch = selectModelVariant(dsPitchConfig.pitch, dsPitchConfig.pitchVariants, options);
+        inputPlan = InputPlan::forPitch(dsPitchConfig);
+        if (auto s = inputPlan.validate(dsPitchConfig.pitch, pitch, "pitch"); !s.isOk()) {
+            return s;
+        }
+
+        // The session threads inherit the placement of this thread.
+        Placement::Scope placement(options.numaNode);
+        ModelList reference = {{dsPitchConfig.pitch, false}};
+        ModelList selected = {{pitch, false}};
+        if (options.shareLinguisticEncoder) {
+            const double frameLength = 1.0 * dsPitchConfig.hopSize / dsPitchConfig.sampleRate;
+            const bool predictDur = dsPitchConfig.features & kfLinguisticPredictDur;
+            Status s;
+            encoder = LinguisticEncoder::open(phonemeDict, dsPitchConfig.linguistic, linguistic,
+                                              predictDur, frameLength, options, &s);
+            if (!encoder) {
+                return s;
+            }
+        } else {
+            reference.insert(reference.begin(), {dsPitchConfig.linguistic, false});
+            selected.insert(selected.begin(), {linguistic, false});
+        }
+        const auto result = openModelVariants(inferenceHandle, reference, selected, options, [this](Status *status) {
+            return infer(*options.precisionProbe, status);
+        });
+        // The probe runs are not representative of the runtime.
+        scheduler.reset();
+        return result;
     }
 
     void close() {
         inferenceHandle.close();
+        encoder.reset();
+        inputPlan = {};
         dsPitchConfig = {};
-        name2token.clear();
-        languages.clear();
+        phonemeDict.reset();
+        tensorPool.clear();
+        scheduler.reset();
     }
 
     InferMap infer(const Segment &dsSegment, Status *status) {
+        const auto start = std::chrono::steady_clock::now();
+        TensorPool::Scope poolScope(&tensorPool);
+        Placement::Scope placement(options.numaNode);
+
         int sampleRate = dsPitchConfig.sampleRate;
         int hopSize = dsPitchConfig.hopSize;
         double frameLength = 1.0 * hopSize / sampleRate;
         bool predictDur = dsPitchConfig.features & kfLinguisticPredictDur;
 
-        auto linguisticInputData = linguisticPreprocess(name2token, languages, dsSegment, frameLength, predictDur);
-        auto pitchInputData = pitchProcess(dsSegment, dsPitchConfig, frameLength, predictDur);
+        const CompactSegment segment(dsSegment, phonemeDict.get());
+        auto pitchInputData = pitchProcess(segment, inputPlan, frameLength);
 
         const int64_t shapeArr = 1;
 
+        // The depth is not an input of this model.
+        auto plan = scheduler.plan(getFrameCount(dsSegment, frameLength),
+                                   DiffusionScheduler::remaining(deadline, start),
+                                   steps, depth, dsPitchConfig.features & kfContinuousAcceleration, false);
         if (dsPitchConfig.features & kfContinuousAcceleration) {
-            pitchInputData["steps"] = flowonnx::Tensor::create(&steps, 1, &shapeArr, 1);
+            pitchInputData["steps"] = flowonnx::Tensor::create(&plan.info.steps, 1, &shapeArr, 1);
         } else {
-            int64_t speedup = getSpeedupFromSteps(steps);
+            int64_t speedup = getSpeedupFromSteps(plan.info.steps);
             pitchInputData["speedup"] = flowonnx::Tensor::create(&speedup, 1, &shapeArr, 1);
         }
 
-        flowonnx::InferenceData dataLinguistic, dataPitch;
-
-        dataLinguistic.inputData = std::move(linguisticInputData);
-        dataLinguistic.bindings.push_back({1, "encoder_out", "encoder_out", false});
-        if (!predictDur) {
-            dataLinguistic.bindings.push_back({1, "ph_dur", "ph_dur", true});
+        std::vector<flowonnx::InferenceData> dataList;
+        dataList.reserve(2);
+        if (encoder) {
+            // The encoder outputs become inputs of the pitch model.
+            if (!encoder->encode(segment, pitchInputData, status)) {
+                tensorPool.recycle(pitchInputData);
+                return {};
+            }
+        } else {
+            flowonnx::InferenceData dataLinguistic;
+            dataLinguistic.inputData = linguisticPreprocess(segment, frameLength, predictDur);
+            dataLinguistic.bindings.push_back({1, "encoder_out", "encoder_out", false});
+            if (!predictDur) {
+                dataLinguistic.bindings.push_back({1, "ph_dur", "ph_dur", true});
+            }
+            dataLinguistic.outputNames.emplace_back("x_masks");
+            dataList.push_back(std::move(dataLinguistic));
         }
-        dataLinguistic.outputNames.emplace_back("x_masks");
+
+        flowonnx::InferenceData dataPitch;
         dataPitch.inputData = std::move(pitchInputData);
         dataPitch.outputNames.emplace_back("pitch_pred");
-
-        std::vector dataList{dataLinguistic, dataPitch};
+        dataList.push_back(std::move(dataPitch));
 
         std::string errorMessage;
-        auto result = inferenceHandle.run(dataList, &errorMessage);
+        flowonnx::TensorMap result;
+        {
+            RunLimiter::Slot runSlot(options.limitConcurrentRuns);
+            result = inferenceHandle.run(dataList, &errorMessage);
+        }
+        tensorPool.recycle(dataList);
+
+        scheduler.finish(std::move(plan), !result.empty());
 
         if (status) {
             if (result.empty()) {
@@ -95,11 +157,17 @@ public:
     }
 
     DsPitchConfig dsPitchConfig;
-    std::unordered_map<std::string, int64_t> name2token;
-    std::unordered_map<std::string, int64_t> languages;
+    InputPlan inputPlan;
+    std::shared_ptr<const PhonemeDict> phonemeDict;
+    TensorPool tensorPool;
+    InferenceOptions options;
     flowonnx::Inference inferenceHandle;
+    // The shared linguistic encoder, if enabled; otherwise the encoder is part of inferenceHandle.
+    std::shared_ptr<LinguisticEncoder> encoder;
+    DiffusionScheduler scheduler;
     float depth;
     int64_t steps;
+    double deadline = 0.0;
 };
 
 PitchInference::PitchInference(DsPitchConfig &&dsPitchConfig)
@@ -120,6 +188,7 @@ PitchInference::PitchInference(const DsPitchConfig &dsPitchConfig)
 
 Status PitchInference::open() {
     auto &impl = *_impl;
+    impl.options = m_options;
     return impl.open();
 }
 
@@ -138,6 +207,21 @@ void PitchInference::setSteps(int64_t steps) {
     impl.steps = steps;
 }
 
+void PitchInference::setDeadline(double seconds) {
+    auto &impl = *_impl;
+    impl.deadline = seconds;
+}
+
+double PitchInference::deadline() const {
+    auto &impl = *_impl;
+    return impl.deadline;
+}
+
+DiffusionRunInfo PitchInference::lastRunInfo() const {
+    auto &impl = *_impl;
+    return impl.scheduler.lastRun();
+}
+
 float PitchInference::depth() const {
     auto &impl = *_impl;
     return impl.depth;
@@ -167,17 +251,24 @@ bool PitchInference::runInPlace(Segment &dsSegment, Status *status) {
 
         // Copy predicted pitch data to original segment pitch parameter (overwrite existing)
         auto &pitchParam = dsSegment.parameters["pitch"];
+        pitchParam.sample_curve.points.clear();
         pitchParam.sample_curve.samples.resize(bufferSize);
-        std::copy(buffer, buffer + bufferSize, pitchParam.sample_curve.samples.begin());
+        CurveKernels::toDouble(buffer, bufferSize, pitchParam.sample_curve.samples.data());
         pitchParam.tag = "pitch";
         pitchParam.sample_curve.timestep = frameLength;
         pitchParam.retake_start = 0;
         pitchParam.retake_end = bufferSize;
+        impl.tensorPool.recycle(result);
         return true;
     }
     return false;
 }
 
+TensorPoolStats PitchInference::tensorPoolStats() const {
+    auto &impl = *_impl;
+    return impl.tensorPool.stats();
+}
+
 bool PitchInference::terminate() {
     auto &impl = *_impl;
     return impl.terminate();
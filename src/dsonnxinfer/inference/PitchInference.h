@@ -13,6 +13,7 @@ public:
     explicit PitchInference(const DsPitchConfig &dsPitchConfig);
     ~PitchInference() override;
 
+    using IInference::open;
     Status open() override;
     void close() override;
 
@@ -21,10 +22,25 @@ public:
     void setDepth(float depth);
     void setSteps(int64_t steps);
 
+    /**
+     * @brief Latency deadline of a run in seconds, up to the predicted pitch curve; 0 (the
+     *        default) always runs with steps(). With a deadline, the steps are lowered as far
+     *        as the runtimes observed by this object suggest, down to a single step.
+     */
+    double deadline() const;
+    void setDeadline(double seconds);
+
+    /**
+     * @brief The steps of the last run, with its expected and actual runtime.
+     */
+    DiffusionRunInfo lastRunInfo() const;
+
     //InferMap infer(const Segment &dsSegment, Status *status) override;
     bool runInPlace(Segment &dsSegment, Status *status);
     bool terminate() override;
 
+    TensorPoolStats tensorPoolStats() const override;
+
 protected:
     class Impl;
     std::unique_ptr<Impl> _impl;
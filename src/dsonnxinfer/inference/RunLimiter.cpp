@@ -0,0 +1,51 @@
+#include "RunLimiter_p.h"
+
+#include <algorithm>
+
+DSONNXINFER_BEGIN_NAMESPACE
+
+RunLimiter &RunLimiter::global() {
+    static RunLimiter limiter;
+    return limiter;
+}
+
+int RunLimiter::maxConcurrentRuns() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_maxRuns;
+}
+
+void RunLimiter::setMaxConcurrentRuns(int count) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_maxRuns = (std::max)(count, 0);
+    }
+    m_cv.notify_all();
+}
+
+void RunLimiter::acquire() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_cv.wait(lock, [this] { return m_maxRuns == 0 || m_runs < m_maxRuns; });
+    ++m_runs;
+}
+
+void RunLimiter::release() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        --m_runs;
+    }
+    m_cv.notify_one();
+}
+
+RunLimiter::Slot::Slot(bool enabled) : m_enabled(enabled) {
+    if (m_enabled) {
+        global().acquire();
+    }
+}
+
+RunLimiter::Slot::~Slot() {
+    if (m_enabled) {
+        global().release();
+    }
+}
+
+DSONNXINFER_END_NAMESPACE
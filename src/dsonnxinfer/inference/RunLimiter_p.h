@@ -0,0 +1,49 @@
+#ifndef DS_ONNX_INFER_RUNLIMITER_P_H
+#define DS_ONNX_INFER_RUNLIMITER_P_H
+
+#include <condition_variable>
+#include <mutex>
+
+#include <dsonnxinfer/dsonnxinfer_global.h>
+
+DSONNXINFER_BEGIN_NAMESPACE
+
+/**
+ * @brief Caps the number of model runs in flight across all inference objects.
+ *
+ * Every run uses the operator threads of the runtime, so running many inference
+ * objects at once oversubscribes the cores. Runs beyond the limit wait for a slot.
+ */
+class RunLimiter {
+public:
+    static RunLimiter &global();
+
+    // 0 means unlimited.
+    int maxConcurrentRuns() const;
+    void setMaxConcurrentRuns(int count);
+
+    void acquire();
+    void release();
+
+    // Holds a slot of the global limiter for its lifetime, if enabled.
+    class Slot {
+    public:
+        explicit Slot(bool enabled);
+        ~Slot();
+
+        DSONNXINFER_DISABLE_COPY_MOVE(Slot)
+
+    private:
+        bool m_enabled;
+    };
+
+private:
+    mutable std::mutex m_mutex;
+    std::condition_variable m_cv;
+    int m_maxRuns = 0;
+    int m_runs = 0;
+};
+
+DSONNXINFER_END_NAMESPACE
+
+#endif // DS_ONNX_INFER_RUNLIMITER_P_H
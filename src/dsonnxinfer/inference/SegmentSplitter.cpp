@@ -0,0 +1,208 @@
+#include "SegmentSplitter_p.h"
+
+#include <algorithm>
+#include <cmath>
+
+DSONNXINFER_BEGIN_NAMESPACE
+
+namespace {
+    struct CutPoint {
+        size_t wordIndex;
+        // Cut time relative to the segment
+        double time;
+        // Half of the overlap between the two chunks
+        double padding;
+    };
+
+    bool isRestWord(const Word &word) {
+        if (word.phones.size() != 1 || word.notes.empty()) {
+            return false;
+        }
+        const auto &token = word.phones[0].token;
+        if (token == "SP" || token == "AP") {
+            return true;
+        }
+        return std::all_of(word.notes.begin(), word.notes.end(), [](const Note &note) { return note.is_rest; });
+    }
+
+    // Notes of the part `[from, to)` of a word, in seconds relative to the word.
+    std::vector<Note> sliceNotes(const std::vector<Note> &notes, double from, double to) {
+        std::vector<Note> result;
+        double noteStart = 0.0;
+        for (const auto &note : notes) {
+            const double noteEnd = noteStart + note.duration;
+            const double begin = (std::max)(noteStart, from);
+            const double end = (std::min)(noteEnd, to);
+            if (end > begin) {
+                auto &sliced = result.emplace_back(note);
+                sliced.duration = end - begin;
+            }
+            noteStart = noteEnd;
+        }
+        return result;
+    }
+
+    // Resamples a curve so that its first sample is at `from` (in seconds), covering at least `to`.
+    SampleCurve sliceCurve(const SampleCurve &curve, double from, double to) {
+        if (curve.isConstant()) {
+            return curve;
+        }
+        if (curve.isPiecewise()) {
+            // Keep the breakpoints inside the range, and pin the values at its ends.
+            std::vector<SampleCurve::Point> points;
+            points.push_back({0.0, curve.valueAt(from)});
+            for (const auto &point : curve.points) {
+                if (point.time > from && point.time < to) {
+                    points.push_back({point.time - from, point.value});
+                }
+            }
+            points.push_back({to - from, curve.valueAt(to)});
+            return SampleCurve::fromPoints(std::move(points), curve.timestep);
+        }
+        if (curve.samples.size() <= 1 || curve.timestep <= 0) {
+            return curve;
+        }
+        const auto count = static_cast<size_t>(std::ceil((to - from) / curve.timestep)) + 2;
+        const auto last = curve.samples.size() - 1;
+        SampleCurve result;
+        result.timestep = curve.timestep;
+        result.samples.resize(count);
+        for (size_t i = 0; i < count; ++i) {
+            const double x = (from + static_cast<double>(i) * curve.timestep) / curve.timestep;
+            if (x <= 0) {
+                result.samples[i] = curve.samples.front();
+            } else if (x >= static_cast<double>(last)) {
+                result.samples[i] = curve.samples.back();
+            } else {
+                const auto index = static_cast<size_t>(x);
+                const double frac = x - static_cast<double>(index);
+                result.samples[i] = curve.samples[index] + frac * (curve.samples[index + 1] - curve.samples[index]);
+            }
+        }
+        return result;
+    }
+
+    Segment makeChunk(const Segment &dsSegment, const std::vector<double> &wordStarts,
+                      const CutPoint *head, const CutPoint *tail, double chunkStart, double chunkEnd) {
+        Segment chunk;
+        chunk.offset = dsSegment.offset + chunkStart;
+
+        const size_t firstWord = head ? head->wordIndex : 0;
+        const size_t lastWord = tail ? tail->wordIndex : dsSegment.words.size() - 1;
+        chunk.words.reserve(lastWord - firstWord + 1);
+        for (size_t i = firstWord; i <= lastWord; ++i) {
+            const auto &word = dsSegment.words[i];
+            const bool isHead = head && i == head->wordIndex;
+            const bool isTail = tail && i == tail->wordIndex;
+            if (!isHead && !isTail) {
+                chunk.words.push_back(word);
+                continue;
+            }
+            // Part of a rest word
+            const double from = isHead ? chunkStart - wordStarts[i] : 0.0;
+            const double to = isTail ? chunkEnd - wordStarts[i] : word.duration();
+            Word part;
+            part.phones = word.phones;
+            if (isHead) {
+                // The rest phone starts with the chunk.
+                part.phones[0].start = 0.0;
+            }
+            part.notes = sliceNotes(word.notes, from, to);
+            chunk.words.push_back(std::move(part));
+        }
+
+        for (const auto &[name, param] : dsSegment.parameters) {
+            auto &sliced = chunk.parameters[name];
+            sliced.tag = param.tag;
+            sliced.sample_curve = sliceCurve(param.sample_curve, chunkStart, chunkEnd);
+        }
+        chunk.speakers.spk.reserve(dsSegment.speakers.spk.size());
+        for (const auto &[name, curve] : dsSegment.speakers.spk) {
+            chunk.speakers.spk[name] = sliceCurve(curve, chunkStart, chunkEnd);
+        }
+        return chunk;
+    }
+}
+
+std::vector<SegmentChunk> splitSegmentAtRests(const Segment &dsSegment, double frameLength,
+                                              int64_t maxChunkFrames, double padding) {
+    const auto &words = dsSegment.words;
+    if (maxChunkFrames <= 0 || frameLength <= 0 || words.size() < 3) {
+        return {};
+    }
+    std::vector<double> wordStarts(words.size() + 1, 0.0);
+    for (size_t i = 0; i < words.size(); ++i) {
+        wordStarts[i + 1] = wordStarts[i] + words[i].duration();
+    }
+    const double totalDuration = wordStarts.back();
+    const double budget = static_cast<double>(maxChunkFrames) * frameLength;
+    if (totalDuration <= budget) {
+        return {};
+    }
+
+    // Cut candidates: the middle of each rest phone, which spans from its own start to the
+    // start of the first phone of the next word.
+    std::vector<CutPoint> candidates;
+    for (size_t i = 1; i + 1 < words.size(); ++i) {
+        const auto &word = words[i];
+        if (!isRestWord(word)) {
+            continue;
+        }
+        const auto &nextWord = words[i + 1];
+        const double restBegin = wordStarts[i] + word.phones[0].start;
+        const double restEnd = wordStarts[i + 1] + (nextWord.phones.empty() ? 0.0 : nextWord.phones[0].start);
+        const double halfLength = (restEnd - restBegin) / 2;
+        if (halfLength < 2 * frameLength) {
+            continue;
+        }
+        // Cut and pad on whole frames, so that the frames of each chunk line up with the
+        // frames of the whole segment.
+        const double time = std::round((restBegin + halfLength) / frameLength) * frameLength;
+        // Keep the halves inside the word, so that no word but the rest word is cut.
+        if (time <= wordStarts[i] || time >= wordStarts[i + 1]) {
+            continue;
+        }
+        const double maxPadding = (std::min)({halfLength / 2, time - wordStarts[i], wordStarts[i + 1] - time});
+        const double paddingFrames = std::floor((std::max)(0.0, (std::min)(padding, maxPadding)) / frameLength);
+        candidates.push_back({i, time, paddingFrames * frameLength});
+    }
+
+    // Greedily take the last candidate that keeps the chunk within the budget.
+    std::vector<const CutPoint *> cuts;
+    double chunkStart = 0.0;
+    const CutPoint *lastFit = nullptr;
+    for (size_t i = 0; i < candidates.size(); ++i) {
+        const auto &candidate = candidates[i];
+        if (candidate.time + candidate.padding - chunkStart <= budget) {
+            lastFit = &candidate;
+            continue;
+        }
+        const CutPoint *cut = lastFit ? lastFit : &candidate;
+        cuts.push_back(cut);
+        chunkStart = cut->time - cut->padding;
+        lastFit = nullptr;
+        if (cut != &candidate) {
+            // Check the current candidate against the new chunk.
+            --i;
+        }
+    }
+    if (totalDuration - chunkStart > budget && lastFit) {
+        cuts.push_back(lastFit);
+    }
+    if (cuts.empty()) {
+        return {};
+    }
+
+    std::vector<SegmentChunk> chunks;
+    chunks.reserve(cuts.size() + 1);
+    for (size_t i = 0; i <= cuts.size(); ++i) {
+        const CutPoint *head = i > 0 ? cuts[i - 1] : nullptr;
+        const CutPoint *tail = i < cuts.size() ? cuts[i] : nullptr;
+        const double start = head ? head->time - head->padding : 0.0;
+        const double end = tail ? tail->time + tail->padding : totalDuration;
+        chunks.push_back({makeChunk(dsSegment, wordStarts, head, tail, start, end), start});
+    }
+    return chunks;
+}
+
+DSONNXINFER_END_NAMESPACE
@@ -0,0 +1,37 @@
+#ifndef DS_ONNX_INFER_SEGMENTSPLITTER_P_H
+#define DS_ONNX_INFER_SEGMENTSPLITTER_P_H
+
+#include <cstdint>
+#include <vector>
+
+#include <dsonnxinfer/dsonnxinfer_global.h>
+#include <dsonnxinfer/DsProject.h>
+
+DSONNXINFER_BEGIN_NAMESPACE
+
+struct SegmentChunk {
+    Segment segment;
+    // Start of the chunk relative to the original segment, in seconds.
+    double start = 0.0;
+};
+
+/**
+ * @brief Splits a long segment into chunks of at most `maxChunkFrames` frames.
+ *
+ * Segments are only cut inside rest words (a single `SP` or `AP` phone, or only rest
+ * notes), at the frame nearest to the middle of the rest. Consecutive chunks overlap
+ * by `2 * padding` seconds of that rest (less if the rest is short), rounded down to
+ * whole frames, so that they can be crossfaded in silence and every chunk starts on a
+ * frame of the whole segment. Parameter curves and speaker mix curves are resampled to the time range
+ * of each chunk, and the offset of each chunk is its position in the song.
+ *
+ * A chunk may still exceed the budget if there is no rest to cut at.
+ *
+ * @return The chunks, or an empty list if the segment is not split.
+ */
+std::vector<SegmentChunk> splitSegmentAtRests(const Segment &dsSegment, double frameLength,
+                                              int64_t maxChunkFrames, double padding);
+
+DSONNXINFER_END_NAMESPACE
+
+#endif // DS_ONNX_INFER_SEGMENTSPLITTER_P_H
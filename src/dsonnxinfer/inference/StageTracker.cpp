@@ -0,0 +1,330 @@
+#include "StageTracker.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <string>
+#include <utility>
+
+#include "InputPlan_p.h"
+#include "../utils/Fnv1a_p.h"
+
+DSONNXINFER_BEGIN_NAMESPACE
+
+namespace {
+    // FNV-1a over the fields of a segment
+    class Hasher : public Fnv1a {
+    public:
+        void string(const std::string &s) {
+            bytes(s.data(), s.size() + 1);
+        }
+
+        void curve(const SampleCurve &curve) {
+            value(curve.timestep);
+            value(curve.samples.size());
+            bytes(curve.samples.data(), curve.samples.size() * sizeof(double));
+            value(curve.points.size());
+            bytes(curve.points.data(), curve.points.size() * sizeof(SampleCurve::Point));
+        }
+    };
+
+    void hashWords(Hasher &hasher, const Segment &segment, bool withStarts) {
+        hasher.value(segment.words.size());
+        for (const auto &word : segment.words) {
+            hasher.value(word.phones.size());
+            for (const auto &phone : word.phones) {
+                hasher.string(phone.token);
+                hasher.string(phone.language);
+                if (withStarts) {
+                    hasher.value(phone.start);
+                }
+            }
+            hasher.value(word.notes.size());
+            for (const auto &note : word.notes) {
+                hasher.value(note.key);
+                hasher.value(note.cents);
+                hasher.value(note.duration);
+                hasher.value(static_cast<int>(note.glide));
+                hasher.value(note.is_rest);
+            }
+        }
+    }
+
+    void hashSpeakers(Hasher &hasher, const Segment &segment) {
+        std::vector<const std::pair<const std::string, SampleCurve> *> speakers;
+        for (const auto &item : segment.speakers.spk) {
+            speakers.push_back(&item);
+        }
+        std::sort(speakers.begin(), speakers.end(), [](auto a, auto b) { return a->first < b->first; });
+        hasher.value(speakers.size());
+        for (const auto item : speakers) {
+            hasher.string(item->first);
+            hasher.curve(item->second);
+        }
+    }
+
+    // The curve of an input parameter; its retake range does not matter to the reader.
+    void hashInputParameter(Hasher &hasher, const Segment &segment, const std::string &name) {
+        hasher.string(name);
+        auto it = segment.parameters.find(name);
+        const bool present = it != segment.parameters.end();
+        hasher.value(present);
+        if (present) {
+            hasher.curve(it->second.sample_curve);
+        }
+    }
+
+    const Parameter *findParameter(const Segment &segment, const std::string &name) {
+        auto it = segment.parameters.find(name);
+        return it != segment.parameters.end() ? &it->second : nullptr;
+    }
+
+    uint64_t hashOwnParameter(const Parameter *param) {
+        Hasher hasher;
+        hasher.value(param != nullptr);
+        if (param) {
+            hasher.curve(param->sample_curve);
+            hasher.value(param->retake_start);
+            hasher.value(param->retake_end);
+        }
+        return hasher.result();
+    }
+
+    uint64_t hashPhoneStarts(const Segment &segment) {
+        Hasher hasher;
+        for (const auto &word : segment.words) {
+            for (const auto &phone : word.phones) {
+                hasher.value(phone.start);
+            }
+        }
+        return hasher.result();
+    }
+
+    // A field written by a stage: a parameter, or the phone starts if the name is empty.
+    struct OwnField {
+        std::string name;
+        uint64_t before = 0;
+        uint64_t after = 0;
+        Parameter saved;
+        std::vector<std::vector<double>> savedStarts;
+    };
+
+    struct StageState {
+        bool valid = false;
+        uint64_t inputs = 0;
+        std::vector<OwnField> fields;
+        // Fingerprints taken by prepare() for the run
+        uint64_t pendingInputs = 0;
+        std::vector<uint64_t> pendingBefore;
+    };
+}
+
+class StageTracker::Impl {
+public:
+    uint64_t hashInputs(VoicebankStage stage, const Segment &segment, uint64_t settings) const {
+        Hasher hasher;
+        hasher.value(settings);
+        hashWords(hasher, segment, stage != VS_Duration);
+        hashSpeakers(hasher, segment);
+        switch (stage) {
+            case VS_Pitch:
+                hashInputParameter(hasher, segment, "expr");
+                break;
+            case VS_Variance:
+                hashInputParameter(hasher, segment, "pitch");
+                hashInputParameter(hasher, segment, "tone_shift");
+                break;
+            case VS_Acoustic:
+                for (const auto &name : acousticParameters) {
+                    hashInputParameter(hasher, segment, name);
+                }
+                hasher.value(segment.offset);
+                break;
+            default:
+                break;
+        }
+        return hasher.result();
+    }
+
+    uint64_t hashField(const OwnField &field, const Segment &segment) const {
+        if (field.name.empty()) {
+            return hashPhoneStarts(segment);
+        }
+        return hashOwnParameter(findParameter(segment, field.name));
+    }
+
+    void save(OwnField &field, const Segment &segment) const {
+        if (field.name.empty()) {
+            field.savedStarts.clear();
+            for (const auto &word : segment.words) {
+                auto &starts = field.savedStarts.emplace_back();
+                for (const auto &phone : word.phones) {
+                    starts.push_back(phone.start);
+                }
+            }
+        } else if (auto param = findParameter(segment, field.name)) {
+            field.saved = *param;
+        }
+    }
+
+    bool restore(const OwnField &field, Segment &segment) const {
+        if (!field.name.empty()) {
+            segment.parameters[field.name] = field.saved;
+            return true;
+        }
+        if (field.savedStarts.size() != segment.words.size()) {
+            return false;
+        }
+        for (size_t i = 0; i < segment.words.size(); ++i) {
+            auto &phones = segment.words[i].phones;
+            if (field.savedStarts[i].size() != phones.size()) {
+                return false;
+            }
+            for (size_t j = 0; j < phones.size(); ++j) {
+                phones[j].start = field.savedStarts[i][j];
+            }
+        }
+        return true;
+    }
+
+    bool prepare(VoicebankStage stage, Segment &segment, uint64_t settings) {
+        if (stage == VS_Vocoder) {
+            // Runs as part of the acoustic stage.
+            return false;
+        }
+        auto &state = stages[stage];
+        const auto inputs = hashInputs(stage, segment, settings);
+        bool dirty = !state.valid || inputs != state.inputs || (stage == VS_Acoustic && waveform.empty());
+
+        for (size_t i = 0; i < state.fields.size() && !dirty; ++i) {
+            const auto &field = state.fields[i];
+            const auto hash = hashField(field, segment);
+            if (hash == field.after) {
+                continue;
+            }
+            const Parameter *param = field.name.empty() ? nullptr : findParameter(segment, field.name);
+            if (hash == field.before || (!field.name.empty() && !param)) {
+                // The segment does not have the outputs of the last run.
+                dirty = !restore(field, segment);
+            } else if (param && (param->retake_start != field.saved.retake_start ||
+                                 param->retake_end != field.saved.retake_end)) {
+                // A new retake range asks for a new prediction.
+                dirty = true;
+            }
+            // Otherwise the output was edited by hand and is kept.
+        }
+        if (!dirty) {
+            return false;
+        }
+
+        state.pendingInputs = inputs;
+        state.pendingBefore.clear();
+        for (const auto &field : state.fields) {
+            state.pendingBefore.push_back(hashField(field, segment));
+        }
+        if (state.fields.empty()) {
+            state.pendingBefore.assign(ownFields[stage].size(), 0);
+            for (size_t i = 0; i < ownFields[stage].size(); ++i) {
+                OwnField field;
+                field.name = ownFields[stage][i];
+                state.pendingBefore[i] = hashField(field, segment);
+            }
+        }
+        return true;
+    }
+
+    void commit(VoicebankStage stage, const Segment &segment) {
+        if (stage == VS_Vocoder) {
+            return;
+        }
+        auto &state = stages[stage];
+        state.fields.resize(ownFields[stage].size());
+        for (size_t i = 0; i < state.fields.size(); ++i) {
+            auto &field = state.fields[i];
+            field.name = ownFields[stage][i];
+            field.before = i < state.pendingBefore.size() ? state.pendingBefore[i] : 0;
+            field.after = hashField(field, segment);
+            save(field, segment);
+        }
+        state.inputs = state.pendingInputs;
+        state.valid = true;
+    }
+
+    // Parameters read by the acoustic stage
+    std::vector<std::string> acousticParameters;
+    // Fields written by each stage
+    std::array<std::vector<std::string>, VS_Acoustic + 1> ownFields;
+    std::array<StageState, VS_Acoustic + 1> stages;
+    AudioBuffer waveform;
+};
+
+StageTracker::StageTracker(const Voicebank &voicebank) : _impl(std::make_unique<Impl>()) {
+    auto &impl = *_impl;
+    // The acoustic model reads the pitch and the parameters of its input plan, and a pitch
+    // controllable vocoder applies the tone shift.
+    impl.acousticParameters = {parameterName(PK_Pitch)};
+    if (voicebank.vocoderConfig().features & kfPitchControllable) {
+        impl.acousticParameters.emplace_back(parameterName(PK_ToneShift));
+    }
+    for (const auto &slot : InputPlan::forAcoustic(voicebank.acousticConfig()).slots) {
+        if (slot.source == IS_Parameter) {
+            impl.acousticParameters.push_back(slot.name);
+        }
+    }
+    impl.ownFields[VS_Duration] = {""};
+    impl.ownFields[VS_Pitch] = {"pitch"};
+
+    if (voicebank.hasStage(VS_Variance)) {
+        const auto features = voicebank.varianceConfig().features;
+        auto &fields = impl.ownFields[VS_Variance];
+        if (features & kfParamEnergy) {
+            fields.emplace_back("energy");
+        }
+        if (features & kfParamBreathiness) {
+            fields.emplace_back("breathiness");
+        }
+        if (features & kfParamTension) {
+            fields.emplace_back("tension");
+        }
+        if (features & kfParamVoicing) {
+            fields.emplace_back("voicing");
+        }
+        if (features & kfParamMouthOpening) {
+            fields.emplace_back("mouth_opening");
+        }
+    }
+}
+
+StageTracker::~StageTracker() = default;
+
+StageTracker::StageTracker(StageTracker &&other) noexcept = default;
+
+StageTracker &StageTracker::operator=(StageTracker &&other) noexcept = default;
+
+bool StageTracker::prepare(VoicebankStage stage, Segment &segment, uint64_t settings) {
+    auto &impl = *_impl;
+    return impl.prepare(stage, segment, settings);
+}
+
+void StageTracker::commit(VoicebankStage stage, const Segment &segment) {
+    auto &impl = *_impl;
+    impl.commit(stage, segment);
+}
+
+const AudioBuffer &StageTracker::waveform() const {
+    auto &impl = *_impl;
+    return impl.waveform;
+}
+
+void StageTracker::setWaveform(AudioBuffer waveform) {
+    auto &impl = *_impl;
+    impl.waveform = std::move(waveform);
+}
+
+void StageTracker::reset() {
+    auto &impl = *_impl;
+    impl.stages = {};
+    impl.waveform = {};
+}
+
+DSONNXINFER_END_NAMESPACE
@@ -0,0 +1,79 @@
+#ifndef DS_ONNX_INFER_STAGETRACKER_H
+#define DS_ONNX_INFER_STAGETRACKER_H
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <dsonnxinfer/dsonnxinfer_global.h>
+#include <dsonnxinfer/AudioBuffer.h>
+#include <dsonnxinfer/DsProject.h>
+#include <dsonnxinfer/Voicebank.h>
+
+DSONNXINFER_BEGIN_NAMESPACE
+
+/**
+ * @brief Tracks which pipeline stages an edit of a segment affects.
+ *
+ * Each stage reads some fields of a segment and writes others:
+ *
+ *     stage      reads                                          writes
+ *     duration   phones, notes, speakers                        phone starts
+ *     pitch      phones and starts, notes, speakers, expr       pitch
+ *     variance   phones and starts, notes, speakers, pitch,     its predicted parameters
+ *                tone_shift
+ *     acoustic   phones and starts, notes, speakers, pitch,     (the waveform)
+ *                the parameters of its input plan, tone_shift
+ *                (for a pitch controllable vocoder), offset
+ *
+ * The tracker keeps fingerprints of what each stage read and wrote on its last run, so a
+ * stage only has to run again if its inputs changed. Edits of a stage's own outputs are
+ * kept, unless the retake range of a parameter changed, which requests a new prediction.
+ * If a segment comes without the outputs of a stage that does not need to run (e.g. it
+ * is rebuilt from the editor's model on each edit), the outputs of the last run are
+ * written back.
+ *
+ * Use one tracker per segment, and query the stages in Voicebank::stageOrder().
+ */
+class DSONNXINFER_EXPORT StageTracker {
+public:
+    explicit StageTracker(const Voicebank &voicebank);
+    ~StageTracker();
+
+    StageTracker(StageTracker &&other) noexcept;
+    StageTracker &operator=(StageTracker &&other) noexcept;
+
+    /**
+     * @brief Whether the stage has to run on the segment. If not, the outputs of its
+     *        last run are restored into the segment where needed.
+     *
+     * @param settings Fingerprint of the settings of the stage's inference object that
+     *                 change its outputs, such as its steps and depth; the stage runs
+     *                 again when it changes.
+     */
+    bool prepare(VoicebankStage stage, Segment &segment, uint64_t settings = 0);
+
+    /**
+     * @brief Records the segment after the stage ran, following prepare().
+     */
+    void commit(VoicebankStage stage, const Segment &segment);
+
+    /**
+     * @brief The waveform of the last acoustic run.
+     */
+    const AudioBuffer &waveform() const;
+    void setWaveform(AudioBuffer waveform);
+
+    /**
+     * @brief Forgets all runs, so that every stage runs again.
+     */
+    void reset();
+
+protected:
+    class Impl;
+    std::unique_ptr<Impl> _impl;
+};
+
+DSONNXINFER_END_NAMESPACE
+
+#endif // DS_ONNX_INFER_STAGETRACKER_H
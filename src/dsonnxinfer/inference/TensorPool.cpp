@@ -0,0 +1,146 @@
+#include "TensorPool_p.h"
+
+#include <algorithm>
+#include <utility>
+
+DSONNXINFER_BEGIN_NAMESPACE
+
+static thread_local TensorPool *t_currentPool = nullptr;
+
+// Smallest bucket whose buffers can hold `bytes`
+static size_t bucketForSize(size_t bytes) {
+    size_t bucket = 0;
+    while ((size_t{1} << bucket) < bytes) {
+        ++bucket;
+    }
+    return bucket;
+}
+
+// Bucket of a buffer with the given capacity
+static size_t bucketForCapacity(size_t capacity) {
+    size_t bucket = 0;
+    while ((size_t{2} << bucket) <= capacity) {
+        ++bucket;
+    }
+    return bucket;
+}
+
+TensorPool::TensorPool(size_t maxPooledBytes) : m_maxPooledBytes(maxPooledBytes) {
+}
+
+TensorPool::~TensorPool() = default;
+
+TensorPool::Buffer TensorPool::acquire(size_t bytes) {
+    const size_t bucket = bucketForSize(bytes);
+    Buffer buffer;
+    if (bucket < BucketCount) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto &buffers = m_buckets[bucket];
+        if (!buffers.empty()) {
+            buffer = std::move(buffers.back());
+            buffers.pop_back();
+            m_pooledBytes -= buffer.capacity();
+            ++m_hits;
+        } else {
+            ++m_misses;
+        }
+    }
+    if (buffer.capacity() == 0 && bucket < BucketCount) {
+        // Round up, so that the buffer can be reused for any size of its bucket.
+        buffer.reserve(size_t{1} << bucket);
+    }
+    buffer.resize(bytes);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    // A buffer handed out earlier at the same address has been freed without returning.
+    auto &outstanding = m_outstanding[buffer.data()];
+    m_outstandingBytes += buffer.capacity() - outstanding;
+    outstanding = buffer.capacity();
+    m_peakBytes = (std::max)(m_peakBytes, m_pooledBytes + m_outstandingBytes);
+    return buffer;
+}
+
+void TensorPool::release(Buffer &&buffer) {
+    const size_t capacity = buffer.capacity();
+    if (capacity == 0) {
+        return;
+    }
+    const size_t bucket = bucketForCapacity(capacity);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    untrack(buffer.data());
+    if (bucket >= BucketCount || m_pooledBytes + capacity > m_maxPooledBytes) {
+        return;
+    }
+    buffer.clear();
+    m_buckets[bucket].push_back(std::move(buffer));
+    m_pooledBytes += capacity;
+    m_peakBytes = (std::max)(m_peakBytes, m_pooledBytes + m_outstandingBytes);
+}
+
+void TensorPool::disown(const Buffer &buffer) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    untrack(buffer.data());
+}
+
+void TensorPool::untrack(const void *data) {
+    if (auto it = m_outstanding.find(data); it != m_outstanding.end()) {
+        m_outstandingBytes -= it->second;
+        m_outstanding.erase(it);
+    }
+}
+
+void TensorPool::recycle(flowonnx::TensorMap &tensors) {
+    for (auto &item : tensors) {
+        release(std::move(item.second.data));
+    }
+    tensors.clear();
+}
+
+void TensorPool::recycle(std::vector<flowonnx::InferenceData> &dataList) {
+    for (auto &data : dataList) {
+        recycle(data.inputData);
+    }
+}
+
+TensorPoolStats TensorPool::stats() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    TensorPoolStats result;
+    result.hits = m_hits;
+    result.misses = m_misses;
+    result.pooledBytes = m_pooledBytes;
+    result.peakBytes = m_peakBytes;
+    return result;
+}
+
+void TensorPool::clear() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto &buffers : m_buckets) {
+        buffers.clear();
+        buffers.shrink_to_fit();
+    }
+    m_pooledBytes = 0;
+}
+
+TensorPool *TensorPool::current() {
+    return t_currentPool;
+}
+
+TensorPool::Scope::Scope(TensorPool *pool) : m_previous(t_currentPool) {
+    t_currentPool = pool;
+}
+
+TensorPool::Scope::~Scope() {
+    t_currentPool = m_previous;
+}
+
+TensorPool::Buffer acquireTensorBuffer(size_t bytes) {
+    if (auto pool = TensorPool::current()) {
+        return pool->acquire(bytes);
+    }
+    TensorPool::Buffer buffer;
+    buffer.resize(bytes);
+    return buffer;
+}
+
+DSONNXINFER_END_NAMESPACE
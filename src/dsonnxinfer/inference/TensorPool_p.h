@@ -0,0 +1,102 @@
+#ifndef DS_ONNX_INFER_TENSORPOOL_P_H
+#define DS_ONNX_INFER_TENSORPOOL_P_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include <dsonnxinfer/dsonnxinfer_global.h>
+#include <dsonnxinfer/IInference.h>
+#include <flowonnx/inference.h>
+
+DSONNXINFER_BEGIN_NAMESPACE
+
+/**
+ * @brief Size-bucketed pool of tensor data buffers.
+ *
+ * Buffers are kept in power-of-two capacity buckets, so a buffer released by one run
+ * is reused by the next run for any tensor of up to its capacity. Every inference
+ * object owns a pool; while a Scope is alive, the preprocessing on that thread draws
+ * its tensors from the pool, and the inputs are returned after the run.
+ *
+ * At most `maxPooledBytes` are kept idle; buffers released beyond that are freed.
+ * Buffers allocated elsewhere, such as the outputs of the runtime, may be released to
+ * the pool too, but only the buffers it handed out count as outstanding. A buffer that
+ * leaves the library, such as a waveform returned to the caller, has to be disowned,
+ * so that it is no longer tracked.
+ */
+class TensorPool {
+public:
+    using Buffer = decltype(flowonnx::Tensor::data);
+
+    explicit TensorPool(size_t maxPooledBytes = size_t{256} << 20);
+    ~TensorPool();
+
+    DSONNXINFER_DISABLE_COPY_MOVE(TensorPool)
+
+    /**
+     * @brief Returns a buffer of `bytes` zeroed bytes.
+     */
+    Buffer acquire(size_t bytes);
+    void release(Buffer &&buffer);
+
+    /**
+     * @brief Stops counting a buffer handed out by acquire() as outstanding, because it
+     *        will never be released.
+     */
+    void disown(const Buffer &buffer);
+
+    /**
+     * @brief Returns the data of all tensors to the pool and clears them.
+     */
+    void recycle(flowonnx::TensorMap &tensors);
+    void recycle(std::vector<flowonnx::InferenceData> &dataList);
+
+    TensorPoolStats stats() const;
+    void clear();
+
+    /**
+     * @brief The pool of the Scope alive on the calling thread, or nullptr.
+     */
+    static TensorPool *current();
+
+    class Scope {
+    public:
+        explicit Scope(TensorPool *pool);
+        ~Scope();
+
+        DSONNXINFER_DISABLE_COPY_MOVE(Scope)
+
+    private:
+        TensorPool *m_previous;
+    };
+
+private:
+    static constexpr size_t BucketCount = 48;
+
+    // Called with the lock held
+    void untrack(const void *data);
+
+    mutable std::mutex m_mutex;
+    std::array<std::vector<Buffer>, BucketCount> m_buckets;
+    size_t m_maxPooledBytes;
+    size_t m_pooledBytes = 0;
+    // Capacity of the buffers handed out and not returned yet, by their data
+    std::unordered_map<const void *, size_t> m_outstanding;
+    size_t m_outstandingBytes = 0;
+    size_t m_peakBytes = 0;
+    uint64_t m_hits = 0;
+    uint64_t m_misses = 0;
+};
+
+/**
+ * @brief Allocates tensor data from the current pool, if any.
+ */
+TensorPool::Buffer acquireTensorBuffer(size_t bytes);
+
+DSONNXINFER_END_NAMESPACE
+
+#endif // DS_ONNX_INFER_TENSORPOOL_P_H
@@ -1,6 +1,7 @@
 
 #include "VarianceInference.h"
 
+#include <chrono>
 #include <fstream>
 #include <utility>
 #include <cstring>
@@ -10,6 +11,16 @@
 
 #include <flowonnx/inference.h>
 #include "InferenceCommon_p.h"
+#include "CompactSegment_p.h"
+#include "PhonemeDict_p.h"
+#include "TensorPool_p.h"
+#include "RunLimiter_p.h"
+#include "ModelVariant_p.h"
+#include "LinguisticEncoder_p.h"
+#include "DiffusionScheduler_p.h"
+#include "InputPlan_p.h"
+#include "../core/Placement_p.h"
+#include "../core/CurveKernels_p.h"
 #include <dsonnxinfer/Environment.h>
 
 DSONNXINFER_BEGIN_NAMESPACE
@@ -22,80 +33,126 @@ public:
             depth(Environment::instance()->defaultDepth()) {}
 
     Status open() {
-        if (dsVarianceConfig.features & kfMultiLanguage) {
-            readLangIdFile(dsVarianceConfig.languages, languages);
-        }
-        if (isFileExtJson(dsVarianceConfig.phonemes)) {
-            readMultiLangPhonemesFile(dsVarianceConfig.phonemes, name2token);
-        } else {
-            readPhonemesFile(dsVarianceConfig.phonemes, name2token);
+        std::string errorMessage;
+        phonemeDict = PhonemeDict::load(dsVarianceConfig.phonemes, dsVarianceConfig.languages,
+                                        dsVarianceConfig.features & kfMultiLanguage, &errorMessage);
+        if (!phonemeDict) {
+            return {Status_ModelLoadError, errorMessage};
         }
 
-        if (dsVarianceConfig.features & kfParamEnergy) {
-            expectParamNames.emplace_back("energy_pred");
-        }
-        if (dsVarianceConfig.features & kfParamBreathiness) {
-            expectParamNames.emplace_back("breathiness_pred");
+        inputPlan = InputPlan::forVariance(dsVarianceConfig);
+        if (inputPlan.predictedCount == 0) {
+            return {Status_ModelLoadError,
+                    "According to the variance model config, it does not predict any parameters. Please check the config!"};
         }
-        if (dsVarianceConfig.features & kfParamTension) {
-            expectParamNames.emplace_back("tension_pred");
+        const auto linguistic = selectModelVariant(dsVarianceConfig.linguistic, dsVarianceConfig.linguisticVariants, options);
+        const auto variance = selectModelVariant(dsVarianceConfig.variance, dsVarianceConfig.varianceVariants, options);
+        if (auto s = inputPlan.validate(dsVarianceConfig.variance, variance, "variance"); !s.isOk()) {
+            return s;
         }
-        if (dsVarianceConfig.features & kfParamVoicing) {
-            expectParamNames.emplace_back("voicing_pred");
-        }
-        if (dsVarianceConfig.features & kfParamMouthOpening) {
-            expectParamNames.emplace_back("mouth_opening_pred");
+        for (const auto &slot : inputPlan.slots) {
+            if (slot.source == IS_PredictedParameter) {
+                expectParamNames.push_back(slot.name + "_pred");
+            }
         }
 
-        std::string errorMessage;
-        if (!inferenceHandle.open({{dsVarianceConfig.linguistic, false}, {dsVarianceConfig.variance, false}}, &errorMessage)) {
-            return {Status_ModelLoadError, errorMessage};
+        // The session threads inherit the placement of this thread.
+        Placement::Scope placement(options.numaNode);
+        ModelList reference = {{dsVarianceConfig.variance, false}};
+        ModelList selected = {{variance, false}};
+        if (options.shareLinguisticEncoder) {
+            const double frameLength = 1.0 * dsVarianceConfig.hopSize / dsVarianceConfig.sampleRate;
+            const bool predictDur = dsVarianceConfig.features & kfLinguisticPredictDur;
+            Status s;
+            encoder = LinguisticEncoder::open(phonemeDict, dsVarianceConfig.linguistic, linguistic,
+                                              predictDur, frameLength, options, &s);
+            if (!encoder) {
+                return s;
+            }
+        } else {
+            reference.insert(reference.begin(), {dsVarianceConfig.linguistic, false});
+            selected.insert(selected.begin(), {linguistic, false});
         }
-
-        return {Status_Ok, ""};
+        const auto result = openModelVariants(inferenceHandle, reference, selected, options, [this](Status *status) {
+            return infer(*options.precisionProbe, status);
+        });
+        // The probe runs are not representative of the runtime.
+        scheduler.reset();
+        return result;
     }
 
     void close() {
         inferenceHandle.close();
+        encoder.reset();
         dsVarianceConfig = {};
         expectParamNames.clear();
-        name2token.clear();
-        languages.clear();
+        inputPlan = {};
+        phonemeDict.reset();
+        tensorPool.clear();
+        scheduler.reset();
     }
 
     InferMap infer(const Segment &dsSegment, Status *status) {
+        const auto start = std::chrono::steady_clock::now();
+        TensorPool::Scope poolScope(&tensorPool);
+        Placement::Scope placement(options.numaNode);
+
         int sampleRate = dsVarianceConfig.sampleRate;
         int hopSize = dsVarianceConfig.hopSize;
         double frameLength = 1.0 * hopSize / sampleRate;
         bool predictDur = dsVarianceConfig.features & kfLinguisticPredictDur;
 
-        auto linguisticInputData = linguisticPreprocess(name2token, languages, dsSegment, frameLength, predictDur);
-        auto varianceInputData = variancePreprocess(dsSegment, dsVarianceConfig, frameLength, predictDur);
+        const CompactSegment segment(dsSegment, phonemeDict.get());
+        auto varianceInputData = variancePreprocess(segment, inputPlan, frameLength, status);
+        if (varianceInputData.empty()) {
+            return {};
+        }
 
         const int64_t shapeArr = 1;
 
+        // The depth is not an input of this model.
+        auto plan = scheduler.plan(varianceInputData["pitch"].shape.back(), DiffusionScheduler::remaining(deadline, start),
+                                   steps, depth, dsVarianceConfig.features & kfContinuousAcceleration, false);
         if (dsVarianceConfig.features & kfContinuousAcceleration) {
-            varianceInputData["steps"] = flowonnx::Tensor::create(&steps, 1, &shapeArr, 1);
+            varianceInputData["steps"] = flowonnx::Tensor::create(&plan.info.steps, 1, &shapeArr, 1);
         } else {
-            int64_t speedup = getSpeedupFromSteps(steps);
+            int64_t speedup = getSpeedupFromSteps(plan.info.steps);
             varianceInputData["speedup"] = flowonnx::Tensor::create(&speedup, 1, &shapeArr, 1);
         }
 
-        flowonnx::InferenceData dataLinguistic, dataVariance;
-
-        dataLinguistic.inputData = std::move(linguisticInputData);
-        dataLinguistic.bindings.push_back({1, "encoder_out", "encoder_out", false});
-        if (!predictDur) {
-            dataLinguistic.bindings.push_back({1, "ph_dur", "ph_dur", true});
+        std::vector<flowonnx::InferenceData> dataList;
+        dataList.reserve(2);
+        if (encoder) {
+            // The encoder outputs become inputs of the variance model.
+            if (!encoder->encode(segment, varianceInputData, status)) {
+                tensorPool.recycle(varianceInputData);
+                return {};
+            }
+        } else {
+            flowonnx::InferenceData dataLinguistic;
+            dataLinguistic.inputData = linguisticPreprocess(segment, frameLength, predictDur);
+            dataLinguistic.bindings.push_back({1, "encoder_out", "encoder_out", false});
+            if (!predictDur) {
+                dataLinguistic.bindings.push_back({1, "ph_dur", "ph_dur", true});
+            }
+            dataLinguistic.outputNames.emplace_back("x_masks");
+            dataList.push_back(std::move(dataLinguistic));
         }
-        dataLinguistic.outputNames.emplace_back("x_masks");
+
+        flowonnx::InferenceData dataVariance;
         dataVariance.inputData = std::move(varianceInputData);
         dataVariance.outputNames = expectParamNames;
-
-        std::vector dataList{dataLinguistic, dataVariance};
+        dataList.push_back(std::move(dataVariance));
 
         std::string errorMessage;
-        auto result = inferenceHandle.run(dataList, &errorMessage);
+        flowonnx::TensorMap result;
+        {
+            RunLimiter::Slot runSlot(options.limitConcurrentRuns);
+            result = inferenceHandle.run(dataList, &errorMessage);
+        }
+        tensorPool.recycle(dataList);
+
+        scheduler.finish(std::move(plan), !result.empty());
 
         if (status) {
             if (result.empty()) {
@@ -114,12 +171,18 @@ public:
     }
 
     DsVarianceConfig dsVarianceConfig;
-    std::unordered_map<std::string, int64_t> name2token;
-    std::unordered_map<std::string, int64_t> languages;
+    std::shared_ptr<const PhonemeDict> phonemeDict;
+    TensorPool tensorPool;
+    InferenceOptions options;
+    InputPlan inputPlan;
     std::vector<std::string> expectParamNames;
     flowonnx::Inference inferenceHandle;
+    // The shared linguistic encoder, if enabled; otherwise the encoder is part of inferenceHandle.
+    std::shared_ptr<LinguisticEncoder> encoder;
+    DiffusionScheduler scheduler;
     float depth;
     int64_t steps;
+    double deadline = 0.0;
 };
 
 VarianceInference::VarianceInference(DsVarianceConfig &&dsVarianceConfig)
@@ -140,6 +203,7 @@ VarianceInference::VarianceInference(const DsVarianceConfig &dsVarianceConfig)
 
 Status VarianceInference::open() {
     auto &impl = *_impl;
+    impl.options = m_options;
     return impl.open();
 }
 
@@ -158,6 +222,21 @@ void VarianceInference::setSteps(int64_t steps) {
     impl.steps = steps;
 }
 
+void VarianceInference::setDeadline(double seconds) {
+    auto &impl = *_impl;
+    impl.deadline = seconds;
+}
+
+double VarianceInference::deadline() const {
+    auto &impl = *_impl;
+    return impl.deadline;
+}
+
+DiffusionRunInfo VarianceInference::lastRunInfo() const {
+    auto &impl = *_impl;
+    return impl.scheduler.lastRun();
+}
+
 float VarianceInference::depth() const {
     auto &impl = *_impl;
     return impl.depth;
@@ -189,17 +268,24 @@ bool VarianceInference::runInPlace(Segment &dsSegment, Status *status) {
 
             // Copy predicted pitch data to original segment pitch parameter (overwrite existing)
             auto &currentParam = dsSegment.parameters[inParam];
+            currentParam.sample_curve.points.clear();
             currentParam.sample_curve.samples.resize(bufferSize);
-            std::copy(buffer, buffer + bufferSize, currentParam.sample_curve.samples.begin());
+            CurveKernels::toDouble(buffer, bufferSize, currentParam.sample_curve.samples.data());
             currentParam.retake_start = 0;
             currentParam.retake_end = bufferSize;
             currentParam.sample_curve.timestep = frameLength;
             currentParam.tag = inParam;
         }
     }
+    impl.tensorPool.recycle(result);
     return true;
 }
 
+TensorPoolStats VarianceInference::tensorPoolStats() const {
+    auto &impl = *_impl;
+    return impl.tensorPool.stats();
+}
+
 bool VarianceInference::terminate() {
     auto &impl = *_impl;
     return impl.terminate();
@@ -0,0 +1,173 @@
+#include "VocoderCommon_p.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "RunLimiter_p.h"
+#include "TensorPool_p.h"
+#include <dsonnxinfer/TaskPool.h>
+
+DSONNXINFER_BEGIN_NAMESPACE
+
+InferMap runVocoder(flowonnx::Inference &handle, flowonnx::Tensor &&mel, flowonnx::Tensor &&f0,
+                    const InferenceOptions &options, TensorPool &tensorPool, Status *status) {
+    flowonnx::InferenceData dataVocoder;
+    dataVocoder.inputData["mel"] = std::move(mel);
+    dataVocoder.inputData["f0"] = std::move(f0);
+    dataVocoder.outputNames.emplace_back("waveform");
+
+    std::vector<flowonnx::InferenceData> dataList;
+    dataList.push_back(std::move(dataVocoder));
+
+    std::string errorMessage;
+    flowonnx::TensorMap result;
+    {
+        RunLimiter::Slot runSlot(options.limitConcurrentRuns);
+        result = handle.run(dataList, &errorMessage);
+    }
+    tensorPool.recycle(dataList);
+
+    if (result.empty()) {
+        putStatus(status, Status_InferError, std::move(errorMessage));
+        return {};
+    }
+    putStatusOk(status);
+    return result;
+}
+
+std::vector<VocoderChunk> planVocoderChunks(int64_t frameCount, int64_t chunkFrames, int64_t overlapFrames) {
+    if (chunkFrames <= 0 || frameCount <= chunkFrames) {
+        return {{0, frameCount}};
+    }
+    // At most half a chunk, so that only neighbouring chunks overlap.
+    overlapFrames = (std::clamp)(overlapFrames, int64_t{0}, chunkFrames / 2);
+    const int64_t step = chunkFrames - overlapFrames;
+    std::vector<VocoderChunk> chunks;
+    for (int64_t begin = 0;; begin += step) {
+        const int64_t end = (std::min)(begin + chunkFrames, frameCount);
+        chunks.push_back({begin, end});
+        if (end == frameCount) {
+            break;
+        }
+    }
+    return chunks;
+}
+
+void overlapAddChunks(const std::vector<VocoderChunk> &chunks, const std::vector<const float *> &waveforms,
+                      int64_t hopSize, float *out) {
+    constexpr double halfPi = 1.57079632679489661923;
+    for (size_t i = 0; i < chunks.size(); ++i) {
+        const auto &chunk = chunks[i];
+        const float *src = waveforms[i];
+        // Overlaps with the previous and the next chunk, in samples
+        const int64_t fadeIn = i > 0 ? (chunks[i - 1].end - chunk.begin) * hopSize : 0;
+        const int64_t fadeOut = i + 1 < chunks.size() ? (chunk.end - chunks[i + 1].begin) * hopSize : 0;
+        const int64_t length = (chunk.end - chunk.begin) * hopSize;
+        float *dst = out + chunk.begin * hopSize;
+
+        // The previous chunk wrote the faded-out part of the overlap; the fade-in adds to it.
+        for (int64_t t = 0; t < fadeIn; ++t) {
+            const double w = std::sin(halfPi * (static_cast<double>(t) + 0.5) / static_cast<double>(fadeIn));
+            dst[t] += static_cast<float>(w * w) * src[t];
+        }
+        std::copy(src + fadeIn, src + length - fadeOut, dst + fadeIn);
+        for (int64_t t = length - fadeOut; t < length; ++t) {
+            const double w = std::cos(halfPi * (static_cast<double>(t - (length - fadeOut)) + 0.5) /
+                                      static_cast<double>(fadeOut));
+            dst[t] = static_cast<float>(w * w) * src[t];
+        }
+    }
+}
+
+// Frames [begin, end) of a {1, N, ...} tensor
+static flowonnx::Tensor sliceFrames(const flowonnx::Tensor &tensor, int64_t begin, int64_t end) {
+    const size_t frameBytes = tensor.data.size() / static_cast<size_t>(tensor.shape[1]);
+    flowonnx::Tensor slice;
+    slice.data = acquireTensorBuffer((end - begin) * frameBytes);
+    std::copy(tensor.data.begin() + begin * frameBytes, tensor.data.begin() + end * frameBytes, slice.data.begin());
+    slice.shape = tensor.shape;
+    slice.shape[1] = end - begin;
+    slice.type = tensor.type;
+    return slice;
+}
+
+InferMap runVocoderChunked(const std::vector<flowonnx::Inference *> &handles, flowonnx::Tensor &&mel,
+                           flowonnx::Tensor &&f0, int64_t hopSize, int64_t chunkFrames, int64_t overlapFrames,
+                           const InferenceOptions &options, TensorPool &tensorPool, Status *status) {
+    const int64_t frameCount = mel.shape.size() >= 2 ? mel.shape[1] : 0;
+    const auto chunks = planVocoderChunks(frameCount, chunkFrames, overlapFrames);
+    if (chunks.size() <= 1) {
+        return runVocoder(*handles.front(), std::move(mel), std::move(f0), options, tensorPool, status);
+    }
+
+    // A session runs one chunk at a time, so each task takes one session and vocodes the
+    // next chunk until none are left.
+    std::vector<flowonnx::Tensor> waveforms(chunks.size());
+    std::vector<const float *> buffers(chunks.size(), nullptr);
+    std::vector<Status> chunkStatus(chunks.size());
+    std::atomic<size_t> nextChunk{0};
+    std::atomic<bool> failed{false};
+    TaskPool::global().parallelFor((std::min)(handles.size(), chunks.size()), [&](size_t h) {
+        TensorPool::Scope poolScope(&tensorPool);
+        for (;;) {
+            const size_t i = nextChunk++;
+            if (failed || i >= chunks.size()) {
+                return;
+            }
+            auto result = runVocoder(*handles[h], sliceFrames(mel, chunks[i].begin, chunks[i].end),
+                                     sliceFrames(f0, chunks[i].begin, chunks[i].end), options, tensorPool,
+                                     &chunkStatus[i]);
+            auto it = result.find("waveform");
+            if (it == result.end()) {
+                if (!result.empty()) {
+                    tensorPool.recycle(result);
+                    putStatus(&chunkStatus[i], Status_InferError, "Missing waveform output");
+                }
+                failed = true;
+                return;
+            }
+            waveforms[i] = std::move(it->second);
+            const auto sampleCount = static_cast<int64_t>(waveforms[i].getDataBuffer<float>(&buffers[i]));
+            if (sampleCount < (chunks[i].end - chunks[i].begin) * hopSize) {
+                putStatus(&chunkStatus[i], Status_InferError, "Unexpected waveform size");
+                failed = true;
+                return;
+            }
+        }
+    });
+
+    const auto releaseAll = [&] {
+        tensorPool.release(std::move(mel.data));
+        tensorPool.release(std::move(f0.data));
+        for (auto &chunkWaveform : waveforms) {
+            tensorPool.release(std::move(chunkWaveform.data));
+        }
+    };
+    if (failed) {
+        const auto it = std::find_if(chunkStatus.begin(), chunkStatus.end(),
+                                     [](const Status &s) { return !s.isOk(); });
+        putStatus(status, it->code, std::move(it->msg));
+        releaseAll();
+        return {};
+    }
+
+    flowonnx::Tensor waveform;
+    waveform.data = acquireTensorBuffer(frameCount * hopSize * sizeof(float));
+    waveform.shape = {1, frameCount * hopSize};
+    waveform.type = flowonnx::Tensor::Float;
+    float *out;
+    waveform.getDataBuffer<float>(&out);
+    overlapAddChunks(chunks, buffers, hopSize, out);
+    releaseAll();
+
+    InferMap result;
+    result["waveform"] = std::move(waveform);
+    putStatusOk(status);
+    return result;
+}
+
+DSONNXINFER_END_NAMESPACE
@@ -0,0 +1,60 @@
+#ifndef DS_ONNX_INFER_VOCODERCOMMON_P_H
+#define DS_ONNX_INFER_VOCODERCOMMON_P_H
+
+#include <cstdint>
+#include <vector>
+
+#include <dsonnxinfer/dsonnxinfer_global.h>
+#include <dsonnxinfer/IInference.h>
+#include <flowonnx/inference.h>
+
+#include "InferenceCommon_p.h"
+
+DSONNXINFER_BEGIN_NAMESPACE
+
+class TensorPool;
+
+/**
+ * @brief Runs a vocoder session on a mel spectrogram {1, N, bins} and f0 {1, N} in Hz.
+ *        The input buffers are returned to the pool afterwards.
+ *
+ * @return The output map with the "waveform" tensor, or an empty map on failure.
+ */
+InferMap runVocoder(flowonnx::Inference &handle, flowonnx::Tensor &&mel, flowonnx::Tensor &&f0,
+                    const InferenceOptions &options, TensorPool &tensorPool, Status *status);
+
+// Frame range [begin, end) of a mel spectrogram vocoded in one piece
+struct VocoderChunk {
+    int64_t begin;
+    int64_t end;
+};
+
+/**
+ * @brief Splits `frameCount` frames into chunks of at most `chunkFrames` frames, where
+ *        consecutive chunks share `overlapFrames` frames. 0 chunk frames means one chunk.
+ */
+std::vector<VocoderChunk> planVocoderChunks(int64_t frameCount, int64_t chunkFrames, int64_t overlapFrames);
+
+/**
+ * @brief Reassembles the waveforms of the chunks into `out` (`frameCount * hopSize` samples),
+ *        crossfading overlapping chunks with complementary sine-squared windows.
+ */
+void overlapAddChunks(const std::vector<VocoderChunk> &chunks, const std::vector<const float *> &waveforms,
+                      int64_t hopSize, float *out);
+
+/**
+ * @brief Like runVocoder(), but splits the mel spectrogram and f0 along time into chunks
+ *        of `chunkFrames` frames sharing `overlapFrames` frames, vocodes the chunks on the
+ *        task pool and reassembles them with overlapAddChunks().
+ *
+ * @param handles Sessions of the same vocoder, each running one chunk at a time; as many
+ *        chunks are vocoded at the same time as there are sessions.
+ * @param hopSize Samples per frame of the vocoder.
+ */
+InferMap runVocoderChunked(const std::vector<flowonnx::Inference *> &handles, flowonnx::Tensor &&mel,
+                           flowonnx::Tensor &&f0, int64_t hopSize, int64_t chunkFrames, int64_t overlapFrames,
+                           const InferenceOptions &options, TensorPool &tensorPool, Status *status);
+
+DSONNXINFER_END_NAMESPACE
+
+#endif // DS_ONNX_INFER_VOCODERCOMMON_P_H
@@ -0,0 +1,298 @@
+#include "VocoderInference.h"
+
+#include <algorithm>
+#include <string>
+#include <utility>
+
+#include <flowonnx/inference.h>
+#include "InferenceCommon_p.h"
+#include "TensorPool_p.h"
+#include "ModelVariant_p.h"
+#include "VocoderCommon_p.h"
+#include "../core/Placement_p.h"
+
+DSONNXINFER_BEGIN_NAMESPACE
+
+class VocoderInference::Impl {
+public:
+    explicit Impl(bool preferCpu_) :
+            inferenceHandle("ds_vocoder"),
+            preferCpu(preferCpu_) {}
+
+    Status open() {
+        // The probe is a segment, which a vocoder alone cannot run.
+        auto vocoderOptions = options;
+        vocoderOptions.precisionProbe.reset();
+
+        // The session threads inherit the placement of this thread.
+        Placement::Scope placement(options.numaNode);
+        return openModelVariants(
+            inferenceHandle, {{dsVocoderConfig.model, preferCpu}},
+            {{selectModelVariant(dsVocoderConfig.model, dsVocoderConfig.modelVariants, options), preferCpu}},
+            vocoderOptions, {});
+    }
+
+    void close() {
+        inferenceHandle.close();
+        dsVocoderConfig = {};
+        tensorPool.clear();
+    }
+
+    // Frame range of one of the mel spectrograms, vocoded as a row of a batch
+    struct WorkItem {
+        size_t input;
+        size_t chunk;
+        VocoderChunk range;
+    };
+
+    /**
+     * @brief Vocodes the items in one run. Rows shorter than the longest are padded by
+     *        repeating their last frame.
+     * @return The waveform tensor {B, T * hopSize}, or nullptr on failure.
+     */
+    std::shared_ptr<flowonnx::Tensor> runBatch(const std::vector<MelSpectrogram> &mels,
+                                               const WorkItem *items, size_t itemCount, Status *status) {
+        const int64_t numMelBins = dsVocoderConfig.numMelBins;
+        const auto batchSize = static_cast<int64_t>(itemCount);
+        int64_t frameCount = 0;
+        for (size_t i = 0; i < itemCount; ++i) {
+            frameCount = (std::max)(frameCount, items[i].range.end - items[i].range.begin);
+        }
+
+        flowonnx::Tensor melTensor;
+        melTensor.data = acquireTensorBuffer(batchSize * frameCount * numMelBins * sizeof(float));
+        melTensor.shape = {batchSize, frameCount, numMelBins};
+        melTensor.type = flowonnx::Tensor::Float;
+        float *melBuffer;
+        melTensor.getDataBuffer<float>(&melBuffer);
+
+        flowonnx::Tensor f0Tensor;
+        f0Tensor.data = acquireTensorBuffer(batchSize * frameCount * sizeof(float));
+        f0Tensor.shape = {batchSize, frameCount};
+        f0Tensor.type = flowonnx::Tensor::Float;
+        float *f0Buffer;
+        f0Tensor.getDataBuffer<float>(&f0Buffer);
+
+        for (size_t i = 0; i < itemCount; ++i) {
+            const auto &input = mels[items[i].input];
+            const auto &range = items[i].range;
+            const int64_t length = range.end - range.begin;
+            float *melRow = melBuffer + i * frameCount * numMelBins;
+            float *f0Row = f0Buffer + i * frameCount;
+            std::copy(input.mel + range.begin * numMelBins, input.mel + range.end * numMelBins, melRow);
+            std::copy(input.f0 + range.begin, input.f0 + range.end, f0Row);
+            for (int64_t t = length; t < frameCount; ++t) {
+                std::copy(melRow + (length - 1) * numMelBins, melRow + length * numMelBins, melRow + t * numMelBins);
+                f0Row[t] = f0Row[length - 1];
+            }
+        }
+
+        auto result = runVocoder(inferenceHandle, std::move(melTensor), std::move(f0Tensor), options, tensorPool,
+                                 status);
+        auto it = result.find("waveform");
+        if (it == result.end()) {
+            if (!result.empty()) {
+                tensorPool.recycle(result);
+                putStatus(status, Status_InferError, "Missing waveform output");
+            }
+            return {};
+        }
+        auto waveform = std::make_shared<flowonnx::Tensor>(std::move(it->second));
+        const float *buffer;
+        if (static_cast<int64_t>(waveform->getDataBuffer<float>(&buffer)) <
+            batchSize * frameCount * dsVocoderConfig.hopSize) {
+            tensorPool.release(std::move(waveform->data));
+            putStatus(status, Status_InferError, "Unexpected waveform size");
+            return {};
+        }
+        return waveform;
+    }
+
+    std::vector<AudioBuffer> run(const std::vector<MelSpectrogram> &mels, Status *status) {
+        TensorPool::Scope poolScope(&tensorPool);
+        Placement::Scope placement(options.numaNode);
+
+        const int64_t hopSize = dsVocoderConfig.hopSize;
+        std::vector<std::vector<VocoderChunk>> chunks(mels.size());
+        std::vector<WorkItem> items;
+        for (size_t i = 0; i < mels.size(); ++i) {
+            if (mels[i].frameCount <= 0) {
+                continue;
+            }
+            if (!mels[i].mel || !mels[i].f0) {
+                putStatus(status, Status_InferError, "Missing mel or f0 data of input " + std::to_string(i));
+                return {};
+            }
+            chunks[i] = planVocoderChunks(mels[i].frameCount, maxChunkFrames, chunkOverlapFrames);
+            for (size_t j = 0; j < chunks[i].size(); ++j) {
+                items.push_back({i, j, chunks[i][j]});
+            }
+        }
+
+        // Rows of similar length are batched together, so that little padding is vocoded.
+        std::stable_sort(items.begin(), items.end(), [](const WorkItem &a, const WorkItem &b) {
+            return a.range.end - a.range.begin > b.range.end - b.range.begin;
+        });
+
+        std::vector<std::vector<const float *>> chunkWaveforms(mels.size());
+        for (size_t i = 0; i < mels.size(); ++i) {
+            chunkWaveforms[i].resize(chunks[i].size());
+        }
+        std::vector<std::shared_ptr<flowonnx::Tensor>> batches;
+        const auto batchSize = static_cast<size_t>((std::max)(maxBatchSize, 1));
+        for (size_t begin = 0; begin < items.size(); begin += batchSize) {
+            const size_t count = (std::min)(batchSize, items.size() - begin);
+            auto waveform = runBatch(mels, items.data() + begin, count, status);
+            if (!waveform) {
+                recycle(batches);
+                return {};
+            }
+            const float *buffer;
+            const auto rowLength = static_cast<int64_t>(waveform->getDataBuffer<float>(&buffer)) /
+                                   static_cast<int64_t>(count);
+            for (size_t i = 0; i < count; ++i) {
+                const auto &item = items[begin + i];
+                chunkWaveforms[item.input][item.chunk] = buffer + i * rowLength;
+            }
+            batches.push_back(std::move(waveform));
+        }
+
+        std::vector<AudioBuffer> waveforms(mels.size());
+        for (size_t i = 0; i < mels.size(); ++i) {
+            auto &waveform = waveforms[i];
+            waveform.sampleRate = dsVocoderConfig.sampleRate;
+            if (chunks[i].empty()) {
+                continue;
+            }
+            auto samples = std::make_shared<std::vector<float>>(mels[i].frameCount * hopSize);
+            overlapAddChunks(chunks[i], chunkWaveforms[i], hopSize, samples->data());
+            waveform.samples = samples->data();
+            waveform.sampleCount = samples->size();
+            waveform.storage = std::move(samples);
+        }
+        recycle(batches);
+        putStatusOk(status);
+        return waveforms;
+    }
+
+    void recycle(std::vector<std::shared_ptr<flowonnx::Tensor>> &batches) {
+        for (auto &batch : batches) {
+            tensorPool.release(std::move(batch->data));
+        }
+        batches.clear();
+    }
+
+    bool terminate() {
+        return inferenceHandle.terminate();
+    }
+
+    DsVocoderConfig dsVocoderConfig;
+    TensorPool tensorPool;
+    InferenceOptions options;
+    flowonnx::Inference inferenceHandle;
+    bool preferCpu;
+    int maxBatchSize = 1;
+    int64_t maxChunkFrames = 0;
+    int64_t chunkOverlapFrames = 32;
+};
+
+VocoderInference::VocoderInference(DsVocoderConfig &&dsVocoderConfig, bool preferCpu)
+        : IInference(), _impl(std::make_unique<Impl>(preferCpu)) {
+    m_type = IT_Vocoder;
+
+    auto &impl = *_impl;
+    impl.dsVocoderConfig = std::move(dsVocoderConfig);
+}
+
+VocoderInference::VocoderInference(const DsVocoderConfig &dsVocoderConfig, bool preferCpu)
+        : IInference(), _impl(std::make_unique<Impl>(preferCpu)) {
+    m_type = IT_Vocoder;
+
+    auto &impl = *_impl;
+    impl.dsVocoderConfig = dsVocoderConfig;
+}
+
+Status VocoderInference::open() {
+    auto &impl = *_impl;
+    impl.options = m_options;
+    return impl.open();
+}
+
+void VocoderInference::close() {
+    auto &impl = *_impl;
+    return impl.close();
+}
+
+int VocoderInference::sampleRate() const {
+    auto &impl = *_impl;
+    return impl.dsVocoderConfig.sampleRate;
+}
+
+int VocoderInference::hopSize() const {
+    auto &impl = *_impl;
+    return impl.dsVocoderConfig.hopSize;
+}
+
+int VocoderInference::numMelBins() const {
+    auto &impl = *_impl;
+    return impl.dsVocoderConfig.numMelBins;
+}
+
+int VocoderInference::maxBatchSize() const {
+    auto &impl = *_impl;
+    return impl.maxBatchSize;
+}
+
+void VocoderInference::setMaxBatchSize(int size) {
+    auto &impl = *_impl;
+    impl.maxBatchSize = size;
+}
+
+int64_t VocoderInference::maxChunkFrames() const {
+    auto &impl = *_impl;
+    return impl.maxChunkFrames;
+}
+
+void VocoderInference::setMaxChunkFrames(int64_t frames) {
+    auto &impl = *_impl;
+    impl.maxChunkFrames = frames;
+}
+
+int64_t VocoderInference::chunkOverlapFrames() const {
+    auto &impl = *_impl;
+    return impl.chunkOverlapFrames;
+}
+
+void VocoderInference::setChunkOverlapFrames(int64_t frames) {
+    auto &impl = *_impl;
+    impl.chunkOverlapFrames = frames;
+}
+
+AudioBuffer VocoderInference::run(const float *mel, const float *f0, int64_t frameCount, Status *status) {
+    auto &impl = *_impl;
+    if (!mel || !f0 || frameCount <= 0) {
+        putStatus(status, Status_InferError, "Invalid mel spectrogram");
+        return {};
+    }
+    auto waveforms = impl.run({{mel, f0, frameCount}}, status);
+    return waveforms.empty() ? AudioBuffer{} : std::move(waveforms.front());
+}
+
+std::vector<AudioBuffer> VocoderInference::runBatch(const std::vector<MelSpectrogram> &mels, Status *status) {
+    auto &impl = *_impl;
+    return impl.run(mels, status);
+}
+
+TensorPoolStats VocoderInference::tensorPoolStats() const {
+    auto &impl = *_impl;
+    return impl.tensorPool.stats();
+}
+
+bool VocoderInference::terminate() {
+    auto &impl = *_impl;
+    return impl.terminate();
+}
+
+VocoderInference::~VocoderInference() = default;
+
+DSONNXINFER_END_NAMESPACE
@@ -0,0 +1,79 @@
+#ifndef DSONNXINFER_VOCODERINFERENCE_H
+#define DSONNXINFER_VOCODERINFERENCE_H
+
+#include <memory>
+#include <vector>
+#include <dsonnxinfer/dsonnxinfer_global.h>
+#include "IInference.h"
+#include <dsonnxinfer/AudioBuffer.h>
+
+DSONNXINFER_BEGIN_NAMESPACE
+
+struct MelSpectrogram {
+    // `frameCount * numMelBins` values, frame by frame
+    const float *mel = nullptr;
+    // `frameCount` values in Hz
+    const float *f0 = nullptr;
+    int64_t frameCount = 0;
+};
+
+class DSONNXINFER_EXPORT VocoderInference : public IInference {
+public:
+    explicit VocoderInference(DsVocoderConfig &&dsVocoderConfig, bool preferCpu = false);
+    explicit VocoderInference(const DsVocoderConfig &dsVocoderConfig, bool preferCpu = false);
+    ~VocoderInference() override;
+
+    using IInference::open;
+    Status open() override;
+    void close() override;
+
+    int sampleRate() const;
+    int hopSize() const;
+    int numMelBins() const;
+
+    /**
+     * @brief The maximum number of mel spectrograms (or chunks) vocoded in one run. Shorter
+     *        ones are padded to the longest of the batch, so the model must accept a batch
+     *        dimension larger than 1. Defaults to 1.
+     */
+    int maxBatchSize() const;
+    void setMaxBatchSize(int size);
+
+    /**
+     * @brief Mel spectrograms longer than this many frames are vocoded in chunks, which
+     *        share `chunkOverlapFrames()` frames and are crossfaded over them. 0 (the default)
+     *        vocodes them in one piece.
+     */
+    int64_t maxChunkFrames() const;
+    void setMaxChunkFrames(int64_t frames);
+    int64_t chunkOverlapFrames() const;
+    void setChunkOverlapFrames(int64_t frames);
+
+    /**
+     * @brief Renders a mel spectrogram to a waveform of `frameCount * hopSize()` samples.
+     *
+     * @param mel   `frameCount * numMelBins()` values, frame by frame.
+     * @param f0    `frameCount` values in Hz.
+     * @return The waveform, or an empty buffer on failure, including null data and a
+     *         `frameCount` that is not positive.
+     */
+    AudioBuffer run(const float *mel, const float *f0, int64_t frameCount, Status *status);
+
+    /**
+     * @brief Renders several mel spectrograms, batched as configured.
+     * @return The waveforms in the order of `mels`, or an empty list on failure.
+     */
+    std::vector<AudioBuffer> runBatch(const std::vector<MelSpectrogram> &mels, Status *status);
+
+    bool terminate() override;
+
+    TensorPoolStats tensorPoolStats() const override;
+
+protected:
+    class Impl;
+    std::unique_ptr<Impl> _impl;
+};
+
+DSONNXINFER_END_NAMESPACE
+
+#endif //DSONNXINFER_VOCODERINFERENCE_H
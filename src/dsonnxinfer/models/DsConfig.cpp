@@ -14,6 +14,27 @@
 
 DSONNXINFER_BEGIN_NAMESPACE
 
+static ModelVariants parseModelVariants(const YAML::Node &node, const std::filesystem::path &configDir) {
+    ModelVariants variants;
+    if (!node.IsMap()) {
+        return variants;
+    }
+    for (const auto &item : node) {
+        const auto key = item.first.as<std::string>();
+        ModelPrecision precision;
+        if (key == "fp16") {
+            precision = MP_Float16;
+        } else if (key == "int8") {
+            precision = MP_Int8;
+        } else {
+            continue;
+        }
+        auto model = DS_STRING_CONVERT(item.second.as<std::string>());
+        variants[precision] = (configDir / model).make_preferred();
+    }
+    return variants;
+}
+
 DsConfig DsConfig::fromYAML(const std::filesystem::path &dsConfigPath, bool *ok) {
     DsConfig dsConfig;
     dsConfig.features = 0;
@@ -43,6 +64,10 @@ DsConfig DsConfig::fromYAML(const std::filesystem::path &dsConfigPath, bool *ok)
         dsConfig.acoustic = (dsConfigDir / acousticFilename).make_preferred();
     }
 
+    if (const auto node = config["acoustic_variants"]) {
+        dsConfig.acousticVariants = parseModelVariants(node, dsConfigDir);
+    }
+
     if (const auto node = config["vocoder"]) {
         dsConfig.vocoder = node.as<std::string>();
     }
@@ -117,6 +142,12 @@ DsConfig DsConfig::fromYAML(const std::filesystem::path &dsConfigPath, bool *ok)
         }
     }
 
+    if (const auto node = config["broadcast_constants"]) {
+        if (node.as<bool>()) {
+            dsConfig.features |= kfBroadcastConstants;
+        }
+    }
+
     if (const auto node = config["speakers"]) {
         dsConfig.features |= kfSpkEmbed;
         dsConfig.speakers = node.as<std::vector<std::string>>();
@@ -151,6 +182,10 @@ DsVocoderConfig DsVocoderConfig::fromYAML(const std::filesystem::path &dsVocoder
         dsVocoderConfig.model = (dsVocoderConfigDir / model).make_preferred();
     }
 
+    if (const auto node = config["model_variants"]) {
+        dsVocoderConfig.modelVariants = parseModelVariants(node, dsVocoderConfigDir);
+    }
+
     if (const auto node = config["num_mel_bins"]) {
         dsVocoderConfig.numMelBins = node.as<int>();
     }
@@ -204,11 +239,19 @@ DsDurConfig DsDurConfig::fromYAML(const std::filesystem::path &dsDurConfigPath,
         dsDurConfig.linguistic = (dsDurConfigDir / model).make_preferred();
     }
 
+    if (const auto node = config["linguistic_variants"]) {
+        dsDurConfig.linguisticVariants = parseModelVariants(node, dsDurConfigDir);
+    }
+
     if (const auto node = config["dur"]) {
         auto model = DS_STRING_CONVERT(node.as<std::string>());
         dsDurConfig.dur = (dsDurConfigDir / model).make_preferred();
     }
 
+    if (const auto node = config["dur_variants"]) {
+        dsDurConfig.durVariants = parseModelVariants(node, dsDurConfigDir);
+    }
+
     if (const auto node = config["hop_size"]) {
         dsDurConfig.hopSize = node.as<int>();
     }
@@ -270,11 +313,19 @@ DsVarianceConfig DsVarianceConfig::fromYAML(const std::filesystem::path &dsVaria
         dsVarianceConfig.linguistic = (dsVarianceConfigDir / model).make_preferred();
     }
 
+    if (const auto node = config["linguistic_variants"]) {
+        dsVarianceConfig.linguisticVariants = parseModelVariants(node, dsVarianceConfigDir);
+    }
+
     if (const auto node = config["variance"]) {
         auto model = DS_STRING_CONVERT(node.as<std::string>());
         dsVarianceConfig.variance = (dsVarianceConfigDir / model).make_preferred();
     }
 
+    if (const auto node = config["variance_variants"]) {
+        dsVarianceConfig.varianceVariants = parseModelVariants(node, dsVarianceConfigDir);
+    }
+
     if (const auto node = config["hop_size"]) {
         dsVarianceConfig.hopSize = node.as<int>();
     }
@@ -337,6 +388,12 @@ DsVarianceConfig DsVarianceConfig::fromYAML(const std::filesystem::path &dsVaria
         }
     }
 
+    if (const auto node = config["broadcast_constants"]) {
+        if (node.as<bool>()) {
+            dsVarianceConfig.features |= kfBroadcastConstants;
+        }
+    }
+
     if (ok) {
         *ok = true;
     }
@@ -372,11 +429,19 @@ DsPitchConfig DsPitchConfig::fromYAML(const std::filesystem::path &dsPitchConfig
         dsPitchConfig.linguistic = (dsPitchConfigDir / model).make_preferred();
     }
 
+    if (const auto node = config["linguistic_variants"]) {
+        dsPitchConfig.linguisticVariants = parseModelVariants(node, dsPitchConfigDir);
+    }
+
     if (const auto node = config["pitch"]) {
         auto model = DS_STRING_CONVERT(node.as<std::string>());
         dsPitchConfig.pitch = (dsPitchConfigDir / model).make_preferred();
     }
 
+    if (const auto node = config["pitch_variants"]) {
+        dsPitchConfig.pitchVariants = parseModelVariants(node, dsPitchConfigDir);
+    }
+
     if (const auto node = config["hop_size"]) {
         dsPitchConfig.hopSize = node.as<int>();
     }
@@ -421,6 +486,12 @@ DsPitchConfig DsPitchConfig::fromYAML(const std::filesystem::path &dsPitchConfig
         }
     }
 
+    if (const auto node = config["broadcast_constants"]) {
+        if (node.as<bool>()) {
+            dsPitchConfig.features |= kfBroadcastConstants;
+        }
+    }
+
     if (ok) {
         *ok = true;
     }
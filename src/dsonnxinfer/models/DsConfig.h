@@ -3,6 +3,7 @@
 #define DS_ONNX_INFER_DSCONFIG_H
 
 #include <cstdint>
+#include <map>
 #include <vector>
 #include <filesystem>
 
@@ -31,12 +32,24 @@ enum DsFeature: dsfeature_t {
     kfSpkEmbed                  = 1 << 13,
     kfPitchControllable         = 1 << 14,
     kfParamMouthOpening         = 1 << 15,
+    kfBroadcastConstants        = 1 << 16,
 };
 
+enum ModelPrecision {
+    MP_Float32 = 0,
+    MP_Float16,
+    MP_Int8,
+};
+
+// Reduced-precision variants of a model, declared in the config as `<model key>_variants`
+// with `fp16` and `int8` keys. The model itself is the float32 reference.
+using ModelVariants = std::map<ModelPrecision, std::filesystem::path>;
+
 struct DSONNXINFER_EXPORT DsVocoderConfig {
     std::string name;
 
     std::filesystem::path model;
+    ModelVariants modelVariants;
 
     int numMelBins = 128;
     int hopSize = 512;
@@ -50,6 +63,7 @@ struct DSONNXINFER_EXPORT DsConfig {
     std::filesystem::path phonemes;
     std::filesystem::path languages;
     std::filesystem::path acoustic;
+    ModelVariants acousticVariants;
     std::string vocoder;
     std::vector<std::string> speakers;
     SpeakerEmbed spkEmb;
@@ -68,6 +82,8 @@ struct DSONNXINFER_EXPORT DsDurConfig {
     std::filesystem::path languages;
     std::filesystem::path linguistic;
     std::filesystem::path dur;
+    ModelVariants linguisticVariants;
+    ModelVariants durVariants;
     std::vector<std::string> speakers;
     SpeakerEmbed spkEmb;
 
@@ -84,6 +100,8 @@ struct DSONNXINFER_EXPORT DsVarianceConfig {
     std::filesystem::path languages;
     std::filesystem::path linguistic;
     std::filesystem::path variance;
+    ModelVariants linguisticVariants;
+    ModelVariants varianceVariants;
     std::vector<std::string> speakers;
     SpeakerEmbed spkEmb;
 
@@ -100,6 +118,8 @@ struct DSONNXINFER_EXPORT DsPitchConfig {
     std::filesystem::path languages;
     std::filesystem::path linguistic;
     std::filesystem::path pitch;
+    ModelVariants linguisticVariants;
+    ModelVariants pitchVariants;
     std::vector<std::string> speakers;
     SpeakerEmbed spkEmb;
 
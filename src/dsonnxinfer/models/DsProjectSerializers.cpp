@@ -1,10 +1,45 @@
 #include "DsProjectSerializers_p.h"
 
+#include <algorithm>
+
 #include <dsonnxinfer/DsProject.h>
 #include <dsonnxinfer/SampleCurve.h>
 
 DSONNXINFER_BEGIN_NAMESPACE
 
+// A breakpoint is a [time, value] pair.
+void to_json(nlohmann::json &j, const SampleCurve::Point &point) {
+    j = nlohmann::json::array({point.time, point.value});
+}
+
+void from_json(const nlohmann::json &j, SampleCurve::Point &point) {
+    j.at(0).get_to(point.time);
+    j.at(1).get_to(point.value);
+}
+
+// Dynamic curves are written as "points" if they have breakpoints, and as "values" otherwise.
+static void curveToJson(nlohmann::json &j, const SampleCurve &curve) {
+    if (curve.isPiecewise()) {
+        j["points"] = curve.points;
+    } else {
+        j["values"] = curve.samples;
+    }
+}
+
+static void curveFromJson(const nlohmann::json &j, SampleCurve &curve) {
+    if (auto it = j.find("points"); it != j.end()) {
+        it->get_to(curve.points);
+        // The curve is evaluated in ascending time order. Breakpoints at the same time keep
+        // their order, since they make a step.
+        const auto byTime = [](const SampleCurve::Point &a, const SampleCurve::Point &b) { return a.time < b.time; };
+        if (!std::is_sorted(curve.points.begin(), curve.points.end(), byTime)) {
+            std::stable_sort(curve.points.begin(), curve.points.end(), byTime);
+        }
+    } else {
+        j.at("values").get_to(curve.samples);
+    }
+}
+
 void to_json(nlohmann::json &j, const Phoneme &phoneme) {
     j = {
         {"token", phoneme.token},
@@ -81,19 +116,19 @@ void to_json(nlohmann::json &j, const Parameter &parameter) {
         {"tag", parameter.tag},
         {"interval", parameter.sample_curve.timestep},
         {"dynamic", true},
-        {"values", parameter.sample_curve.samples},
         {"retake", {
             {"start", parameter.retake_start},
             {"end", parameter.retake_end},
         }},
     };
+    curveToJson(j, parameter.sample_curve);
 }
 
 void from_json(const nlohmann::json &j, Parameter &parameter) {
     j.at("tag").get_to(parameter.tag);
     if (j["dynamic"]) {
         j.at("interval").get_to(parameter.sample_curve.timestep);
-        j.at("values").get_to(parameter.sample_curve.samples);
+        curveFromJson(j, parameter.sample_curve);
     } else {
         parameter.sample_curve.samples.resize(1);
         j.at("value").get_to(parameter.sample_curve.samples[0]);
@@ -116,12 +151,12 @@ void from_json(const nlohmann::json &j, Parameter &parameter) {
             if (it_end != it->end()) {
                 parameter.retake_end = *it_end;
             } else {
-                parameter.retake_end = parameter.sample_curve.samples.size();
+                parameter.retake_end = parameter.sample_curve.sampleCount();
             }
         }
     } else {
         parameter.retake_start = 0;
-        parameter.retake_end = parameter.sample_curve.samples.size();
+        parameter.retake_end = parameter.sample_curve.sampleCount();
     }
 }
 
@@ -171,7 +206,7 @@ void from_json(const nlohmann::json &j, Segment &segment) {
 void to_json(nlohmann::json &j, const SpeakerMixCurve &spk) {
     for (const auto &[name, sc] : spk.spk) {
         nlohmann::json j_item;
-        if (sc.samples.size() == 1) {
+        if (sc.samples.size() == 1 && !sc.isPiecewise()) {
             j_item = {
                     {"name", name},
                     {"dynamic", false},
@@ -182,8 +217,8 @@ void to_json(nlohmann::json &j, const SpeakerMixCurve &spk) {
                     {"name", name},
                     {"dynamic", true},
                     {"interval", sc.timestep},
-                    {"values", sc.samples},
             };
+            curveToJson(j_item, sc);
         }
         j.push_back(std::move(j_item));
     }
@@ -196,7 +231,7 @@ void from_json(const nlohmann::json &j, SpeakerMixCurve &spk) {
     for (const auto &j_item : j) {
         SampleCurve sc;
         if (j_item["dynamic"]) {
-            j_item["values"].get_to(sc.samples);
+            curveFromJson(j_item, sc);
             j_item["interval"].get_to(sc.timestep);
         } else {
             sc.samples.resize(1);
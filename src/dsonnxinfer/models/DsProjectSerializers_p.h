@@ -2,6 +2,7 @@
 #define DS_ONNX_INFER_DSPROJECTSERIALIZERS_H
 
 #include <dsonnxinfer/dsonnxinfer_global.h>
+#include <dsonnxinfer/SampleCurve.h>
 
 #include <nlohmann/json.hpp>
 
@@ -12,7 +13,9 @@ struct Note;
 struct Word;
 struct Parameter;
 struct Segment;
-struct SpeakerMixCurve;
+
+void to_json(nlohmann::json &j, const SampleCurve::Point &point);
+void from_json(const nlohmann::json &j, SampleCurve::Point &point);
 
 void to_json(nlohmann::json &j, const Phoneme &phoneme);
 void from_json(const nlohmann::json &j, Phoneme &phoneme);
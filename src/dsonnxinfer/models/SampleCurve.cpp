@@ -2,13 +2,59 @@
 
 #include <cmath>
 #include <algorithm>
+#include <iterator>
+#include <limits>
 
 #include <dsonnxinfer/ArrayUtil.hpp>
 
 DSONNXINFER_BEGIN_NAMESPACE
 
+// Resamples a breakpoint curve, one segment between breakpoints at a time.
+static std::vector<double> resamplePoints(const SampleCurve &curve, double targetTimestep,
+                                          int64_t targetLength, bool fillLast) {
+    const auto &points = curve.points;
+    if (targetLength <= 0) {
+        return {};
+    }
+    if (curve.isConstant()) {
+        return std::vector<double>(targetLength, points.front().value);
+    }
+    if (targetTimestep <= 0) {
+        return {};
+    }
+    std::vector<double> result(targetLength);
+    int64_t i = 0;
+    const auto timeAt = [targetTimestep](int64_t index) { return static_cast<double>(index) * targetTimestep; };
+
+    // Before the first breakpoint
+    for (; i < targetLength && timeAt(i) < points.front().time; ++i) {
+        result[i] = points.front().value;
+    }
+    for (size_t k = 0; k + 1 < points.size() && i < targetLength; ++k) {
+        const auto &p0 = points[k];
+        const auto &p1 = points[k + 1];
+        if (p1.time <= p0.time) {
+            continue;
+        }
+        const double slope = (p1.value - p0.value) / (p1.time - p0.time);
+        for (; i < targetLength; ++i) {
+            const double t = timeAt(i);
+            if (t >= p1.time) {
+                break;
+            }
+            result[i] = p0.value + (t - p0.time) * slope;
+        }
+    }
+    // From the last breakpoint on, like the expansion of dense samples.
+    std::fill(result.begin() + i, result.end(), fillLast ? points.back().value : 0.0);
+    return result;
+}
+
 std::vector<double>
 SampleCurve::resample(double targetTimestep, int64_t targetLength, bool fillLast) const {
+    if (!points.empty()) {
+        return resamplePoints(*this, targetTimestep, targetLength, fillLast);
+    }
     if (samples.empty() || targetLength == 0) {
         return {};
     }
@@ -50,6 +96,100 @@ SampleCurve::resample(double targetTimestep, int64_t targetLength, bool fillLast
     return targetSamples;
 }
 
+SampleCurve SampleCurve::fromPoints(std::vector<Point> points, double timestep) {
+    SampleCurve curve;
+    curve.points = std::move(points);
+    curve.timestep = timestep;
+    return curve;
+}
+
+bool SampleCurve::isConstant() const {
+    if (!points.empty()) {
+        const double value = points.front().value;
+        return std::all_of(points.begin(), points.end(), [value](const Point &p) { return p.value == value; });
+    }
+    return samples.size() == 1;
+}
+
+size_t SampleCurve::sampleCount() const {
+    if (points.empty()) {
+        return samples.size();
+    }
+    if (timestep <= 0) {
+        return 1;
+    }
+    return static_cast<size_t>(std::floor((std::max)(points.back().time, 0.0) / timestep)) + 1;
+}
+
+double SampleCurve::valueAt(double time) const {
+    if (!points.empty()) {
+        // First breakpoint after `time`
+        auto it = std::upper_bound(points.begin(), points.end(), time,
+                                   [](double t, const Point &p) { return t < p.time; });
+        if (it == points.begin()) {
+            return points.front().value;
+        }
+        if (it == points.end()) {
+            return points.back().value;
+        }
+        const auto &p0 = *std::prev(it);
+        return interpolatePointLinear(p0.time, p0.value, it->time, it->value, time);
+    }
+    if (samples.empty()) {
+        return 0.0;
+    }
+    if (samples.size() == 1 || timestep <= 0 || time <= 0) {
+        return samples.front();
+    }
+    const double x = time / timestep;
+    const auto last = samples.size() - 1;
+    if (x >= static_cast<double>(last)) {
+        return samples.back();
+    }
+    const auto index = static_cast<size_t>(x);
+    return samples[index] + (x - static_cast<double>(index)) * (samples[index + 1] - samples[index]);
+}
+
+SampleCurve SampleCurve::compacted(double tolerance) const {
+    if (!points.empty() || samples.size() <= 2 || timestep <= 0) {
+        return *this;
+    }
+    const auto timeAt = [this](size_t index) { return static_cast<double>(index) * timestep; };
+
+    // Extend each segment while its slope stays within the bounds set by the samples it
+    // covers, then start the next one from the last covered sample. Slopes are per sample,
+    // and a few ulps of rounding are not counted as a deviation, so that exact ramps merge.
+    std::vector<Point> result;
+    result.push_back({0.0, samples.front()});
+    size_t anchor = 0;
+    double lo = -std::numeric_limits<double>::infinity();
+    double hi = std::numeric_limits<double>::infinity();
+    for (size_t i = 1; i < samples.size(); ++i) {
+        const auto dx = static_cast<double>(i - anchor);
+        const double slope = (samples[i] - samples[anchor]) / dx;
+        if (slope < lo || slope > hi) {
+            anchor = i - 1;
+            result.push_back({timeAt(anchor), samples[anchor]});
+            if (2 * result.size() >= samples.size()) {
+                return *this;
+            }
+            lo = -std::numeric_limits<double>::infinity();
+            hi = std::numeric_limits<double>::infinity();
+            --i;
+            continue;
+        }
+        const double slack = tolerance + 4 * std::numeric_limits<double>::epsilon() *
+                                             (std::abs(samples[i]) + std::abs(samples[anchor]));
+        lo = (std::max)(lo, (samples[i] - slack - samples[anchor]) / dx);
+        hi = (std::min)(hi, (samples[i] + slack - samples[anchor]) / dx);
+    }
+    result.push_back({timeAt(samples.size() - 1), samples.back()});
+    if (2 * result.size() >= samples.size()) {
+        return *this;
+    }
+    return fromPoints(std::move(result), timestep);
+}
+
 SampleCurve::SampleCurve() : samples(), timestep(0.0) {}
 
 SampleCurve::SampleCurve(double fillValue, int64_t targetLength, double targetTimestep)
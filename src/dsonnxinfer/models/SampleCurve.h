@@ -12,14 +12,59 @@
 DSONNXINFER_BEGIN_NAMESPACE
 
 struct SampleCurve {
+    // A breakpoint of a piecewise linear curve, time in seconds.
+    struct Point {
+        double time;
+        double value;
+    };
+
     std::vector<double> samples;
     double timestep = 0.0;
 
+    /**
+     * Breakpoints in ascending time order. If not empty, the curve is made of them instead
+     * of `samples`: it is linear between two breakpoints, and holds the first and the last
+     * value outside of them. Two breakpoints at the same time make a step. Loading a
+     * segment sorts the breakpoints by time, keeping the order of equal times.
+     *
+     * `timestep` is still the unit of the retake range of a parameter.
+     */
+    std::vector<Point> points;
+
     SampleCurve();
     SampleCurve(const std::vector<double> &samples, double timestep);
     SampleCurve(std::vector<double> &&samples, double timestep);
     SampleCurve(double fillValue, int64_t targetLength, double targetTimestep);
 
+    static SampleCurve fromPoints(std::vector<Point> points, double timestep = 0.0);
+
+    inline bool empty() const;
+    inline bool isPiecewise() const;
+
+    /**
+     * @brief Returns true if the curve has a single sample, or its breakpoints all have
+     *        the same value.
+     */
+    bool isConstant() const;
+
+    /**
+     * @brief Returns the number of samples at `timestep` that the curve spans.
+     */
+    size_t sampleCount() const;
+
+    /**
+     * @brief Returns the interpolated value at `time` seconds, clamped to the ends of the curve.
+     */
+    double valueAt(double time) const;
+
+    /**
+     * @brief Converts dense samples to breakpoints where that is smaller.
+     *
+     * @param tolerance  The largest allowed deviation from the samples. With 0, only runs of
+     *                   equal samples and exact ramps are merged.
+     */
+    SampleCurve compacted(double tolerance = 0.0) const;
+
     /**
      * @brief Resamples curve to target time step and length using interpolation.
      *
@@ -34,10 +79,21 @@ struct SampleCurve {
      * The original curve will be interpolated, then resized to the target length.
      * If the interpolated vector's size is smaller than the target length, it is expanded by
      * appending the last value (or zeros if `fillLast` is false). If larger, it is truncated.
+     *
+     * Constant curves are broadcast, and breakpoint curves are resampled segment by segment,
+     * so that the time does not depend on the length of the source curve.
      */
     std::vector<double> resample(double targetTimestep, int64_t targetLength, bool fillLast = true) const;
 };
 
+bool SampleCurve::empty() const {
+    return samples.empty() && points.empty();
+}
+
+bool SampleCurve::isPiecewise() const {
+    return !points.empty();
+}
+
 // TODO: still figuring out the format of spk_mix
 struct SpeakerMixCurve {
     std::unordered_map<std::string, SampleCurve> spk;
@@ -2,6 +2,11 @@
 #include <fstream>
 #include <filesystem>
 #include <sstream>
+#include <mutex>
+#include <memory>
+#include <cstring>
+#include <cstdint>
+#include <algorithm>
 #include "SpeakerEmbed.h"
 
 #include <syscmdline/system.h>
@@ -19,43 +24,207 @@ SpeakerEmbed::SpeakerEmbed(const std::vector<std::string> &speakers, const std::
     loadSpeakers(speakers, path);
 }
 
+namespace {
+    /**
+     * Packed store of the embedding vectors in use by the process.
+     *
+     * Rows are allocated in pages, so that a row never moves while it is referenced.
+     * Rows are deduplicated by file and by contents, and reference counted: a row is
+     * freed when the last config that references it is destroyed, its slot is reused
+     * by later rows, and pages without rows are released.
+     */
+    class SpeakerEmbedStore {
+    public:
+        static SpeakerEmbedStore &instance() {
+            static SpeakerEmbedStore store;
+            return store;
+        }
+
+        std::shared_ptr<const float> load(const std::filesystem::path &fullPath, const std::string &speaker) {
+            std::error_code ec;
+            if (!std::filesystem::exists(fullPath, ec)) {
+                // ERROR!
+                std::cout << "ERROR: emb file of speaker \"" << speaker << "\" does not exist!\n";
+                return nullptr;
+            }
+            auto size = std::filesystem::file_size(fullPath, ec);
+            if (ec || size != SPK_EMBED_SIZE * sizeof(float)) {
+                std::cout << "ERROR: emb file size of speaker \"" << speaker << "\" must be exactly " << SPK_EMBED_SIZE << " bytes!\n";
+                return nullptr;
+            }
+            const auto mtime = std::filesystem::last_write_time(fullPath, ec);
+            auto key = fullPath.lexically_normal().string();
+
+            // No reference may be dropped while the lock is held, since the last one
+            // releases its row under the lock.
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (auto it = m_byPath.find(key); it != m_byPath.end() && it->second.first == mtime) {
+                if (auto row = m_slots[it->second.second].row.lock()) {
+                    return row;
+                }
+            }
+
+            std::ifstream inputFile(fullPath, std::ios::binary);
+            if (!inputFile.is_open()) {
+                std::cout << "ERROR: emb file size of speaker \"" << speaker << "\" could not be opened!\n";
+                return nullptr;
+            }
+            SpeakerEmbedArray emb{};
+            inputFile.read(reinterpret_cast<char *>(emb.data()), emb.size() * sizeof(float));
+            inputFile.close();
+
+            auto [slot, row] = findOrAdd(emb);
+            m_slots[slot].paths.push_back(key);
+            m_byPath[std::move(key)] = {mtime, slot};
+            return row;
+        }
+
+    private:
+        static constexpr size_t RowsPerPage = 64;
+
+        struct Slot {
+            std::weak_ptr<const float> row;
+            uint64_t hash = 0;
+            std::vector<std::string> paths;
+        };
+
+        struct Page {
+            std::unique_ptr<float[]> data;
+            size_t rowCount = 0;
+        };
+
+        static uint64_t hash(const SpeakerEmbedArray &emb) {
+            // FNV-1a
+            uint64_t h = 14695981039346656037ull;
+            const auto *bytes = reinterpret_cast<const unsigned char *>(emb.data());
+            for (size_t i = 0; i < sizeof(SpeakerEmbedArray); ++i) {
+                h ^= bytes[i];
+                h *= 1099511628211ull;
+            }
+            return h;
+        }
+
+        float *rowData(size_t slot) const {
+            return m_pages[slot / RowsPerPage].data.get() + (slot % RowsPerPage) * SPK_EMBED_SIZE;
+        }
+
+        std::pair<size_t, std::shared_ptr<const float>> findOrAdd(const SpeakerEmbedArray &emb) {
+            const auto h = hash(emb);
+            auto range = m_byContent.equal_range(h);
+            for (auto it = range.first; it != range.second; ++it) {
+                // Rows whose last reference is gone stay valid until they are released,
+                // which waits for the lock.
+                if (std::memcmp(rowData(it->second), emb.data(), sizeof(SpeakerEmbedArray)) == 0) {
+                    if (auto row = m_slots[it->second].row.lock()) {
+                        return {it->second, row};
+                    }
+                }
+            }
+
+            size_t slot;
+            if (!m_freeSlots.empty()) {
+                slot = m_freeSlots.back();
+                m_freeSlots.pop_back();
+            } else {
+                slot = m_slots.size();
+                m_slots.emplace_back();
+                if (slot % RowsPerPage == 0) {
+                    m_pages.emplace_back();
+                }
+            }
+            auto &page = m_pages[slot / RowsPerPage];
+            if (!page.data) {
+                page.data.reset(new float[RowsPerPage * SPK_EMBED_SIZE]);
+            }
+            ++page.rowCount;
+
+            float *data = rowData(slot);
+            std::copy(emb.begin(), emb.end(), data);
+            std::shared_ptr<const float> row(data, [this, slot](const float *) { release(slot); });
+            m_slots[slot].row = row;
+            m_slots[slot].hash = h;
+            m_byContent.emplace(h, slot);
+            return {slot, row};
+        }
+
+        void release(size_t slot) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            auto &s = m_slots[slot];
+            for (const auto &path : s.paths) {
+                if (auto it = m_byPath.find(path); it != m_byPath.end() && it->second.second == slot) {
+                    m_byPath.erase(it);
+                }
+            }
+            auto range = m_byContent.equal_range(s.hash);
+            for (auto it = range.first; it != range.second; ++it) {
+                if (it->second == slot) {
+                    m_byContent.erase(it);
+                    break;
+                }
+            }
+            s = {};
+            m_freeSlots.push_back(slot);
+            auto &page = m_pages[slot / RowsPerPage];
+            if (--page.rowCount == 0) {
+                page.data.reset();
+            }
+        }
+
+        std::mutex m_mutex;
+        std::vector<Page> m_pages;
+        std::vector<Slot> m_slots;
+        std::vector<size_t> m_freeSlots;
+        std::unordered_map<std::string, std::pair<std::filesystem::file_time_type, size_t>> m_byPath;
+        std::unordered_multimap<uint64_t, size_t> m_byContent;
+    };
+}
+
 void SpeakerEmbed::loadSpeakers(const std::vector<std::string> &speakers, const std::filesystem::path &path) {
+    auto &store = SpeakerEmbedStore::instance();
     for (const auto &speaker : speakers) {
         auto fullPath = path / DS_STRING_CONVERT(speaker + ".emb");
-        if (!std::filesystem::exists(fullPath)) {
-            // ERROR!
-            std::cout << "ERROR: emb file of speaker \"" << speaker << "\" does not exist!\n";
-            continue;
-        }
-        auto size = std::filesystem::file_size(fullPath);
-        if (size != SPK_EMBED_SIZE * sizeof(float)) {
-            std::cout << "ERROR: emb file size of speaker \"" << speaker << "\" must be exactly " << SPK_EMBED_SIZE << " bytes!\n";
-            continue;
-        }
-        std::ifstream inputFile(fullPath, std::ios::binary);
-        if (!inputFile.is_open()) {
-            std::cout << "ERROR: emb file size of speaker \"" << speaker << "\" could not be opened!\n";
+        auto row = store.load(fullPath, speaker);
+        if (auto it = m_index.find(speaker); it != m_index.end()) {
+            m_rows[it->second] = std::move(row);
             continue;
         }
-        SpeakerEmbedArray emb{};
-        inputFile.read(reinterpret_cast<char *>(emb.data()), emb.size() * sizeof(float));
-        m_emb[speaker] = emb;
-        SpeakerEmbedMap mmmm;
+        m_index.emplace(speaker, static_cast<int>(m_speakers.size()));
+        m_speakers.push_back(speaker);
+        m_rows.push_back(std::move(row));
+    }
+}
 
-        inputFile.close();
+size_t SpeakerEmbed::speakerCount() const {
+    return m_speakers.size();
+}
+
+int SpeakerEmbed::speakerIndex(const std::string &speaker) const {
+    auto it = m_index.find(speaker);
+    return it != m_index.end() ? it->second : -1;
+}
+
+const float *SpeakerEmbed::embedding(int index) const {
+    if (index < 0 || static_cast<size_t>(index) >= m_rows.size()) {
+        return nullptr;
     }
+    return m_rows[index].get();
 }
 
 const SpeakerEmbedMap &SpeakerEmbed::getEmb() {
+    m_emb.clear();
+    for (size_t i = 0; i < m_speakers.size(); ++i) {
+        if (const float *row = m_rows[i].get()) {
+            auto &arr = m_emb[m_speakers[i]];
+            std::copy(row, row + SPK_EMBED_SIZE, arr.begin());
+        }
+    }
     return m_emb;
 }
 
 SpeakerEmbedArray SpeakerEmbed::getMixedEmb(const std::unordered_map<std::string, double> &mix) const {
     SpeakerEmbedArray arr{};
     for (const auto &item : mix) {
-        auto it = m_emb.find(item.first);
-        if (it != m_emb.end()) {
-            const auto currentArr = it->second;
+        if (const float *currentArr = embedding(speakerIndex(item.first))) {
             for (size_t i = 0; i < SPK_EMBED_SIZE; i++) {
                 arr[i] += static_cast<float>(currentArr[i] * item.second);
             }
@@ -2,6 +2,7 @@
 #define DS_ONNX_INFER_SPEAKEREMBED_H
 
 #include <array>
+#include <memory>
 #include <vector>
 #include <string>
 #include <unordered_map>
@@ -15,8 +16,22 @@ constexpr unsigned int SPK_EMBED_SIZE = 256;
 using SpeakerEmbedArray = std::array<float, SPK_EMBED_SIZE>;
 using SpeakerEmbedMap = std::unordered_map<std::string, SpeakerEmbedArray>;
 
+/**
+ * @brief Speaker embeddings of a config.
+ *
+ * The embedding vectors live in a process-wide packed store and are never copied per
+ * config: configs that load the same .emb file (or files with identical contents)
+ * reference the same row, and the row is freed with the last config that references
+ * it. Speakers are addressed by their index in the `speakers` list of the config;
+ * resolve names with speakerIndex() once and use the index after.
+ */
 class SpeakerEmbed {
 private:
+    std::vector<std::string> m_speakers;
+    // Row of each speaker in the store, nullptr if the .emb file could not be loaded.
+    std::vector<std::shared_ptr<const float>> m_rows;
+    std::unordered_map<std::string, int> m_index;
+    // Only filled by getEmb()
     SpeakerEmbedMap m_emb;
 public:
     SpeakerEmbed();
@@ -28,6 +43,23 @@ public:
 
     static std::unordered_map<std::string, double> parseMixString(const std::string &inputString);
 
+    size_t speakerCount() const;
+
+    /**
+     * @return The index of the speaker, or -1 if the speaker is unknown.
+     */
+    int speakerIndex(const std::string &speaker) const;
+
+    /**
+     * @return The SPK_EMBED_SIZE floats of the speaker, or nullptr if the embedding
+     *         of the speaker could not be loaded.
+     */
+    const float *embedding(int index) const;
+
+    /**
+     * @brief Copies the embeddings into a map by speaker name, for compatibility.
+     */
+    [[deprecated("Use speakerIndex() and embedding() instead")]]
     const SpeakerEmbedMap &getEmb();
 };
 
@@ -0,0 +1,270 @@
+#include "Voicebank.h"
+
+#include <array>
+#include <future>
+#include <string>
+#include <utility>
+
+#include "../inference/PhonemeDict_p.h"
+
+namespace fs = std::filesystem;
+
+DSONNXINFER_BEGIN_NAMESPACE
+
+constexpr size_t kStageCount = static_cast<size_t>(VS_Acoustic) + 1;
+
+class Voicebank::Impl {
+public:
+    void reset() {
+        rootDir.clear();
+        loaded = false;
+        present = {};
+        acoustic = {};
+        vocoder = {};
+        duration = {};
+        pitch = {};
+        variance = {};
+        for (auto &d : deps) {
+            d.clear();
+        }
+        order.clear();
+        dictionaries.clear();
+    }
+
+    void buildDependencyGraph() {
+        // What each stage consumes from the previous stages:
+        //   pitch:    phone durations
+        //   variance: phone durations, pitch
+        //   acoustic: phone durations, pitch, variance parameters, and the vocoder to render
+        static const std::array<std::vector<VoicebankStage>, kStageCount> allDeps = {{
+            {},                                             // VS_Duration
+            {VS_Duration},                                  // VS_Pitch
+            {VS_Duration, VS_Pitch},                        // VS_Variance
+            {},                                             // VS_Vocoder
+            {VS_Duration, VS_Pitch, VS_Variance, VS_Vocoder}, // VS_Acoustic
+        }};
+        for (size_t i = 0; i < kStageCount; ++i) {
+            if (!present[i]) {
+                continue;
+            }
+            for (auto dep : allDeps[i]) {
+                if (present[dep]) {
+                    deps[i].push_back(dep);
+                }
+            }
+            // Stages are declared in dependency order.
+            order.push_back(static_cast<VoicebankStage>(i));
+        }
+    }
+
+    Status loadDictionaries() {
+        struct DictRef {
+            const fs::path *phonemes;
+            const fs::path *languages;
+            bool multiLanguage;
+        };
+        std::vector<DictRef> refs;
+        auto addRef = [&refs](const fs::path &phonemes, const fs::path &languages, dsfeature_t features) {
+            const bool multiLanguage = features & kfMultiLanguage;
+            for (const auto &ref : refs) {
+                if (*ref.phonemes == phonemes && ref.multiLanguage == multiLanguage &&
+                    (!multiLanguage || *ref.languages == languages)) {
+                    return;
+                }
+            }
+            refs.push_back({&phonemes, &languages, multiLanguage});
+        };
+        if (present[VS_Duration]) {
+            addRef(duration.phonemes, duration.languages, duration.features);
+        }
+        if (present[VS_Pitch]) {
+            addRef(pitch.phonemes, pitch.languages, pitch.features);
+        }
+        if (present[VS_Variance]) {
+            addRef(variance.phonemes, variance.languages, variance.features);
+        }
+        addRef(acoustic.phonemes, acoustic.languages, acoustic.features);
+
+        std::vector<std::future<std::pair<std::shared_ptr<const PhonemeDict>, std::string>>> futures;
+        futures.reserve(refs.size());
+        for (const auto &ref : refs) {
+            futures.push_back(std::async(std::launch::async, [ref] {
+                std::string errorMessage;
+                auto dict = PhonemeDict::load(*ref.phonemes, *ref.languages, ref.multiLanguage, &errorMessage);
+                return std::make_pair(std::move(dict), std::move(errorMessage));
+            }));
+        }
+        Status status;
+        for (auto &future : futures) {
+            auto [dict, errorMessage] = future.get();
+            if (!dict) {
+                status = {Status_ModelLoadError, std::move(errorMessage)};
+            } else {
+                dictionaries.push_back(std::move(dict));
+            }
+        }
+        return status;
+    }
+
+    fs::path rootDir;
+    bool loaded = false;
+    std::array<bool, kStageCount> present = {};
+
+    DsConfig acoustic;
+    DsVocoderConfig vocoder;
+    DsDurConfig duration;
+    DsPitchConfig pitch;
+    DsVarianceConfig variance;
+
+    std::array<std::vector<VoicebankStage>, kStageCount> deps;
+    std::vector<VoicebankStage> order;
+
+    // Keep the shared dictionaries loaded while the voice bank is alive.
+    std::vector<std::shared_ptr<const PhonemeDict>> dictionaries;
+};
+
+template <typename Config>
+static std::future<std::pair<Config, bool>> fromYAMLAsync(fs::path path) {
+    return std::async(std::launch::async, [path = std::move(path)] {
+        bool ok = false;
+        auto config = Config::fromYAML(path, &ok);
+        return std::make_pair(std::move(config), ok);
+    });
+}
+
+Voicebank::Voicebank() : _impl(std::make_unique<Impl>()) {
+}
+
+Voicebank::~Voicebank() = default;
+
+Status Voicebank::load(const fs::path &path) {
+    auto &impl = *_impl;
+    impl.reset();
+
+    std::error_code ec;
+    const auto dsConfigPath = fs::is_directory(path, ec) ? path / "dsconfig.yaml" : path;
+    if (!fs::exists(dsConfigPath, ec)) {
+        return {Status_ModelLoadError, "Voice bank config does not exist: " + dsConfigPath.string()};
+    }
+    const auto rootDir = dsConfigPath.parent_path();
+
+    const auto vocoderPath = rootDir / "dsvocoder" / "vocoder.yaml";
+    const auto durPath = rootDir / "dsdur" / "dsconfig.yaml";
+    const auto pitchPath = rootDir / "dspitch" / "dsconfig.yaml";
+    const auto variancePath = rootDir / "dsvariance" / "dsconfig.yaml";
+
+    impl.present[VS_Acoustic] = true;
+    impl.present[VS_Vocoder] = fs::exists(vocoderPath, ec);
+    impl.present[VS_Duration] = fs::exists(durPath, ec);
+    impl.present[VS_Pitch] = fs::exists(pitchPath, ec);
+    impl.present[VS_Variance] = fs::exists(variancePath, ec);
+
+    // Parse all configs concurrently. Speaker embeddings referenced by more than one
+    // config are only read once (see SpeakerEmbed::loadSpeakers).
+    auto acousticFuture = fromYAMLAsync<DsConfig>(dsConfigPath);
+    std::future<std::pair<DsVocoderConfig, bool>> vocoderFuture;
+    std::future<std::pair<DsDurConfig, bool>> durFuture;
+    std::future<std::pair<DsPitchConfig, bool>> pitchFuture;
+    std::future<std::pair<DsVarianceConfig, bool>> varianceFuture;
+    if (impl.present[VS_Vocoder]) {
+        vocoderFuture = fromYAMLAsync<DsVocoderConfig>(vocoderPath);
+    }
+    if (impl.present[VS_Duration]) {
+        durFuture = fromYAMLAsync<DsDurConfig>(durPath);
+    }
+    if (impl.present[VS_Pitch]) {
+        pitchFuture = fromYAMLAsync<DsPitchConfig>(pitchPath);
+    }
+    if (impl.present[VS_Variance]) {
+        varianceFuture = fromYAMLAsync<DsVarianceConfig>(variancePath);
+    }
+
+    std::string errorMessage;
+    auto collect = [&errorMessage](auto &future, auto &config, const fs::path &configPath) {
+        if (!future.valid()) {
+            return;
+        }
+        try {
+            auto [result, ok] = future.get();
+            if (!ok) {
+                errorMessage += "Failed to load config: " + configPath.string() + '\n';
+                return;
+            }
+            config = std::move(result);
+        } catch (const std::exception &e) {
+            errorMessage += "Failed to parse config " + configPath.string() + ": " + e.what() + '\n';
+        }
+    };
+    collect(acousticFuture, impl.acoustic, dsConfigPath);
+    collect(vocoderFuture, impl.vocoder, vocoderPath);
+    collect(durFuture, impl.duration, durPath);
+    collect(pitchFuture, impl.pitch, pitchPath);
+    collect(varianceFuture, impl.variance, variancePath);
+    if (!errorMessage.empty()) {
+        errorMessage.pop_back();
+        impl.reset();
+        return {Status_ModelLoadError, std::move(errorMessage)};
+    }
+
+    if (auto status = impl.loadDictionaries(); !status.isOk()) {
+        impl.reset();
+        return status;
+    }
+
+    impl.buildDependencyGraph();
+    impl.rootDir = rootDir;
+    impl.loaded = true;
+    return {Status_Ok, ""};
+}
+
+bool Voicebank::isLoaded() const {
+    auto &impl = *_impl;
+    return impl.loaded;
+}
+
+fs::path Voicebank::rootDirectory() const {
+    auto &impl = *_impl;
+    return impl.rootDir;
+}
+
+bool Voicebank::hasStage(VoicebankStage stage) const {
+    auto &impl = *_impl;
+    return impl.loaded && impl.present[stage];
+}
+
+const std::vector<VoicebankStage> &Voicebank::dependencies(VoicebankStage stage) const {
+    auto &impl = *_impl;
+    return impl.deps[stage];
+}
+
+const std::vector<VoicebankStage> &Voicebank::stageOrder() const {
+    auto &impl = *_impl;
+    return impl.order;
+}
+
+const DsConfig &Voicebank::acousticConfig() const {
+    auto &impl = *_impl;
+    return impl.acoustic;
+}
+
+const DsVocoderConfig &Voicebank::vocoderConfig() const {
+    auto &impl = *_impl;
+    return impl.vocoder;
+}
+
+const DsDurConfig &Voicebank::durationConfig() const {
+    auto &impl = *_impl;
+    return impl.duration;
+}
+
+const DsPitchConfig &Voicebank::pitchConfig() const {
+    auto &impl = *_impl;
+    return impl.pitch;
+}
+
+const DsVarianceConfig &Voicebank::varianceConfig() const {
+    auto &impl = *_impl;
+    return impl.variance;
+}
+
+DSONNXINFER_END_NAMESPACE
@@ -0,0 +1,78 @@
+#ifndef DS_ONNX_INFER_VOICEBANK_H
+#define DS_ONNX_INFER_VOICEBANK_H
+
+#include <filesystem>
+#include <memory>
+#include <vector>
+
+#include <dsonnxinfer/dsonnxinfer_global.h>
+#include <dsonnxinfer/DsConfig.h>
+#include <dsonnxinfer/Status.h>
+
+DSONNXINFER_BEGIN_NAMESPACE
+
+enum VoicebankStage {
+    VS_Duration = 0,
+    VS_Pitch,
+    VS_Variance,
+    VS_Vocoder,
+    VS_Acoustic,
+};
+
+/**
+ * @brief All model configs of a DiffSinger voice bank.
+ *
+ * Expects the layout below, where everything except the root `dsconfig.yaml` is optional:
+ *
+ *     dsconfig.yaml                 (acoustic)
+ *     dsvocoder/vocoder.yaml
+ *     dsdur/dsconfig.yaml
+ *     dspitch/dsconfig.yaml
+ *     dsvariance/dsconfig.yaml
+ *
+ * All configs are parsed concurrently. Resources referenced by more than one config
+ * (phoneme dictionaries and speaker embeddings) are loaded once and shared, and stay
+ * loaded while the Voicebank is alive, so that opening the inference objects does not
+ * load them again.
+ */
+class DSONNXINFER_EXPORT Voicebank {
+public:
+    Voicebank();
+    ~Voicebank();
+
+public:
+    /**
+     * @param path  The voice bank directory, or its root `dsconfig.yaml`.
+     */
+    Status load(const std::filesystem::path &path);
+    bool isLoaded() const;
+
+    std::filesystem::path rootDirectory() const;
+
+    bool hasStage(VoicebankStage stage) const;
+
+    /**
+     * @brief Stages that must run (or be opened, for the vocoder) before the given stage.
+     *        Only stages present in this voice bank are listed.
+     */
+    const std::vector<VoicebankStage> &dependencies(VoicebankStage stage) const;
+
+    /**
+     * @brief The present stages in dependency order.
+     */
+    const std::vector<VoicebankStage> &stageOrder() const;
+
+    const DsConfig &acousticConfig() const;
+    const DsVocoderConfig &vocoderConfig() const;
+    const DsDurConfig &durationConfig() const;
+    const DsPitchConfig &pitchConfig() const;
+    const DsVarianceConfig &varianceConfig() const;
+
+protected:
+    class Impl;
+    std::unique_ptr<Impl> _impl;
+};
+
+DSONNXINFER_END_NAMESPACE
+
+#endif // DS_ONNX_INFER_VOICEBANK_H
@@ -51,6 +51,11 @@ enum InterpolationMethod {
  * leftFillValue or rightFillValue is not provided, NaN is used as the fill value.
  * If an element in samplePoints is NaN, the corresponding element in the interpolated
  * vector is also set to NaN.
+ *
+ * Precondition: samplePoints and referencePoints are both in ascending order. The search
+ * for each sample point continues from the previous one, so unsorted samplePoints give
+ * wrong values, and unsorted referencePoints may read past their end. The order is not
+ * checked; callers sort their inputs first.
  */
 template<class T>
 inline std::vector<T> interpolate(
@@ -143,11 +148,12 @@ std::vector<T> interpolate(
 	std::vector<T> interpolatedValues;
 	interpolatedValues.reserve(samplePoints.size());
 
+	// Both axes are ascending, so the search continues from the previous sample point.
+	size_t index = 0;
 	for (const auto &samplePoint: samplePoints) {
 		if (samplePoint < referencePoints.front() || samplePoint > referencePoints.back()) {
 			interpolatedValues.push_back(samplePoint < referencePoints.front() ? leftFillValue : rightFillValue);
 		} else {
-			size_t index = 0;
 			while (referencePoints[index] < samplePoint) {
 				++index;
 			}
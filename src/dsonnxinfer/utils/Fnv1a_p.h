@@ -0,0 +1,42 @@
+#ifndef DS_ONNX_INFER_FNV1A_P_H
+#define DS_ONNX_INFER_FNV1A_P_H
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#include <dsonnxinfer/dsonnxinfer_global.h>
+
+DSONNXINFER_BEGIN_NAMESPACE
+
+/**
+ * @brief 64-bit FNV-1a hash, for fingerprints of inputs and settings that are compared
+ *        within one process. Values are hashed by their bytes.
+ */
+class Fnv1a {
+public:
+    void bytes(const void *data, size_t size) {
+        const auto p = static_cast<const unsigned char *>(data);
+        for (size_t i = 0; i < size; ++i) {
+            m_hash ^= p[i];
+            m_hash *= 0x100000001b3ull;
+        }
+    }
+
+    template <typename T>
+    void value(const T &v) {
+        static_assert(std::is_trivially_copyable_v<T>, "only plain values are hashed by their bytes");
+        bytes(&v, sizeof(v));
+    }
+
+    uint64_t result() const {
+        return m_hash;
+    }
+
+private:
+    uint64_t m_hash = 0xcbf29ce484222325ull;
+};
+
+DSONNXINFER_END_NAMESPACE
+
+#endif // DS_ONNX_INFER_FNV1A_P_H
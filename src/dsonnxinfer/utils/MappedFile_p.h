@@ -0,0 +1,42 @@
+#ifndef DS_ONNX_INFER_MAPPEDFILE_P_H
+#define DS_ONNX_INFER_MAPPEDFILE_P_H
+
+#include <cstddef>
+#include <filesystem>
+
+#include <dsonnxinfer/dsonnxinfer_global.h>
+
+DSONNXINFER_BEGIN_NAMESPACE
+
+/**
+ * @brief Read-only memory mapping of a whole file.
+ */
+class MappedFile {
+public:
+    MappedFile();
+    ~MappedFile();
+
+    MappedFile(MappedFile &&other) noexcept;
+    MappedFile &operator=(MappedFile &&other) noexcept;
+
+    DSONNXINFER_DISABLE_COPY(MappedFile)
+
+    bool open(const std::filesystem::path &path);
+    void close();
+
+    bool isOpen() const;
+    const char *data() const;
+    size_t size() const;
+
+private:
+    const char *m_data = nullptr;
+    size_t m_size = 0;
+#ifdef _WIN32
+    void *m_file = nullptr;
+    void *m_mapping = nullptr;
+#endif
+};
+
+DSONNXINFER_END_NAMESPACE
+
+#endif // DS_ONNX_INFER_MAPPEDFILE_P_H
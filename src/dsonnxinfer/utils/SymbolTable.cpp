@@ -0,0 +1,74 @@
+#include "SymbolTable_p.h"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+
+DSONNXINFER_BEGIN_NAMESPACE
+
+namespace {
+    // Names are stored in fixed-size chunks that are never moved, so that readers only
+    // need the published count to access them.
+    constexpr int32_t kChunkBits = 12;
+    constexpr int32_t kChunkSize = 1 << kChunkBits;
+    constexpr int32_t kMaxChunks = 1 << 12;
+
+    struct Table {
+        std::shared_mutex mutex;
+        std::unordered_map<std::string_view, int32_t> index;
+        std::unique_ptr<std::string[]> chunks[kMaxChunks];
+        std::atomic<int32_t> count{0};
+    };
+
+    Table &table() {
+        static Table instance;
+        return instance;
+    }
+}
+
+namespace SymbolTable {
+    int32_t intern(std::string_view name) {
+        auto &t = table();
+        std::unique_lock<std::shared_mutex> lock(t.mutex);
+        if (auto it = t.index.find(name); it != t.index.end()) {
+            return it->second;
+        }
+        const int32_t symbol = t.count.load(std::memory_order_relaxed);
+        if ((symbol >> kChunkBits) >= kMaxChunks) {
+            return NoSymbol;
+        }
+        auto &chunk = t.chunks[symbol >> kChunkBits];
+        if (!chunk) {
+            chunk = std::make_unique<std::string[]>(kChunkSize);
+        }
+        auto &stored = chunk[symbol & (kChunkSize - 1)];
+        stored = name;
+        t.index.emplace(stored, symbol);
+        t.count.store(symbol + 1, std::memory_order_release);
+        return symbol;
+    }
+
+    int32_t find(std::string_view name) {
+        auto &t = table();
+        std::shared_lock<std::shared_mutex> lock(t.mutex);
+        const auto it = t.index.find(name);
+        return it != t.index.end() ? it->second : NoSymbol;
+    }
+
+    std::string_view name(int32_t symbol) {
+        auto &t = table();
+        if (symbol < 0 || symbol >= t.count.load(std::memory_order_acquire)) {
+            return {};
+        }
+        return t.chunks[symbol >> kChunkBits][symbol & (kChunkSize - 1)];
+    }
+
+    int32_t count() {
+        return table().count.load(std::memory_order_acquire);
+    }
+}
+
+DSONNXINFER_END_NAMESPACE
@@ -0,0 +1,39 @@
+#ifndef DS_ONNX_INFER_SYMBOLTABLE_P_H
+#define DS_ONNX_INFER_SYMBOLTABLE_P_H
+
+#include <cstdint>
+#include <string_view>
+
+#include <dsonnxinfer/dsonnxinfer_global.h>
+
+DSONNXINFER_BEGIN_NAMESPACE
+
+/**
+ * @brief Process-wide interning of phoneme and language names.
+ *
+ * Every distinct name gets a dense, never reused ID. Only dictionaries intern their
+ * names, when they are loaded; segments look their phones up with find(), which never
+ * adds a name, so that tokenizing a phone is an array lookup by ID. Names are never
+ * freed, so the table is bounded by the distinct names of the dictionaries loaded by
+ * the process, not by the segments it sees.
+ *
+ * name() does not lock.
+ */
+namespace SymbolTable {
+    static constexpr int32_t NoSymbol = -1;
+
+    int32_t intern(std::string_view name);
+
+    // The ID of an interned name, or NoSymbol if no dictionary has it
+    int32_t find(std::string_view name);
+
+    // The interned name, or an empty view for NoSymbol and unknown IDs
+    std::string_view name(int32_t symbol);
+
+    // IDs are in [0, count())
+    int32_t count();
+}
+
+DSONNXINFER_END_NAMESPACE
+
+#endif // DS_ONNX_INFER_SYMBOLTABLE_P_H
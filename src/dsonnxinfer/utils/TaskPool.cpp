@@ -0,0 +1,148 @@
+#include "TaskPool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <memory>
+#include <utility>
+
+#include "../core/Placement_p.h"
+
+DSONNXINFER_BEGIN_NAMESPACE
+
+TaskPool::TaskPool(unsigned threadCount) {
+    m_threads.reserve(threadCount);
+    for (unsigned i = 0; i < threadCount; ++i) {
+        m_threads.emplace_back([this] { run(); });
+    }
+}
+
+TaskPool::~TaskPool() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_cv.notify_all();
+    for (auto &thread : m_threads) {
+        thread.join();
+    }
+}
+
+static std::atomic<unsigned> g_globalThreadCount{0};
+// Set once the global pool exists, whose size is fixed from then on
+static std::atomic<TaskPool *> g_globalPool{nullptr};
+
+TaskPool &TaskPool::global() {
+    static TaskPool pool(globalThreadCount());
+    g_globalPool.store(&pool, std::memory_order_release);
+    return pool;
+}
+
+void TaskPool::setGlobalThreadCount(unsigned threadCount) {
+    g_globalThreadCount = threadCount;
+}
+
+unsigned TaskPool::globalThreadCount() {
+    if (const auto pool = g_globalPool.load(std::memory_order_acquire)) {
+        return pool->threadCount();
+    }
+    if (const unsigned threadCount = g_globalThreadCount) {
+        return threadCount;
+    }
+    return (std::max)(std::thread::hardware_concurrency(), 2u) - 1;
+}
+
+unsigned TaskPool::threadCount() const {
+    return static_cast<unsigned>(m_threads.size());
+}
+
+void TaskPool::post(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_tasks.push_back(std::move(task));
+    }
+    m_cv.notify_one();
+}
+
+void TaskPool::parallelFor(size_t count, const std::function<void(size_t)> &fn) {
+    if (count == 0) {
+        return;
+    }
+    if (count == 1 || m_threads.empty()) {
+        for (size_t i = 0; i < count; ++i) {
+            fn(i);
+        }
+        return;
+    }
+
+    // Helpers may start after the loop is finished, so the state is shared with them.
+    struct Job {
+        const std::function<void(size_t)> *fn;
+        size_t count;
+        std::atomic<size_t> next{0};
+        std::atomic<size_t> done{0};
+        std::mutex mutex;
+        std::condition_variable cv;
+        std::exception_ptr exception;
+
+        void work() {
+            size_t finished = 0;
+            for (size_t i = next++; i < count; i = next++) {
+                try {
+                    (*fn)(i);
+                } catch (...) {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    if (!exception) {
+                        exception = std::current_exception();
+                    }
+                }
+                ++finished;
+            }
+            if (finished > 0 && (done += finished) == count) {
+                std::lock_guard<std::mutex> lock(mutex);
+                cv.notify_all();
+            }
+        }
+    };
+    auto job = std::make_shared<Job>();
+    job->fn = &fn;
+    job->count = count;
+
+    // Helpers work on the NUMA node the caller is placed on, so that the memory they
+    // first touch is local to it.
+    const int node = Placement::scopeNode();
+    const size_t helpers = (std::min)(count - 1, m_threads.size());
+    for (size_t i = 0; i < helpers; ++i) {
+        post([job, node] {
+            if (job->next >= job->count) {
+                return;
+            }
+            Placement::Scope placement(node);
+            job->work();
+        });
+    }
+    job->work();
+
+    std::unique_lock<std::mutex> lock(job->mutex);
+    job->cv.wait(lock, [&job] { return job->done == job->count; });
+    if (job->exception) {
+        std::rethrow_exception(job->exception);
+    }
+}
+
+void TaskPool::run() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true) {
+        m_cv.wait(lock, [this] { return m_stopping || !m_tasks.empty(); });
+        if (m_tasks.empty()) {
+            break;
+        }
+        auto task = std::move(m_tasks.front());
+        m_tasks.pop_front();
+        lock.unlock();
+        task();
+        lock.lock();
+    }
+}
+
+DSONNXINFER_END_NAMESPACE
@@ -0,0 +1,68 @@
+#ifndef DS_ONNX_INFER_TASKPOOL_H
+#define DS_ONNX_INFER_TASKPOOL_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <dsonnxinfer/dsonnxinfer_global.h>
+
+DSONNXINFER_BEGIN_NAMESPACE
+
+/**
+ * @brief Fixed-size worker pool for CPU-side work of the library.
+ *
+ * parallelFor() runs on the calling thread as well, and only returns when all
+ * iterations are done, so it can be nested and called from the workers themselves.
+ */
+class TaskPool {
+public:
+    explicit TaskPool(unsigned threadCount);
+    ~TaskPool();
+
+    DSONNXINFER_DISABLE_COPY_MOVE(TaskPool)
+
+    /**
+     * @brief The pool shared by the whole library, with one worker less than the
+     *        hardware threads (the caller is the last one).
+     */
+    static TaskPool &global();
+
+    /**
+     * @brief Sets the number of workers of the global pool; 0 restores the default.
+     *        Only takes effect if called before the global pool is first used.
+     */
+    static void setGlobalThreadCount(unsigned threadCount);
+
+    /**
+     * @brief The number of workers of the global pool, or the number it will be created
+     *        with if it has not been used yet.
+     */
+    static unsigned globalThreadCount();
+
+    unsigned threadCount() const;
+
+    void post(std::function<void()> task);
+
+    /**
+     * @brief Calls `fn(i)` for every `i` in `[0, count)`, in parallel.
+     */
+    void parallelFor(size_t count, const std::function<void(size_t)> &fn);
+
+private:
+    void run();
+
+    std::vector<std::thread> m_threads;
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::deque<std::function<void()>> m_tasks;
+    bool m_stopping = false;
+};
+
+DSONNXINFER_END_NAMESPACE
+
+#endif // DS_ONNX_INFER_TASKPOOL_H
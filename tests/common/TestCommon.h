@@ -0,0 +1,29 @@
+#ifndef DS_ONNX_INFER_TESTCOMMON_H
+#define DS_ONNX_INFER_TESTCOMMON_H
+
+#include <iostream>
+
+// Reports a failed check and continues; main() returns testResult().
+#define TEST_CHECK(condition)                                                                  \
+    do {                                                                                       \
+        if (!(condition)) {                                                                    \
+            std::cout << __FILE__ << ':' << __LINE__ << ": check failed: " #condition "\n";   \
+            ++testFailures();                                                                  \
+        }                                                                                      \
+    } while (false)
+
+inline int &testFailures() {
+    static int failures = 0;
+    return failures;
+}
+
+inline int testResult() {
+    if (testFailures() == 0) {
+        std::cout << "all checks passed\n";
+        return 0;
+    }
+    std::cout << testFailures() << " check(s) failed\n";
+    return 1;
+}
+
+#endif // DS_ONNX_INFER_TESTCOMMON_H
@@ -0,0 +1,326 @@
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <vector>
+
+#include <dsonnxinfer/DsConfig.h>
+#include <dsonnxinfer/DsProject.h>
+
+#include "inference/CompactSegment_p.h"
+#include "inference/InferenceCommon_p.h"
+#include "inference/InputPlan_p.h"
+#include "inference/PhonemeDict_p.h"
+#include "utils/SymbolTable_p.h"
+
+#include "TestCommon.h"
+
+namespace fs = std::filesystem;
+using namespace dsonnxinfer;
+
+constexpr double kFrameLength = 512.0 / 44100.0;
+constexpr int kIterations = 500;
+
+const char *const kPhonemes[] = {"SP", "AP", "a", "i", "u", "k", "s", "unknown"};
+
+// The preprocessing on the nested segment, as it was before CompactSegment.
+namespace reference {
+    template <typename T>
+    void fillRestMidiWithNearest(std::vector<T> &src, T restMidi) {
+        auto not_zero = [restMidi](T x) { return x != restMidi; };
+        auto it = std::find(src.begin(), src.end(), restMidi);
+        auto it_left = std::find_if(src.begin(), it, not_zero);
+        auto it_right = std::find_if(it, src.end(), not_zero);
+        if (it == src.end() || it_right == src.end()) {
+            return;
+        }
+        if (it_left == it) {
+            std::fill(src.begin(), it_right, *it_right);
+            it = it_right;
+        }
+        while (it != src.end() || it_right != src.end()) {
+            auto it_prev = it;
+            it = std::find(it_prev, src.end(), restMidi);
+            it_left = it - 1;
+            it_right = std::find_if(it, src.end(), not_zero);
+            if (it_right == src.end()) {
+                std::fill(it, it_right, *it_left);
+                break;
+            }
+            auto dist = std::distance(it_left, it_right);
+            auto left_fills = dist / 2;
+            auto right_fills = dist - left_fills - 1;
+            std::fill(it, it + left_fills, *it_left);
+            std::fill(it_right - right_fills, it_right, *it_right);
+        }
+    }
+
+    std::vector<int64_t> phonemeTokens(const Segment &dsSegment, const PhonemeDict &phonemeDict) {
+        std::vector<int64_t> tokens;
+        for (const auto &word : dsSegment.words) {
+            for (const auto &phone : word.phones) {
+                tokens.push_back(phonemeDict.lookupToken(phone.token, phone.language));
+            }
+        }
+        return tokens;
+    }
+
+    std::vector<int64_t> phonemeDurations(const Segment &dsSegment, double frameLength) {
+        std::vector<int64_t> durations;
+        double phoneDurSum = 0.0;
+        for (size_t currWordIndex = 0; currWordIndex < dsSegment.words.size(); ++currWordIndex) {
+            const auto &word = dsSegment.words[currWordIndex];
+            auto wordDuration = word.duration();
+            for (size_t i = 0; i < word.phones.size(); ++i) {
+                bool currPhoneIsTheLastPhone = (i == word.phones.size() - 1);
+                auto currPhoneStart = phoneDurSum + word.phones[i].start;
+                auto nextPhoneStart = phoneDurSum + (currPhoneIsTheLastPhone ? wordDuration : word.phones[i + 1].start);
+                if (currPhoneIsTheLastPhone && (currWordIndex + 1 < dsSegment.words.size())) {
+                    const auto &nextWord = dsSegment.words[currWordIndex + 1];
+                    if (!nextWord.phones.empty()) {
+                        nextPhoneStart += nextWord.phones[0].start;
+                    }
+                }
+                int64_t currPhoneStartFrames = std::llround(currPhoneStart / frameLength);
+                int64_t nextPhoneStartFrames = std::llround(nextPhoneStart / frameLength);
+                durations.push_back(nextPhoneStartFrames - currPhoneStartFrames);
+            }
+            phoneDurSum += wordDuration;
+        }
+        return durations;
+    }
+
+    std::vector<int64_t> wordDurations(const Segment &dsSegment, double frameLength) {
+        std::vector<int64_t> wordDurFrames;
+        int64_t wordDurSumPrevFrames = 0;
+        double wordDurSumCurr = 0.0;
+        for (const auto &word : dsSegment.words) {
+            wordDurSumCurr += word.duration();
+            int64_t wordDurSumCurrFrames = std::llround(wordDurSumCurr / frameLength);
+            wordDurFrames.push_back(wordDurSumCurrFrames - wordDurSumPrevFrames);
+            wordDurSumPrevFrames = wordDurSumCurrFrames;
+        }
+        return wordDurFrames;
+    }
+
+    std::vector<int64_t> phonemeMidi(const Segment &dsSegment) {
+        std::vector<int64_t> phMidi;
+        constexpr int64_t restMidi = -127;
+        bool nonRestOccurred = false;
+        size_t restCountAtBeginning = 0;
+        int64_t fillMidiForBeginning = 0;
+        int64_t lastMidi = restMidi;
+
+        auto visit = [&](const Note &note) {
+            if (!nonRestOccurred) {
+                if (!note.is_rest) {
+                    fillMidiForBeginning = note.key;
+                    nonRestOccurred = true;
+                    return false;
+                }
+                return true;
+            }
+            lastMidi = note.is_rest ? restMidi : note.key;
+            return false;
+        };
+
+        for (const auto &word : dsSegment.words) {
+            if (word.notes.empty()) {
+                continue;
+            }
+            if (word.notes.size() == 1) {
+                if (visit(word.notes[0])) {
+                    restCountAtBeginning += word.phones.size();
+                }
+                phMidi.insert(phMidi.end(), word.phones.size(), lastMidi);
+                continue;
+            }
+            std::vector<double> noteCumDur;
+            double s = 0.0;
+            for (const auto &note : word.notes) {
+                s += note.duration;
+                noteCumDur.push_back(s);
+            }
+            for (const auto &phone : word.phones) {
+                size_t noteIndex = 0;
+                while (noteIndex < noteCumDur.size() && !(phone.start > noteCumDur[noteIndex])) {
+                    ++noteIndex;
+                }
+                if (noteIndex >= word.notes.size()) {
+                    noteIndex = word.notes.size() - 1;
+                }
+                if (visit(word.notes[noteIndex])) {
+                    ++restCountAtBeginning;
+                }
+                phMidi.push_back(lastMidi);
+            }
+        }
+        restCountAtBeginning = (std::min)(restCountAtBeginning, phMidi.size());
+        std::fill(phMidi.begin(), phMidi.begin() + restCountAtBeginning, fillMidiForBeginning);
+        fillRestMidiWithNearest(phMidi, restMidi);
+        return phMidi;
+    }
+
+    struct NoteInputs {
+        std::vector<float> midi;
+        std::vector<int64_t> durations;
+        std::vector<uint8_t> rests;
+    };
+
+    NoteInputs noteInputs(const Segment &dsSegment, double frameLength) {
+        NoteInputs result;
+        constexpr float restMidi = -127.0f;
+        double noteDurSum = 0.0;
+        for (const auto &word : dsSegment.words) {
+            for (const auto &note : word.notes) {
+                result.rests.push_back(note.is_rest ? 1 : 0);
+                result.midi.push_back(note.is_rest ? restMidi
+                                                   : static_cast<float>(note.key) + static_cast<float>(note.cents) / 100.0f);
+                int64_t noteDurPrevFrames = std::llround(noteDurSum / frameLength);
+                noteDurSum += note.duration;
+                int64_t noteDurCurrFrames = std::llround(noteDurSum / frameLength);
+                result.durations.push_back(noteDurCurrFrames - noteDurPrevFrames);
+            }
+        }
+        fillRestMidiWithNearest(result.midi, restMidi);
+        return result;
+    }
+}
+
+template <typename T>
+static std::vector<T> values(const InferMap &inputs, const char *name) {
+    const auto it = inputs.find(name);
+    if (it == inputs.end()) {
+        return {};
+    }
+    const T *buffer;
+    const auto size = it->second.getDataBuffer<T>(&buffer);
+    return {buffer, buffer + size};
+}
+
+static std::vector<uint8_t> boolValues(const InferMap &inputs, const char *name) {
+    const auto it = inputs.find(name);
+    if (it == inputs.end()) {
+        return {};
+    }
+    const auto &data = it->second.data;
+    return {data.begin(), data.end()};
+}
+
+// Words with zero to four phones and zero to three notes, with leading rests, phones
+// that start before their word and notes of zero length.
+static Segment randomSegment(std::mt19937 &rng) {
+    std::uniform_int_distribution<int> wordCount(0, 8);
+    std::uniform_int_distribution<int> phoneCount(0, 4);
+    std::uniform_int_distribution<int> noteCount(0, 3);
+    std::uniform_int_distribution<int> phoneme(0, static_cast<int>(std::size(kPhonemes)) - 1);
+    std::uniform_int_distribution<int> key(40, 80);
+    std::uniform_int_distribution<int> cents(-50, 50);
+    std::uniform_real_distribution<double> duration(0.0, 0.8);
+    std::uniform_real_distribution<double> start(-0.1, 0.6);
+    std::bernoulli_distribution rest(0.25);
+
+    Segment segment;
+    const int words = wordCount(rng);
+    for (int w = 0; w < words; ++w) {
+        Word word;
+        const int phones = phoneCount(rng);
+        double phoneStart = (std::min)(0.0, start(rng));
+        for (int p = 0; p < phones; ++p) {
+            word.phones.push_back({kPhonemes[phoneme(rng)], "", p == 0 ? phoneStart : start(rng)});
+        }
+        std::sort(word.phones.begin(), word.phones.end(),
+                  [](const Phoneme &a, const Phoneme &b) { return a.start < b.start; });
+        const int notes = noteCount(rng);
+        for (int n = 0; n < notes; ++n) {
+            Note note;
+            note.key = key(rng);
+            note.cents = cents(rng);
+            note.duration = n == 1 && rest(rng) ? 0.0 : duration(rng);
+            note.is_rest = rest(rng);
+            word.notes.push_back(note);
+        }
+        segment.words.push_back(std::move(word));
+    }
+    return segment;
+}
+
+static std::shared_ptr<const PhonemeDict> loadDict() {
+    const auto dir = fs::temp_directory_path() / "dsonnxinfer_tst_compactsegment";
+    fs::create_directories(dir);
+    const auto path = dir / "phonemes.txt";
+    {
+        std::ofstream file(path);
+        // All but the last name, which stays unknown
+        for (size_t i = 0; i + 1 < std::size(kPhonemes); ++i) {
+            file << kPhonemes[i] << '\n';
+        }
+    }
+    std::string errorMessage;
+    auto dict = PhonemeDict::load(path, {}, false, &errorMessage);
+    if (!dict) {
+        std::cout << errorMessage << '\n';
+    }
+    return dict;
+}
+
+int main() {
+    const auto dict = loadDict();
+    TEST_CHECK(dict != nullptr);
+    if (!dict) {
+        return testResult();
+    }
+
+    DsPitchConfig dsPitchConfig;
+    dsPitchConfig.features = kfParamNoteRest;
+    const auto pitchPlan = InputPlan::forPitch(dsPitchConfig);
+    const auto durationPlan = InputPlan::forDuration(DsDurConfig());
+
+    const auto symbolCount = SymbolTable::count();
+    std::mt19937 rng(20261019);
+    for (int i = 0; i < kIterations; ++i) {
+        const auto dsSegment = randomSegment(rng);
+        const CompactSegment segment(dsSegment, dict.get());
+
+        const auto expectedDurations = reference::phonemeDurations(dsSegment, kFrameLength);
+        int64_t expectedFrames = 0;
+        for (const auto d : expectedDurations) {
+            expectedFrames += d;
+        }
+
+        const auto linguistic = linguisticPreprocess(segment, kFrameLength, false);
+        TEST_CHECK(values<int64_t>(linguistic, "tokens") == reference::phonemeTokens(dsSegment, *dict));
+        TEST_CHECK(values<int64_t>(linguistic, "ph_dur") == expectedDurations);
+        TEST_CHECK(getFrameCount(dsSegment, kFrameLength) == expectedFrames);
+
+        const auto predicted = linguisticPreprocess(segment, kFrameLength, true);
+        TEST_CHECK(values<int64_t>(predicted, "word_dur") == reference::wordDurations(dsSegment, kFrameLength));
+        std::vector<int64_t> wordDiv;
+        for (const auto &word : dsSegment.words) {
+            wordDiv.push_back(static_cast<int64_t>(word.phones.size()));
+        }
+        TEST_CHECK(values<int64_t>(predicted, "word_div") == wordDiv);
+
+        const auto duration = durPreprocess(segment, durationPlan);
+        TEST_CHECK(values<int64_t>(duration, "ph_midi") == reference::phonemeMidi(dsSegment));
+
+        const auto pitch = pitchProcess(segment, pitchPlan, kFrameLength);
+        const auto notes = reference::noteInputs(dsSegment, kFrameLength);
+        TEST_CHECK(values<float>(pitch, "note_midi") == notes.midi);
+        TEST_CHECK(values<int64_t>(pitch, "note_dur") == notes.durations);
+        TEST_CHECK(boolValues(pitch, "note_rest") == notes.rests);
+
+        if (testFailures() > 0) {
+            std::cout << "first failing segment: iteration " << i << '\n';
+            break;
+        }
+    }
+
+    // Segments only look their names up, so names in no dictionary are never interned.
+    TEST_CHECK(SymbolTable::count() == symbolCount);
+    TEST_CHECK(SymbolTable::find("unknown") == SymbolTable::NoSymbol);
+    TEST_CHECK(SymbolTable::find("a") != SymbolTable::NoSymbol);
+    return testResult();
+}
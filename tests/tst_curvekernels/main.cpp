@@ -0,0 +1,217 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "core/CurveKernels_p.h"
+
+#include "TestCommon.h"
+
+using namespace dsonnxinfer;
+
+// exp2Affine may differ from the scalar reference by one float ulp; all other kernels,
+// clamp included, must give identical results. Any NaN matches any NaN.
+constexpr int64_t kExp2MaxUlps = 1;
+
+constexpr double kInf = std::numeric_limits<double>::infinity();
+constexpr double kNaN = std::numeric_limits<double>::quiet_NaN();
+
+// Maps the bits of a float to integers that are ordered like the values, so that the
+// difference counts the representable floats in between. -0 and +0 are one apart.
+static int64_t orderedBits(float value) {
+    int32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits < 0 ? -static_cast<int64_t>(bits & 0x7fffffff) - 1 : bits;
+}
+
+static int64_t ulpDistance(float a, float b) {
+    if (std::isnan(a) || std::isnan(b)) {
+        return std::isnan(a) && std::isnan(b) ? 0 : std::numeric_limits<int64_t>::max();
+    }
+    return std::abs(orderedBits(a) - orderedBits(b));
+}
+
+template <class T>
+static bool identical(T a, T b) {
+    return (std::isnan(a) && std::isnan(b)) || std::memcmp(&a, &b, sizeof(T)) == 0;
+}
+
+// Random values mixed with NaN, infinities, signed zeros, subnormals and values at the
+// limits of float and double. The lengths are not multiples of the vector width, so the
+// scalar tails are covered too.
+static std::vector<double> testInputs(std::mt19937 &rng, double low, double high) {
+    std::vector<double> result = {
+        kNaN, -kNaN, kInf, -kInf, 0.0, -0.0,
+        std::numeric_limits<double>::max(), -std::numeric_limits<double>::max(),
+        std::numeric_limits<double>::denorm_min(), -std::numeric_limits<double>::min(),
+        std::numeric_limits<float>::max(), -std::numeric_limits<float>::max(),
+        std::numeric_limits<float>::denorm_min(), std::numeric_limits<float>::min() / 3.0,
+        -1022.5, -1022.0, 1023.0, 1023.5, -149.5, -126.0, 127.99999, 128.0, 128.00001,
+    };
+    std::uniform_real_distribution<double> value(low, high);
+    while (result.size() < 1037) {
+        result.push_back(value(rng));
+    }
+    std::shuffle(result.begin(), result.end(), rng);
+    return result;
+}
+
+static std::vector<float> toFloats(const std::vector<double> &values) {
+    std::vector<float> result(values.size());
+    for (size_t i = 0; i < values.size(); ++i) {
+        result[i] = static_cast<float>(values[i]);
+    }
+    return result;
+}
+
+static void testExp2Affine(const CurveKernels::Table &kernels, const CurveKernels::Table &scalar,
+                           std::mt19937 &rng) {
+    struct Case {
+        double low, high, scale, bias;
+    };
+    // MIDI pitch to Hz, exponents around the float range, and beyond the double range
+    const Case cases[] = {
+        {0.0, 127.0, 1.0 / 12.0, std::log2(440.0) - 69.0 / 12.0},
+        {-160.0, 140.0, 1.0, 0.0},
+        {-1100.0, 1100.0, 1.0, 0.0},
+        {-3.0, 3.0, 1e300, 0.0},
+    };
+    for (const auto &c : cases) {
+        const auto x = testInputs(rng, c.low, c.high);
+        for (const size_t n : {x.size(), size_t{1}, size_t{3}, size_t{7}, size_t{0}}) {
+            std::vector<float> expected(n), actual(n);
+            scalar.exp2Affine(x.data(), n, c.scale, c.bias, expected.data());
+            kernels.exp2Affine(x.data(), n, c.scale, c.bias, actual.data());
+            int64_t worst = 0;
+            for (size_t i = 0; i < n; ++i) {
+                worst = (std::max)(worst, ulpDistance(expected[i], actual[i]));
+            }
+            TEST_CHECK(worst <= kExp2MaxUlps);
+        }
+    }
+
+    // Saturation and NaN, independent of the reference
+    const std::vector<double> special = {kNaN, kInf, -kInf, 2000.0, -2000.0, 0.0, 1.0, -1.0, 10.0};
+    std::vector<float> out(special.size());
+    kernels.exp2Affine(special.data(), special.size(), 1.0, 0.0, out.data());
+    TEST_CHECK(std::isnan(out[0]));
+    TEST_CHECK(std::isinf(out[1]) && out[1] > 0.0f);
+    TEST_CHECK(out[2] == 0.0f && !std::signbit(out[2]));
+    TEST_CHECK(std::isinf(out[3]) && out[3] > 0.0f);
+    TEST_CHECK(out[4] == 0.0f);
+    TEST_CHECK(out[5] == 1.0f && out[6] == 2.0f && out[7] == 0.5f && out[8] == 1024.0f);
+}
+
+static void testAddScaled(const CurveKernels::Table &kernels, const CurveKernels::Table &scalar,
+                          std::mt19937 &rng) {
+    const auto x = testInputs(rng, -100.0, 100.0);
+    const auto base = testInputs(rng, -1e6, 1e6);
+    for (const double scale : {0.37, -1.0, 0.0, 1e300, kInf}) {
+        auto expected = base;
+        auto actual = base;
+        scalar.addScaled(x.data(), x.size(), scale, expected.data());
+        kernels.addScaled(x.data(), x.size(), scale, actual.data());
+        bool same = true;
+        for (size_t i = 0; i < x.size(); ++i) {
+            same = same && identical(expected[i], actual[i]);
+        }
+        TEST_CHECK(same);
+    }
+}
+
+static void testAccumulateScaled(const CurveKernels::Table &kernels, const CurveKernels::Table &scalar,
+                                 std::mt19937 &rng) {
+    const auto x = toFloats(testInputs(rng, -1.0, 1.0));
+    const auto base = toFloats(testInputs(rng, -1.0, 1.0));
+    for (const double scale : {0.25, 1.0 / 3.0, -7.5, 0.0, 1e40, kNaN}) {
+        auto expected = base;
+        auto actual = base;
+        scalar.accumulateScaled(x.data(), x.size(), scale, expected.data());
+        kernels.accumulateScaled(x.data(), x.size(), scale, actual.data());
+        bool same = true;
+        for (size_t i = 0; i < x.size(); ++i) {
+            same = same && identical(expected[i], actual[i]);
+        }
+        TEST_CHECK(same);
+    }
+}
+
+static void testConversions(const CurveKernels::Table &kernels, const CurveKernels::Table &scalar,
+                            std::mt19937 &rng) {
+    const auto doubles = testInputs(rng, -1e40, 1e40);
+    std::vector<float> expectedFloats(doubles.size()), actualFloats(doubles.size());
+    scalar.toFloat(doubles.data(), doubles.size(), expectedFloats.data());
+    kernels.toFloat(doubles.data(), doubles.size(), actualFloats.data());
+    bool same = true;
+    for (size_t i = 0; i < doubles.size(); ++i) {
+        same = same && identical(expectedFloats[i], actualFloats[i]);
+    }
+    TEST_CHECK(same);
+
+    const auto floats = toFloats(testInputs(rng, -1e30, 1e30));
+    std::vector<double> expectedDoubles(floats.size()), actualDoubles(floats.size());
+    scalar.toDouble(floats.data(), floats.size(), expectedDoubles.data());
+    kernels.toDouble(floats.data(), floats.size(), actualDoubles.data());
+    same = true;
+    for (size_t i = 0; i < floats.size(); ++i) {
+        same = same && identical(expectedDoubles[i], actualDoubles[i]);
+    }
+    TEST_CHECK(same);
+}
+
+static void testClamp(const CurveKernels::Table &kernels, const CurveKernels::Table &scalar, std::mt19937 &rng) {
+    const auto x = testInputs(rng, -200.0, 200.0);
+    const std::pair<double, double> bounds[] = {{0.0, 127.0}, {-1.0, 1.0}, {5.0, 5.0}, {0.0, 0.0}, {-kInf, kInf}};
+    for (const auto &[lo, hi] : bounds) {
+        std::vector<double> expected(x.size()), actual(x.size());
+        scalar.clamp(x.data(), x.size(), lo, hi, expected.data());
+        kernels.clamp(x.data(), x.size(), lo, hi, actual.data());
+        // In place
+        auto inPlace = x;
+        kernels.clamp(inPlace.data(), inPlace.size(), lo, hi, inPlace.data());
+        bool same = true;
+        for (size_t i = 0; i < x.size(); ++i) {
+            same = same && identical(expected[i], actual[i]) && identical(expected[i], inPlace[i]);
+        }
+        TEST_CHECK(same);
+    }
+
+    // Bounds and NaN, independent of the reference
+    const std::vector<double> special = {kNaN, kInf, -kInf, 200.0, -3.0, 64.5, 0.0, 127.0, -kNaN};
+    std::vector<double> out(special.size());
+    kernels.clamp(special.data(), special.size(), 0.0, 127.0, out.data());
+    TEST_CHECK(std::isnan(out[0]) && std::isnan(out[8]));
+    TEST_CHECK(out[1] == 127.0 && out[2] == 0.0 && out[3] == 127.0 && out[4] == 0.0);
+    TEST_CHECK(out[5] == 64.5 && out[6] == 0.0 && out[7] == 127.0);
+}
+
+int main() {
+    const auto *scalar = CurveKernels::tableFor(CurveKernels::Scalar);
+    TEST_CHECK(scalar != nullptr);
+    if (!scalar) {
+        return testResult();
+    }
+    // The scalar table is checked too, against the properties that do not need a reference.
+    for (const auto isa : {CurveKernels::Scalar, CurveKernels::SSE2, CurveKernels::AVX2,
+                           CurveKernels::AVX512, CurveKernels::NEON}) {
+        const auto *kernels = CurveKernels::tableFor(isa);
+        if (!kernels) {
+            std::cout << CurveKernels::isaName(isa) << ": not supported, skipped\n";
+            continue;
+        }
+        std::cout << CurveKernels::isaName(isa) << ": checked\n";
+        TEST_CHECK(kernels->isa == isa);
+        std::mt19937 rng(49);
+        testExp2Affine(*kernels, *scalar, rng);
+        testAddScaled(*kernels, *scalar, rng);
+        testAccumulateScaled(*kernels, *scalar, rng);
+        testConversions(*kernels, *scalar, rng);
+        testClamp(*kernels, *scalar, rng);
+    }
+    TEST_CHECK(CurveKernels::tableFor(CurveKernels::table().isa) == &CurveKernels::table());
+    return testResult();
+}
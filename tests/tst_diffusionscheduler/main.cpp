@@ -0,0 +1,180 @@
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <random>
+
+#include "inference/DiffusionScheduler_p.h"
+
+#include "TestCommon.h"
+
+using namespace dsonnxinfer;
+
+constexpr double kInf = std::numeric_limits<double>::infinity();
+
+// Runtime of the cost model, with the frames in thousands
+static double modelSeconds(const DiffusionScheduler::Coefficients &theta, int64_t frames, double iterations) {
+    const double kiloFrames = static_cast<double>(frames) / 1000.0;
+    return theta[0] + theta[1] * kiloFrames + theta[2] * kiloFrames * iterations;
+}
+
+static void testIterations() {
+    // DDPM steps are rounded to a divisor of 1000.
+    TEST_CHECK(DiffusionScheduler::iterations(20, 1.0f, false, false) == 20.0);
+    TEST_CHECK(DiffusionScheduler::iterations(3, 1.0f, false, false) == 1000.0 / 250.0);
+    TEST_CHECK(DiffusionScheduler::iterations(20, 0.5f, false, true) == 10.0);
+    // The ODE solver of a continuous acceleration model takes the steps at any depth.
+    TEST_CHECK(DiffusionScheduler::iterations(20, 0.5f, true, true) == 20.0);
+    TEST_CHECK(DiffusionScheduler::iterations(20, 0.5f, true, false) == 20.0);
+    TEST_CHECK(DiffusionScheduler::iterations(0, 1.0f, true, false) == 1.0);
+}
+
+static void testUntrained() {
+    DiffusionScheduler scheduler;
+    const auto plan = scheduler.plan(2000, 0.001, 20, 0.6f, true, true);
+    TEST_CHECK(plan.info.steps == 20 && plan.info.depth == 0.6f);
+    TEST_CHECK(plan.info.expectedSeconds == -1.0 && !plan.info.adapted);
+}
+
+static void testStepSelection() {
+    DiffusionScheduler scheduler;
+    const DiffusionScheduler::Coefficients theta = {0.01, 0.02, 0.001};
+    scheduler.setCoefficients(theta);
+
+    // 2000 frames at 20 steps are expected to take 0.01 + 0.04 + 0.04 seconds.
+    const auto relaxed = scheduler.plan(2000, 1.0, 20, 1.0f, true, false);
+    TEST_CHECK(relaxed.info.steps == 20 && !relaxed.info.adapted);
+    TEST_CHECK(std::abs(relaxed.info.expectedSeconds - 0.09) < 1e-12);
+    const auto unlimited = scheduler.plan(2000, kInf, 20, 1.0f, true, false);
+    TEST_CHECK(unlimited.info.steps == 20 && !unlimited.info.adapted);
+
+    // 0.05 + 0.002 * steps <= 0.07 allows 10 steps.
+    const auto tight = scheduler.plan(2000, 0.07, 20, 1.0f, true, false);
+    TEST_CHECK(tight.info.steps == 10 && tight.info.depth == 1.0f && tight.info.adapted);
+    TEST_CHECK(std::abs(tight.info.expectedSeconds - 0.07) < 1e-12);
+    TEST_CHECK(tight.iterations == 10.0);
+
+    // At one step, the depth of a continuous acceleration model saves nothing and is kept.
+    const auto flow = scheduler.plan(2000, 0.01, 20, 0.8f, true, true);
+    TEST_CHECK(flow.info.steps == 1 && flow.info.depth == 0.8f);
+
+    // The steps are not raised above the configured value.
+    const auto few = scheduler.plan(2000, 0.07, 5, 1.0f, true, false);
+    TEST_CHECK(few.info.steps == 5 && !few.info.adapted);
+}
+
+static void testDepthSelection() {
+    DiffusionScheduler scheduler;
+    const DiffusionScheduler::Coefficients theta = {0.01, 0.02, 0.01};
+    scheduler.setCoefficients(theta);
+
+    // A DDPM model at one step runs one iteration times the depth: 0.05 + 0.02 * depth.
+    const auto plan = scheduler.plan(2000, 0.06, 20, 1.0f, false, true);
+    TEST_CHECK(plan.info.steps == 1 && plan.info.adapted);
+    TEST_CHECK(std::abs(plan.info.depth - 0.5f) < 1e-6f);
+    TEST_CHECK(std::abs(plan.info.expectedSeconds - 0.06) < 1e-8);
+    TEST_CHECK(plan.iterations == DiffusionScheduler::iterations(1, plan.info.depth, false, true));
+
+    // The depth is not lowered below a tenth of the configured depth.
+    const auto floor = scheduler.plan(2000, 0.0, 20, 0.8f, false, true);
+    TEST_CHECK(floor.info.steps == 1 && std::abs(floor.info.depth - 0.08f) < 1e-6f);
+
+    // Without a variable depth, only the steps change.
+    const auto fixed = scheduler.plan(2000, 0.0, 20, 0.8f, false, false);
+    TEST_CHECK(fixed.info.steps == 1 && fixed.info.depth == 0.8f);
+}
+
+static void testConvergence() {
+    DiffusionScheduler scheduler;
+    std::mt19937 rng(50);
+    std::uniform_int_distribution<int64_t> frames(200, 6000);
+    std::uniform_int_distribution<int64_t> steps(1, 50);
+
+    const auto train = [&](const DiffusionScheduler::Coefficients &truth, int runs, double noise) {
+        std::normal_distribution<double> relative(0.0, noise);
+        for (int i = 0; i < runs; ++i) {
+            const auto n = frames(rng);
+            const double iterations = DiffusionScheduler::iterations(steps(rng), 1.0f, true, false);
+            const double seconds = modelSeconds(truth, n, iterations) * (1.0 + (noise > 0 ? relative(rng) : 0.0));
+            scheduler.observe(n, iterations, seconds);
+        }
+    };
+    const auto closeTo = [&](const DiffusionScheduler::Coefficients &truth, double tolerance) {
+        const auto theta = scheduler.coefficients();
+        bool result = true;
+        for (size_t i = 0; i < theta.size(); ++i) {
+            result = result && std::abs(theta[i] - truth[i]) <= tolerance * std::abs(truth[i]);
+        }
+        return result;
+    };
+
+    // Exact runtimes are fitted to 0.1%, short of exact only through the prior.
+    const DiffusionScheduler::Coefficients first = {0.02, 0.05, 0.003};
+    train(first, 50, 0.0);
+    TEST_CHECK(closeTo(first, 1e-3));
+
+    // Older runs are forgotten, so the fit follows a slower machine.
+    const DiffusionScheduler::Coefficients second = {0.04, 0.1, 0.006};
+    train(second, 200, 0.0);
+    TEST_CHECK(closeTo(second, 1e-3));
+
+    // With noise, the prediction of typical runs stays close.
+    train(second, 500, 0.02);
+    const auto theta = scheduler.coefficients();
+    const double predicted = modelSeconds(theta, 3000, 25.0);
+    const double actual = modelSeconds(second, 3000, 25.0);
+    TEST_CHECK(std::abs(predicted - actual) < 0.05 * actual);
+
+    scheduler.reset();
+    TEST_CHECK(scheduler.coefficients() == DiffusionScheduler::Coefficients{});
+    TEST_CHECK(scheduler.plan(2000, 0.001, 20, 1.0f, true, false).info.expectedSeconds == -1.0);
+}
+
+static void testFinish() {
+    DiffusionScheduler scheduler;
+    auto plan = scheduler.plan(1000, kInf, 8, 1.0f, true, false);
+    const auto info = scheduler.finish(plan, false);
+    TEST_CHECK(info.steps == 8 && info.elapsedSeconds >= 0.0);
+    TEST_CHECK(scheduler.lastRun().steps == 8);
+    // Unobserved runs do not train the model.
+    TEST_CHECK(scheduler.plan(1000, kInf, 8, 1.0f, true, false).info.expectedSeconds == -1.0);
+    scheduler.finish(plan, true);
+    TEST_CHECK(scheduler.plan(1000, kInf, 8, 1.0f, true, false).info.expectedSeconds != -1.0);
+}
+
+static void testChunks() {
+    TEST_CHECK(DiffusionScheduler::share(kInf, 100, 400) == kInf);
+    TEST_CHECK(DiffusionScheduler::share(2.0, 100, 400) == 0.5);
+    TEST_CHECK(DiffusionScheduler::share(2.0, 400, 400) == 2.0);
+    TEST_CHECK(DiffusionScheduler::share(-1.0, 100, 400) == -1.0);
+    TEST_CHECK(DiffusionScheduler::share(2.0, 0, 400) == 0.0);
+
+    DiffusionRunInfo a;
+    a.steps = 20;
+    a.depth = 1.0f;
+    a.expectedSeconds = 0.5;
+    a.elapsedSeconds = 0.4;
+    DiffusionRunInfo b;
+    b.steps = 12;
+    b.depth = 0.7f;
+    b.expectedSeconds = 0.3;
+    b.elapsedSeconds = 0.35;
+    b.adapted = true;
+    TEST_CHECK(DiffusionScheduler::merge({}, a).steps == 20);
+    const auto merged = DiffusionScheduler::merge(a, b);
+    TEST_CHECK(merged.steps == 12 && merged.depth == 0.7f && merged.adapted);
+    TEST_CHECK(std::abs(merged.expectedSeconds - 0.8) < 1e-12);
+    TEST_CHECK(std::abs(merged.elapsedSeconds - 0.75) < 1e-12);
+    b.expectedSeconds = -1.0;
+    TEST_CHECK(DiffusionScheduler::merge(a, b).expectedSeconds == -1.0);
+}
+
+int main() {
+    testIterations();
+    testUntrained();
+    testStepSelection();
+    testDepthSelection();
+    testConvergence();
+    testFinish();
+    testChunks();
+    return testResult();
+}
@@ -0,0 +1,124 @@
+#include <cmath>
+#include <vector>
+
+#include <dsonnxinfer/DsConfig.h>
+#include <dsonnxinfer/DsProject.h>
+
+#include "inference/CompactSegment_p.h"
+#include "inference/InferenceCommon_p.h"
+#include "inference/InputPlan_p.h"
+#include "inference/MelCache_p.h"
+
+#include "TestCommon.h"
+
+using namespace dsonnxinfer;
+
+constexpr double kFrameLength = 0.01;
+
+// One note of half a second at `pitch`, with a constant tone shift in cents.
+static Segment makeSegment(double pitch, double toneShift) {
+    Segment segment;
+    Word word;
+    word.phones.push_back({"a", "", 0.0});
+    Note note;
+    note.key = 60;
+    note.duration = 0.5;
+    word.notes.push_back(note);
+    segment.words.push_back(std::move(word));
+
+    segment.parameters["pitch"] = {"pitch", SampleCurve(std::vector<double>(60, pitch), kFrameLength)};
+    segment.parameters["tone_shift"] = {"tone_shift", SampleCurve(std::vector<double>(60, toneShift), kFrameLength)};
+    return segment;
+}
+
+struct Preprocessed {
+    uint64_t key = 0;
+    std::vector<float> modelF0;
+    std::vector<float> originalF0;
+};
+
+static std::vector<float> values(const flowonnx::Tensor &tensor) {
+    const float *buffer;
+    const auto size = tensor.getDataBuffer<float>(&buffer);
+    return {buffer, buffer + size};
+}
+
+static Preprocessed preprocess(const Segment &dsSegment, bool applyToneShift) {
+    DsConfig dsConfig;
+    dsConfig.features = kfParamGender;
+    const auto plan = InputPlan::forAcoustic(dsConfig);
+    const CompactSegment segment(dsSegment, nullptr);
+
+    Preprocessed result;
+    flowonnx::Tensor originalF0;
+    Status status;
+    auto inputs = acousticPreprocess(segment, plan, kFrameLength, 0, applyToneShift, &originalF0, &status);
+    TEST_CHECK(status.isOk());
+    TEST_CHECK(inputs.count("f0") == 1);
+    if (inputs.count("f0") == 0) {
+        return result;
+    }
+    result.key = fingerprintInputs(inputs);
+    result.modelF0 = values(inputs["f0"]);
+    result.originalF0 = values(originalF0);
+    return result;
+}
+
+// The tone shift moves the f0 of the acoustic model, and the vocoder keeps the original
+// pitch. An edit of the tone shift therefore changes the key and misses the cache.
+static void testToneShiftMissesCache() {
+    const auto original = preprocess(makeSegment(60.0, 0.0), true);
+    const auto shifted = preprocess(makeSegment(60.0, 100.0), true);
+    TEST_CHECK(original.key != shifted.key);
+    TEST_CHECK(shifted.originalF0 == original.originalF0);
+    TEST_CHECK(original.modelF0 == original.originalF0);
+
+    TEST_CHECK(!shifted.modelF0.empty() && shifted.modelF0.size() == shifted.originalF0.size());
+    const double semitone = std::exp2(1.0 / 12.0);
+    for (size_t i = 0; i < shifted.modelF0.size() && i < shifted.originalF0.size(); ++i) {
+        TEST_CHECK(std::abs(shifted.modelF0[i] / shifted.originalF0[i] - semitone) < 1e-4);
+    }
+
+    MelCache cache(size_t{1} << 20);
+    flowonnx::Tensor mel;
+    mel.data.resize(16);
+    mel.shape = {1, 4};
+    cache.insert(original.key, mel);
+    flowonnx::Tensor found;
+    TEST_CHECK(cache.find(original.key, &found));
+    TEST_CHECK(found.data.size() == mel.data.size());
+    TEST_CHECK(!cache.find(shifted.key, &found));
+}
+
+// Without a pitch controllable vocoder, the tone shift is ignored and the cache hits.
+static void testToneShiftIgnored() {
+    const auto original = preprocess(makeSegment(60.0, 0.0), false);
+    const auto shifted = preprocess(makeSegment(60.0, 100.0), false);
+    TEST_CHECK(shifted.originalF0 == shifted.modelF0);
+    TEST_CHECK(original.key == shifted.key);
+}
+
+static void testPitchEditMissesCache() {
+    const auto original = preprocess(makeSegment(60.0, 0.0), true);
+    const auto edited = preprocess(makeSegment(62.0, 0.0), true);
+    TEST_CHECK(original.key != edited.key);
+}
+
+// The cache is opt-in.
+static void testDisabledByDefault() {
+    MelCache cache;
+    TEST_CHECK(cache.capacity() == 0);
+    flowonnx::Tensor mel;
+    mel.data.resize(16);
+    cache.insert(1, mel);
+    flowonnx::Tensor found;
+    TEST_CHECK(!cache.find(1, &found));
+}
+
+int main() {
+    testToneShiftMissesCache();
+    testToneShiftIgnored();
+    testPitchEditMissesCache();
+    testDisabledByDefault();
+    return testResult();
+}
@@ -0,0 +1,152 @@
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <memory>
+#include <vector>
+
+#include <dsonnxinfer/Mixdown.h>
+
+#include "TestCommon.h"
+
+using namespace dsonnxinfer;
+
+// At 1000 Hz, so that samples are milliseconds; the crossfade is 10 samples.
+constexpr int kSampleRate = 1000;
+constexpr double kCrossfade = 0.01;
+
+static AudioBuffer constantSegment(double offset, size_t length, float value) {
+    auto samples = std::make_shared<std::vector<float>>(length, value);
+    AudioBuffer buffer;
+    buffer.samples = samples->data();
+    buffer.sampleCount = length;
+    buffer.sampleRate = kSampleRate;
+    buffer.offset = offset;
+    buffer.storage = std::move(samples);
+    return buffer;
+}
+
+static std::vector<float> renderAll(const Mixdown &mixdown) {
+    std::vector<float> out(static_cast<size_t>(mixdown.sampleCount()));
+    mixdown.renderTo(out.data(), out.size(), nullptr);
+    return out;
+}
+
+static bool near(float a, float b) {
+    return std::abs(a - b) < 1e-5f;
+}
+
+static bool between(float value, float a, float b) {
+    return value >= (std::min)(a, b) - 1e-5f && value <= (std::max)(a, b) + 1e-5f;
+}
+
+class MemorySink : public AudioSink {
+public:
+    int sampleRate() const override {
+        return kSampleRate;
+    }
+
+    bool write(const float *samples, size_t count, Status *) override {
+        data.insert(data.end(), samples, samples + count);
+        return true;
+    }
+
+    bool close(Status *) override {
+        return true;
+    }
+
+    std::vector<float> data;
+};
+
+// A segment that lies within another one replaces it only in its span.
+static void testContainedSegment() {
+    Mixdown mixdown(kSampleRate, kCrossfade);
+    TEST_CHECK(mixdown.addSegment(constantSegment(0.0, 1000, 1.0f), nullptr));
+    TEST_CHECK(mixdown.addSegment(constantSegment(0.4, 200, 2.0f), nullptr));
+    const auto out = renderAll(mixdown);
+    TEST_CHECK(out.size() == 1000);
+
+    for (int t = 0; t < 400; ++t) {
+        TEST_CHECK(near(out[t], 1.0f));
+    }
+    for (int t = 400; t < 410; ++t) {
+        TEST_CHECK(between(out[t], 1.0f, 2.0f));
+    }
+    for (int t = 410; t < 590; ++t) {
+        TEST_CHECK(near(out[t], 2.0f));
+    }
+    for (int t = 590; t < 600; ++t) {
+        TEST_CHECK(between(out[t], 1.0f, 2.0f));
+    }
+    // The outer segment is back at full level after the inner one.
+    for (int t = 600; t < 1000; ++t) {
+        TEST_CHECK(near(out[t], 1.0f));
+    }
+}
+
+// Segments that overlap without being neighbors in the list are crossfaded too.
+static void testNonAdjacentOverlap() {
+    Mixdown mixdown(kSampleRate, kCrossfade);
+    TEST_CHECK(mixdown.addSegment(constantSegment(0.0, 600, 1.0f), nullptr));
+    TEST_CHECK(mixdown.addSegment(constantSegment(0.5, 400, 3.0f), nullptr));
+    TEST_CHECK(mixdown.addSegment(constantSegment(0.1, 200, 2.0f), nullptr));
+    const auto out = renderAll(mixdown);
+    TEST_CHECK(out.size() == 900);
+
+    for (int t = 0; t < 100; ++t) {
+        TEST_CHECK(near(out[t], 1.0f));
+    }
+    for (int t = 110; t < 290; ++t) {
+        TEST_CHECK(near(out[t], 2.0f));
+    }
+    for (int t = 300; t < 545; ++t) {
+        TEST_CHECK(near(out[t], 1.0f));
+    }
+    // The crossfade of the first and the last segment is in the middle of [500, 600).
+    for (int t = 545; t < 555; ++t) {
+        TEST_CHECK(between(out[t], 1.0f, 3.0f) && !near(out[t], 1.0f) && !near(out[t], 3.0f));
+    }
+    for (int t = 555; t < 900; ++t) {
+        TEST_CHECK(near(out[t], 3.0f));
+    }
+}
+
+// Gains of a crossfade sum up to one, and segments without overlaps are not attenuated.
+static void testCrossfadeGains() {
+    Mixdown mixdown(kSampleRate, kCrossfade);
+    TEST_CHECK(mixdown.addSegment(constantSegment(0.0, 300, 1.0f), nullptr));
+    TEST_CHECK(mixdown.addSegment(constantSegment(0.2, 300, 1.0f), nullptr));
+    TEST_CHECK(mixdown.addSegment(constantSegment(0.6, 100, 1.0f), nullptr));
+    const auto out = renderAll(mixdown);
+    TEST_CHECK(out.size() == 700);
+    for (int t = 0; t < 700; ++t) {
+        TEST_CHECK(near(out[t], t < 500 || t >= 600 ? 1.0f : 0.0f));
+    }
+}
+
+// Streaming while segments are added gives the same song as rendering at once.
+static void testFlush() {
+    Mixdown reference(kSampleRate, kCrossfade);
+    Mixdown streamed(kSampleRate, kCrossfade);
+    MemorySink sink;
+    const double offsets[] = {0.0, 0.05, 0.2, 0.25, 0.9};
+    for (size_t i = 0; i < std::size(offsets); ++i) {
+        const auto value = static_cast<float>(i + 1);
+        TEST_CHECK(reference.addSegment(constantSegment(offsets[i], 300, value), nullptr));
+        TEST_CHECK(streamed.addSegment(constantSegment(offsets[i], 300, value), nullptr));
+        TEST_CHECK(streamed.flush(sink, false, nullptr));
+    }
+    TEST_CHECK(streamed.flush(sink, true, nullptr));
+    const auto out = renderAll(reference);
+    TEST_CHECK(sink.data.size() == out.size());
+    for (size_t t = 0; t < out.size() && t < sink.data.size(); ++t) {
+        TEST_CHECK(near(sink.data[t], out[t]));
+    }
+}
+
+int main() {
+    testContainedSegment();
+    testNonAdjacentOverlap();
+    testCrossfadeGains();
+    testFlush();
+    return testResult();
+}
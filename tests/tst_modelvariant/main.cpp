@@ -0,0 +1,91 @@
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+#include "inference/ModelVariant_p.h"
+
+#include "TestCommon.h"
+
+using namespace dsonnxinfer;
+
+static flowonnx::Tensor floatTensor(const std::vector<float> &values) {
+    const int64_t shape = static_cast<int64_t>(values.size());
+    return flowonnx::Tensor::create(values.data(), values.size(), &shape, 1);
+}
+
+// Float16 outputs come as float tensors with two bytes per element.
+static flowonnx::Tensor halfTensor(const std::vector<uint16_t> &halves) {
+    flowonnx::Tensor tensor;
+    tensor.type = flowonnx::Tensor::Float;
+    tensor.shape = {static_cast<int64_t>(halves.size())};
+    tensor.data.resize(halves.size() * sizeof(uint16_t));
+    std::memcpy(tensor.data.data(), halves.data(), tensor.data.size());
+    return tensor;
+}
+
+static void testFloatOutputs() {
+    InferMap reference{{"mel", floatTensor({1.0f, -2.0f, 3.0f})}};
+    TEST_CHECK(relativeOutputError(reference, reference) == 0.0);
+
+    InferMap output{{"mel", floatTensor({1.0f, -2.0f, 3.3f})}};
+    const double expected = 0.3 / std::sqrt(14.0);
+    TEST_CHECK(std::abs(relativeOutputError(reference, output) - expected) < 1e-6);
+
+    // Missing or resized outputs cannot be compared.
+    TEST_CHECK(std::isinf(relativeOutputError(reference, InferMap{})));
+    InferMap shorter{{"mel", floatTensor({1.0f, -2.0f})}};
+    TEST_CHECK(std::isinf(relativeOutputError(reference, shorter)));
+}
+
+static void testHalfOutputs() {
+    // 1.0, -2.0, 0.5 and the smallest subnormal
+    InferMap reference{{"mel", floatTensor({1.0f, -2.0f, 0.5f, std::ldexp(1.0f, -24)})}};
+    InferMap exact{{"mel", halfTensor({0x3c00, 0xc000, 0x3800, 0x0001})}};
+    TEST_CHECK(relativeOutputError(reference, exact) == 0.0);
+
+    // 1.0009765625 is the next half after 1.0.
+    InferMap rounded{{"mel", halfTensor({0x3c01, 0xc000, 0x3800, 0x0001})}};
+    const double error = relativeOutputError(reference, rounded);
+    TEST_CHECK(error > 0.0 && error < 1e-3);
+
+    InferMap infinite{{"mel", halfTensor({0x7c00, 0xc000, 0x3800, 0x0001})}};
+    TEST_CHECK(std::isinf(relativeOutputError(reference, infinite)));
+}
+
+static void testNonFloatOutputsIgnored() {
+    const int64_t values[] = {1, 2, 3};
+    const int64_t shape = 3;
+    auto durations = flowonnx::Tensor::create(values, 3, &shape, 1);
+    durations.type = flowonnx::Tensor::Int64;
+    InferMap reference{{"mel", floatTensor({1.0f})}, {"ph_dur", durations}};
+    InferMap output{{"mel", floatTensor({1.0f})}};
+    TEST_CHECK(relativeOutputError(reference, output) == 0.0);
+}
+
+static void testSelectModelVariant() {
+    const std::filesystem::path reference = "model.onnx";
+    const ModelVariants variants{{MP_Float16, "model.fp16.onnx"}};
+
+    InferenceOptions options;
+    TEST_CHECK(selectModelVariant(reference, variants, options) == reference);
+
+    options.precisionPolicy = PP_Explicit;
+    options.precision = MP_Float16;
+    TEST_CHECK(selectModelVariant(reference, variants, options) == "model.fp16.onnx");
+    options.precision = MP_Int8;
+    TEST_CHECK(selectModelVariant(reference, variants, options) == reference);
+
+    options.precisionPolicy = PP_Fastest;
+    TEST_CHECK(selectModelVariant(reference, variants, options) == "model.fp16.onnx");
+    TEST_CHECK(selectModelVariant(reference, {}, options) == reference);
+}
+
+int main() {
+    testFloatOutputs();
+    testHalfOutputs();
+    testNonFloatOutputsIgnored();
+    testSelectModelVariant();
+    return testResult();
+}
@@ -0,0 +1,122 @@
+#include <cmath>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <dsonnxinfer/DsProject.h>
+#include <dsonnxinfer/SampleCurve.h>
+
+#include "TestCommon.h"
+
+using namespace dsonnxinfer;
+
+constexpr double kTimestep = 0.005;
+
+// The largest deviation of `compact` from the samples of `dense`, at the sample times.
+static double maxDeviation(const SampleCurve &dense, const SampleCurve &compact) {
+    double result = 0.0;
+    for (size_t i = 0; i < dense.samples.size(); ++i) {
+        const double t = static_cast<double>(i) * dense.timestep;
+        result = (std::max)(result, std::abs(compact.valueAt(t) - dense.samples[i]));
+    }
+    return result;
+}
+
+static void testRunsAndRamps() {
+    const SampleCurve flat(std::vector<double>(200, 5.0), kTimestep);
+    const auto flatCompact = flat.compacted();
+    TEST_CHECK(flatCompact.isPiecewise() && flatCompact.points.size() == 2);
+    TEST_CHECK(flatCompact.timestep == kTimestep);
+    TEST_CHECK(maxDeviation(flat, flatCompact) == 0.0);
+
+    // Three ramps of 100 samples each: 0 up to 50, flat, down to 0
+    std::vector<double> samples;
+    for (int i = 0; i < 100; ++i) {
+        samples.push_back(0.5 * i);
+    }
+    samples.insert(samples.end(), 100, 50.0);
+    for (int i = 0; i < 100; ++i) {
+        samples.push_back(50.0 - 0.5 * i);
+    }
+    const SampleCurve ramps(samples, kTimestep);
+    const auto rampsCompact = ramps.compacted();
+    TEST_CHECK(rampsCompact.isPiecewise() && rampsCompact.points.size() <= 5);
+    TEST_CHECK(maxDeviation(ramps, rampsCompact) < 1e-9);
+    TEST_CHECK(rampsCompact.sampleCount() == ramps.sampleCount());
+}
+
+// Within the tolerance, a smooth curve becomes breakpoints that stay within it.
+static void testTolerance() {
+    std::vector<double> samples;
+    for (int i = 0; i < 1000; ++i) {
+        samples.push_back(60.0 + 2.0 * std::sin(i * 0.01));
+    }
+    const SampleCurve curve(samples, kTimestep);
+    for (const double tolerance : {0.001, 0.01, 0.1}) {
+        const auto compact = curve.compacted(tolerance);
+        TEST_CHECK(compact.isPiecewise());
+        TEST_CHECK(2 * compact.points.size() < samples.size());
+        TEST_CHECK(maxDeviation(curve, compact) <= tolerance + 1e-9);
+    }
+}
+
+// Curves that would not get smaller are returned unchanged.
+static void testUnchanged() {
+    std::mt19937 rng(48);
+    std::uniform_real_distribution<double> noise(-1.0, 1.0);
+    std::vector<double> samples;
+    for (int i = 0; i < 200; ++i) {
+        samples.push_back(noise(rng));
+    }
+    const SampleCurve noisy(samples, kTimestep);
+    const auto noisyCompact = noisy.compacted();
+    TEST_CHECK(!noisyCompact.isPiecewise() && noisyCompact.samples == samples);
+
+    const SampleCurve pair({1.0, 2.0}, kTimestep);
+    TEST_CHECK(!pair.compacted().isPiecewise());
+
+    const SampleCurve untimed(std::vector<double>(10, 1.0), 0.0);
+    TEST_CHECK(!untimed.compacted().isPiecewise());
+
+    const auto piecewise = SampleCurve::fromPoints({{0.0, 1.0}, {1.0, 2.0}}, kTimestep);
+    const auto piecewiseCompact = piecewise.compacted();
+    TEST_CHECK(piecewiseCompact.points.size() == 2 && piecewiseCompact.points[1].value == 2.0);
+}
+
+// Breakpoints are sorted by time on load; a step keeps the order of its two breakpoints.
+static void testLoadSortsPoints() {
+    const std::string json = R"({
+        "offset": 0,
+        "words": [],
+        "parameters": [{
+            "tag": "pitch",
+            "dynamic": true,
+            "interval": 0.01,
+            "points": [[0.5, 62], [0.0, 60], [0.2, 61], [0.2, 64], [0.1, 60]]
+        }]
+    })";
+    Status status;
+    const auto segment = Segment::fromJson(json, &status);
+    TEST_CHECK(status.isOk());
+    const auto it = segment.parameters.find("pitch");
+    TEST_CHECK(it != segment.parameters.end());
+    if (it == segment.parameters.end()) {
+        return;
+    }
+    const auto &points = it->second.sample_curve.points;
+    TEST_CHECK(points.size() == 5);
+    for (size_t i = 1; i < points.size(); ++i) {
+        TEST_CHECK(points[i - 1].time <= points[i].time);
+    }
+    TEST_CHECK(points[2].value == 61.0 && points[3].value == 64.0);
+    TEST_CHECK(it->second.sample_curve.valueAt(0.2) == 64.0);
+    TEST_CHECK(it->second.sample_curve.valueAt(0.6) == 62.0);
+}
+
+int main() {
+    testRunsAndRamps();
+    testTolerance();
+    testUnchanged();
+    testLoadSortsPoints();
+    return testResult();
+}
@@ -0,0 +1,139 @@
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <dsonnxinfer/StageTracker.h>
+#include <dsonnxinfer/Voicebank.h>
+
+#include "TestCommon.h"
+
+using namespace dsonnxinfer;
+namespace fs = std::filesystem;
+
+// A voice bank of an acoustic model taking `gender`, without a vocoder config.
+static fs::path writeVoicebank() {
+    const auto dir = fs::temp_directory_path() / "dsonnxinfer_tst_stagetracker";
+    fs::create_directories(dir);
+    std::ofstream(dir / "dsconfig.yaml") << "phonemes: phonemes.txt\n"
+                                            "acoustic: acoustic.onnx\n"
+                                            "use_key_shift_embed: true\n";
+    std::ofstream(dir / "phonemes.txt") << "SP\nAP\na\n";
+    return dir;
+}
+
+static Segment makeSegment() {
+    Segment segment;
+    Word word;
+    word.phones.push_back({"a", "", 0.0});
+    Note note;
+    note.key = 60;
+    note.duration = 0.5;
+    word.notes.push_back(note);
+    segment.words.push_back(std::move(word));
+    for (const char *name : {"pitch", "gender", "energy", "tone_shift"}) {
+        segment.parameters[name] = {name, SampleCurve(std::vector<double>(50, 0.0), 0.01)};
+    }
+    return segment;
+}
+
+static AudioBuffer someWaveform() {
+    auto samples = std::make_shared<std::vector<float>>(16, 0.0f);
+    AudioBuffer buffer;
+    buffer.samples = samples->data();
+    buffer.sampleCount = samples->size();
+    buffer.sampleRate = 44100;
+    buffer.storage = std::move(samples);
+    return buffer;
+}
+
+// Runs the acoustic stage if the tracker asks for it, and reports whether it ran.
+static bool runAcoustic(StageTracker &tracker, Segment &segment, uint64_t settings = 0) {
+    if (!tracker.prepare(VS_Acoustic, segment, settings)) {
+        return false;
+    }
+    tracker.commit(VS_Acoustic, segment);
+    tracker.setWaveform(someWaveform());
+    return true;
+}
+
+static void testAcousticInputs(const Voicebank &voicebank) {
+    StageTracker tracker(voicebank);
+    auto segment = makeSegment();
+    TEST_CHECK(runAcoustic(tracker, segment));
+    TEST_CHECK(!runAcoustic(tracker, segment));
+
+    // `gender` is an input of the acoustic model of this voice bank.
+    segment.parameters["gender"].sample_curve.samples[10] = 0.5;
+    TEST_CHECK(runAcoustic(tracker, segment));
+
+    // The acoustic model does not take `energy`, and without a pitch controllable
+    // vocoder, `tone_shift` is not read either.
+    segment.parameters["energy"].sample_curve.samples[10] = 0.5;
+    segment.parameters["tone_shift"].sample_curve.samples[10] = 100.0;
+    TEST_CHECK(!runAcoustic(tracker, segment));
+
+    segment.parameters["pitch"].sample_curve.samples[10] = 62.0;
+    TEST_CHECK(runAcoustic(tracker, segment));
+
+    segment.words[0].notes[0].key = 62;
+    TEST_CHECK(runAcoustic(tracker, segment));
+}
+
+static void testSettings(const Voicebank &voicebank) {
+    StageTracker tracker(voicebank);
+    auto segment = makeSegment();
+    TEST_CHECK(runAcoustic(tracker, segment, 1));
+    TEST_CHECK(!runAcoustic(tracker, segment, 1));
+    // E.g. other steps or depth of the acoustic inference object
+    TEST_CHECK(runAcoustic(tracker, segment, 2));
+    TEST_CHECK(!runAcoustic(tracker, segment, 2));
+}
+
+static void testReset(const Voicebank &voicebank) {
+    StageTracker tracker(voicebank);
+    auto segment = makeSegment();
+    TEST_CHECK(runAcoustic(tracker, segment));
+    tracker.reset();
+    TEST_CHECK(runAcoustic(tracker, segment));
+}
+
+// A predicted parameter edited by hand is kept, and restored if the segment is rebuilt
+// without it.
+static void testOwnOutputs(const Voicebank &voicebank) {
+    StageTracker tracker(voicebank);
+    auto segment = makeSegment();
+    segment.parameters.erase("pitch");
+    TEST_CHECK(tracker.prepare(VS_Pitch, segment));
+    segment.parameters["pitch"] = {"pitch", SampleCurve(std::vector<double>(50, 60.0), 0.01)};
+    tracker.commit(VS_Pitch, segment);
+
+    segment.parameters["pitch"].sample_curve.samples[5] = 61.0;
+    TEST_CHECK(!tracker.prepare(VS_Pitch, segment));
+    TEST_CHECK(segment.parameters["pitch"].sample_curve.samples[5] == 61.0);
+
+    auto rebuilt = makeSegment();
+    rebuilt.parameters.erase("pitch");
+    TEST_CHECK(!tracker.prepare(VS_Pitch, rebuilt));
+    TEST_CHECK(rebuilt.parameters.count("pitch") == 1 &&
+               rebuilt.parameters["pitch"].sample_curve.samples[0] == 60.0);
+
+    segment.parameters["pitch"].retake_end = 10;
+    TEST_CHECK(tracker.prepare(VS_Pitch, segment));
+}
+
+int main() {
+    Voicebank voicebank;
+    const auto status = voicebank.load(writeVoicebank());
+    TEST_CHECK(status.isOk());
+    if (!status.isOk()) {
+        std::cout << status.msg << '\n';
+        return testResult();
+    }
+    testAcousticInputs(voicebank);
+    testSettings(voicebank);
+    testReset(voicebank);
+    testOwnOutputs(voicebank);
+    return testResult();
+}